@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avbackend.h"
+#include "avdpxbackend.h"
+#include "avpatternbackend.h"
+#include "avsequencebackend.h"
+#include "avy4mbackend.h"
+
+#if defined(Q_OS_MACOS)
+#include "avfoundationbackend.h"
+#endif
+
+#include <QFileInfo>
+#include <QMutex>
+
+class AVBackendRegistry
+{
+    public:
+        AVBackendRegistry();
+        struct Entry
+        {
+            QString name;
+            QList<QString> extensions;
+            AVBackend::Factory factory;
+        };
+        struct Data
+        {
+            QList<Entry> entries; // in registration order, the first probe wins
+            QMutex mutex;
+        };
+        Data d;
+
+        static AVBackendRegistry* instance();
+};
+
+AVBackendRegistry::AVBackendRegistry()
+{
+    d.entries.append({ "y4m", { "y4m" }, [] { return new AVY4mBackend(); } });
+    d.entries.append({ "pattern", { "pattern" }, [] { return new AVPatternBackend(); } });
+    d.entries.append({ "dpx", { "dpx" }, [] { return new AVDpxBackend(); } });
+    d.entries.append({ "sequence", AVSequenceBackend::formats(), [] { return new AVSequenceBackend(); } });
+#if defined(Q_OS_MACOS)
+    d.entries.append({ "avfoundation",
+                       { "mov", "mp4", "m4v", "avi", "mkv", "flv", "mpg", "mpeg", "3gp", "3g2", "mxf", "wmv" },
+                       [] { return new AVFoundationBackend(); } });
+#endif
+}
+
+AVBackendRegistry*
+AVBackendRegistry::instance()
+{
+    static AVBackendRegistry registry;
+    return &registry;
+}
+
+AVBackend::~AVBackend()
+{
+}
+
+bool
+AVBackend::probe(const QString& filename) const
+{
+    Q_UNUSED(filename);
+    return true;
+}
+
+AVTimestamps
+AVBackend::timestamps()
+{
+    return AVTimestamps();
+}
+
+void
+AVBackend::add(const QString& name, const QList<QString>& extensions, Factory factory)
+{
+    AVBackendRegistry* registry = AVBackendRegistry::instance();
+    QMutexLocker locker(&registry->d.mutex);
+    QList<QString> lower;
+    for (const QString& extension : extensions) {
+        lower.append(extension.toLower());
+    }
+    registry->d.entries.append({ name, lower, factory });
+}
+
+AVBackend*
+AVBackend::create(const QString& filename)
+{
+    AVBackendRegistry* registry = AVBackendRegistry::instance();
+    QList<AVBackendRegistry::Entry> entries;
+    {
+        QMutexLocker locker(&registry->d.mutex);
+        entries = registry->d.entries;
+    }
+    QString extension = QFileInfo(filename).suffix().toLower();
+    for (const AVBackendRegistry::Entry& entry : entries) {
+        if (entry.extensions.contains(extension)) {
+            AVBackend* backend = entry.factory();
+            if (backend->probe(filename)) {
+                return backend;
+            }
+            delete backend;
+        }
+    }
+    return nullptr;
+}
+
+QList<QString>
+AVBackend::names()
+{
+    AVBackendRegistry* registry = AVBackendRegistry::instance();
+    QMutexLocker locker(&registry->d.mutex);
+    QList<QString> names;
+    for (const AVBackendRegistry::Entry& entry : registry->d.entries) {
+        names.append(entry.name);
+    }
+    return names;
+}
+
+QList<QString>
+AVBackend::extensions()
+{
+    AVBackendRegistry* registry = AVBackendRegistry::instance();
+    QMutexLocker locker(&registry->d.mutex);
+    QList<QString> extensions;
+    for (const AVBackendRegistry::Entry& entry : registry->d.entries) {
+        for (const QString& extension : entry.extensions) {
+            if (!extensions.contains(extension)) {
+                extensions.append(extension);
+            }
+        }
+    }
+    return extensions;
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avfps.h"
+#include "avmetadata.h"
+#include "avreader.h"
+#include "avtime.h"
+#include "avtimerange.h"
+#include "avtimestamps.h"
+
+#include <QImage>
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+class AVBackend {
+    public:
+        struct Info
+        {
+            QString title;
+            AVTimeRange range;
+            AVTime start; // timecode of the first frame
+            AVFps fps;
+            bool variable = false; // frames are placed by timestamps, range is in the track timescale
+            AVMetadata metadata;
+        };
+        typedef std::function<AVBackend*()> Factory;
+
+    public:
+        virtual ~AVBackend();
+        virtual QString name() const = 0;
+        virtual bool probe(const QString& filename) const; // cheap header check, true if extension is enough
+        virtual bool open(const QString& filename) = 0;
+        virtual void close() = 0;
+        virtual bool seek(const AVTime& time) = 0; // aligned time, the next read returns it
+        virtual bool read(QImage& image, AVTime& time) = 0;
+        virtual bool drop(AVTime& time) = 0; // skips the next frame without converting it
+        virtual AVTimestamps timestamps(); // variable frame rates only, loaded on first use by the reader
+        virtual AVBackend::Info info() const = 0;
+        virtual AVReader::Error error() const = 0;
+        virtual QString error_message() const = 0;
+
+        static void add(const QString& name, const QList<QString>& extensions, Factory factory);
+        static AVBackend* create(const QString& filename); // by extension and probe, nullptr if unsupported
+        static QList<QString> names();
+        static QList<QString> extensions();
+};
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avcache.h"
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+
+class AVCachePrivate
+{
+    public:
+        AVCachePrivate();
+        bool evict(qint64 bytes);
+        void remove(qsizetype index);
+        bool pinned(qint64 ticks) const;
+        void pin();
+        struct Entry
+        {
+            qint64 ticks;
+            QImage image;
+            qint64 bytes;
+            bool referenced; // second chance, set on every hit
+        };
+        struct Data
+        {
+            QList<Entry> entries; // clock order is slot order, removal moves the last entry in
+            QHash<qint64, qsizetype> index;
+            qsizetype hand = 0;
+            qint64 budget = qint64(1) << 30; // 1 GiB
+            qint64 bytes = 0;
+            qint64 hits = 0;
+            qint64 misses = 0;
+            AVTimeRange pinned;
+            qint32 timescale = 0; // of the keys, taken from the first insert
+            qint64 pinstart = 0; // pinned range in the key timescale
+            qint64 pinend = 0;
+            mutable QMutex mutex;
+        };
+        Data d;
+};
+
+AVCachePrivate::AVCachePrivate()
+{
+}
+
+bool
+AVCachePrivate::pinned(qint64 ticks) const
+{
+    return ticks >= d.pinstart && ticks < d.pinend;
+}
+
+void
+AVCachePrivate::pin()
+{
+    d.pinstart = d.pinend = 0;
+    if (d.pinned.valid() && d.timescale > 0) {
+        AVTimeRange range = AVTimeRange::convert(d.pinned, d.timescale);
+        d.pinstart = range.start().ticks();
+        d.pinend = range.end().ticks();
+    }
+}
+
+void
+AVCachePrivate::remove(qsizetype index)
+{
+    d.bytes -= d.entries[index].bytes;
+    d.index.remove(d.entries[index].ticks);
+    if (index != d.entries.size() - 1) {
+        d.entries[index] = std::move(d.entries.last());
+        d.index[d.entries[index].ticks] = index;
+    }
+    d.entries.removeLast();
+}
+
+bool
+AVCachePrivate::evict(qint64 bytes)
+{
+    // two sweeps clear every referenced bit, after that only pinned frames are passed over
+    qsizetype scanned = 0;
+    while (d.bytes + bytes > d.budget && !d.entries.isEmpty() && scanned < d.entries.size() * 2) {
+        if (d.hand >= d.entries.size()) {
+            d.hand = 0;
+        }
+        Entry& entry = d.entries[d.hand];
+        if (pinned(entry.ticks) || entry.referenced) {
+            entry.referenced = false;
+            d.hand++;
+            scanned++;
+        }
+        else {
+            remove(d.hand); // the moved in entry is looked at next
+        }
+    }
+    return d.bytes + bytes <= d.budget;
+}
+
+AVCache::AVCache()
+: p(new AVCachePrivate())
+{
+}
+
+AVCache::~AVCache()
+{
+}
+
+bool
+AVCache::find(const AVTime& time, QImage& image)
+{
+    QMutexLocker locker(&p->d.mutex);
+    auto it = p->d.index.constFind(time.ticks());
+    if (it == p->d.index.constEnd()) {
+        p->d.misses++;
+        return false;
+    }
+    AVCachePrivate::Entry& entry = p->d.entries[it.value()];
+    entry.referenced = true;
+    image = entry.image;
+    p->d.hits++;
+    return true;
+}
+
+bool
+AVCache::contains(const AVTime& time) const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.index.contains(time.ticks());
+}
+
+bool
+AVCache::insert(const AVTime& time, const QImage& image)
+{
+    QMutexLocker locker(&p->d.mutex);
+    if (image.isNull()) {
+        return false;
+    }
+    auto it = p->d.index.constFind(time.ticks());
+    if (it != p->d.index.constEnd()) {
+        p->remove(it.value());
+    }
+    if (p->d.timescale != time.timescale()) {
+        p->d.timescale = time.timescale();
+        p->pin();
+    }
+    qint64 bytes = image.sizeInBytes();
+    if (!p->evict(bytes)) {
+        return false;
+    }
+    p->d.entries.append({ time.ticks(), image, bytes, false }); // shared, not copied
+    p->d.index.insert(time.ticks(), p->d.entries.size() - 1);
+    p->d.bytes += bytes;
+    return true;
+}
+
+void
+AVCache::clear()
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->d.entries.clear();
+    p->d.index.clear();
+    p->d.hand = 0;
+    p->d.bytes = 0;
+    p->d.timescale = 0;
+    p->pin();
+}
+
+qint64
+AVCache::budget() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.budget;
+}
+
+qint64
+AVCache::bytes() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.bytes;
+}
+
+qint64
+AVCache::count() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.entries.size();
+}
+
+qint64
+AVCache::hits() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.hits;
+}
+
+qint64
+AVCache::misses() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.misses;
+}
+
+qreal
+AVCache::hit_rate() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    qint64 lookups = p->d.hits + p->d.misses;
+    return lookups > 0 ? static_cast<qreal>(p->d.hits) / lookups : 0.0;
+}
+
+AVTimeRange
+AVCache::pinned() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.pinned;
+}
+
+void
+AVCache::set_budget(qint64 bytes)
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->d.budget = qMax(qint64(0), bytes);
+    p->evict(0);
+}
+
+void
+AVCache::set_pinned(const AVTimeRange& range)
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->d.pinned = range;
+    p->pin();
+}
+
+void
+AVCache::reset_stats()
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->d.hits = 0;
+    p->d.misses = 0;
+}
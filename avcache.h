@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avtime.h"
+#include "avtimerange.h"
+
+#include <QImage>
+#include <QScopedPointer>
+
+// decoded frames keyed by exact frame time, all times share the timescale of the open file. frames are
+// evicted with a clock sweep when the byte budget is exceeded, frames in the pinned range are kept.
+// frames are kept by reference, a frame from an AVFramePool goes back to its pool only when evicted,
+// so a pool allocates a buffer per frame until the budget is full and recycles evicted ones after
+class AVCachePrivate;
+class AVCache
+{
+    public:
+        AVCache();
+        ~AVCache();
+        bool find(const AVTime& time, QImage& image); // counted as a hit or a miss
+        bool contains(const AVTime& time) const;
+        bool insert(const AVTime& time, const QImage& image); // false if pinned frames fill the budget
+        void clear();
+        qint64 budget() const;
+        qint64 bytes() const; // resident, shared with frames still held elsewhere
+        qint64 count() const;
+        qint64 hits() const;
+        qint64 misses() const;
+        qreal hit_rate() const;
+        AVTimeRange pinned() const;
+        void set_budget(qint64 bytes); // evicts down to it
+        void set_pinned(const AVTimeRange& range); // invalid range pins nothing
+        void reset_stats();
+
+    private:
+        QScopedPointer<AVCachePrivate> p;
+};
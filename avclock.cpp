@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avclock.h"
+
+#if defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#else
+#include <cerrno>
+#include <time.h>
+#endif
+
+#include <QAtomicInteger>
+#include <QThread>
+
+AVClock::~AVClock()
+{
+}
+
+void
+AVClock::spin_until(quint64 nanos, bool yield)
+{
+    while (now() < nanos) {
+        if (yield) {
+            QThread::yieldCurrentThread();
+        }
+        else {
+            qYieldCpu();
+        }
+    }
+}
+
+AVClock*
+AVClock::system()
+{
+    static AVSystemClock clock;
+    return &clock;
+}
+
+class AVSystemClockPrivate
+{
+    public:
+        AVSystemClockPrivate();
+        struct Data
+        {
+            quint32 numer = 1; // ticks to nanos, mach ticks are not nanos on arm64
+            quint32 denom = 1;
+        };
+        Data d;
+};
+
+AVSystemClockPrivate::AVSystemClockPrivate()
+{
+#if defined(Q_OS_MACOS)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    d.numer = timebase.numer;
+    d.denom = timebase.denom;
+#endif
+}
+
+AVSystemClock::AVSystemClock()
+: p(new AVSystemClockPrivate())
+{
+}
+
+AVSystemClock::~AVSystemClock()
+{
+}
+
+quint64
+AVSystemClock::now() const
+{
+#if defined(Q_OS_MACOS)
+    return static_cast<quint64>((static_cast<quint128>(mach_absolute_time()) * p->d.numer) / p->d.denom);
+#else
+    timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<quint64>(time.tv_sec) * 1000000000ULL + time.tv_nsec;
+#endif
+}
+
+void
+AVSystemClock::sleep_until(quint64 nanos)
+{
+#if defined(Q_OS_MACOS)
+    mach_wait_until(static_cast<quint64>((static_cast<quint128>(nanos) * p->d.denom) / p->d.numer));
+#else
+    timespec time;
+    time.tv_sec = static_cast<time_t>(nanos / 1000000000ULL);
+    time.tv_nsec = static_cast<long>(nanos % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR) {
+    }
+#endif
+}
+
+class AVVirtualClockPrivate
+{
+    public:
+        struct Data
+        {
+            QAtomicInteger<quint64> time = 0; // read from the pacing thread, advanced from a test or decode thread
+        };
+        Data d;
+};
+
+AVVirtualClock::AVVirtualClock(quint64 nanos)
+: p(new AVVirtualClockPrivate())
+{
+    p->d.time.storeRelaxed(nanos);
+}
+
+AVVirtualClock::~AVVirtualClock()
+{
+}
+
+quint64
+AVVirtualClock::now() const
+{
+    return p->d.time.loadAcquire();
+}
+
+void
+AVVirtualClock::sleep_until(quint64 nanos)
+{
+    // sleeping fast forwards, waking exactly on the deadline
+    quint64 time = p->d.time.loadAcquire();
+    while (time < nanos && !p->d.time.testAndSetOrdered(time, nanos, time)) {
+    }
+}
+
+void
+AVVirtualClock::spin_until(quint64 nanos, bool yield)
+{
+    Q_UNUSED(yield);
+    sleep_until(nanos);
+}
+
+void
+AVVirtualClock::advance(quint64 nanos)
+{
+    p->d.time.fetchAndAddOrdered(nanos);
+}
+
+void
+AVVirtualClock::set_time(quint64 nanos)
+{
+    p->d.time.storeRelease(nanos);
+}
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include <QScopedPointer>
+#include <QtGlobal>
+
+class AVClock {
+    public:
+        virtual ~AVClock();
+        virtual quint64 now() const = 0; // monotonic nanos
+        virtual void sleep_until(quint64 nanos) = 0;
+        virtual void spin_until(quint64 nanos, bool yield);
+    
+        static AVClock* system();
+};
+
+class AVSystemClockPrivate;
+class AVSystemClock : public AVClock {
+    public:
+        AVSystemClock();
+        virtual ~AVSystemClock();
+        quint64 now() const override;
+        void sleep_until(quint64 nanos) override;
+
+    private:
+        QScopedPointer<AVSystemClockPrivate> p;
+};
+
+class AVVirtualClockPrivate;
+class AVVirtualClock : public AVClock {
+    public:
+        AVVirtualClock(quint64 nanos = 0);
+        virtual ~AVVirtualClock();
+        quint64 now() const override;
+        void sleep_until(quint64 nanos) override;
+        void spin_until(quint64 nanos, bool yield) override;
+        void advance(quint64 nanos);
+        void set_time(quint64 nanos);
+
+    private:
+        QScopedPointer<AVVirtualClockPrivate> p;
+};
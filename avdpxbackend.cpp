@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avdpxbackend.h"
+#include "avsmptetime.h"
+#include "avunpack.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <QDebug>
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+    constexpr quint32 undefined = 0xffffffff;
+
+    // fields of the generic file, image, film and television headers, offsets from smpte 268m
+    class AVDpxHeader
+    {
+        public:
+            bool parse(const uchar* data, qsizetype size);
+            quint32 u32(qsizetype offset) const {
+                quint32 value;
+                std::memcpy(&value, data + offset, 4);
+                return swap ? qbswap(value) : value;
+            }
+            quint16 u16(qsizetype offset) const {
+                quint16 value;
+                std::memcpy(&value, data + offset, 2);
+                return swap ? qbswap(value) : value;
+            }
+            float f32(qsizetype offset) const {
+                quint32 bits = u32(offset);
+                float value;
+                std::memcpy(&value, &bits, 4);
+                return bits == undefined || std::isnan(value) ? 0.0f : value;
+            }
+            QString text(qsizetype offset, qsizetype length) const {
+                const char* begin = reinterpret_cast<const char*>(data + offset);
+                return QString::fromLatin1(begin, qstrnlen(begin, length)).trimmed();
+            }
+            const uchar* data = nullptr;
+            qsizetype size = 0;
+            bool swap = false; // file byte order differs from the host
+            bool bigendian = true;
+            quint32 offset = 0; // pixel data of the first image element
+            quint32 width = 0;
+            quint32 height = 0;
+            quint8 descriptor = 0;
+            quint8 bitsize = 0;
+            quint16 packing = 0;
+            quint32 eolpadding = 0;
+            qsizetype stride = 0; // bytes per line including padding
+    };
+
+    bool
+    AVDpxHeader::parse(const uchar* data, qsizetype size)
+    {
+        this->data = data;
+        this->size = size;
+        if (size < 2048) {
+            return false;
+        }
+        if (std::memcmp(data, "SDPX", 4) == 0) {
+            bigendian = true;
+        }
+        else if (std::memcmp(data, "XPDS", 4) == 0) {
+            bigendian = false;
+        }
+        else {
+            return false;
+        }
+        swap = bigendian != (Q_BYTE_ORDER == Q_BIG_ENDIAN);
+        offset = u32(808) != undefined && u32(808) != 0 ? u32(808) : u32(4);
+        width = u32(772);
+        height = u32(776);
+        descriptor = data[800];
+        bitsize = data[803];
+        packing = u16(804);
+        eolpadding = u32(812) == undefined ? 0 : u32(812);
+        if (bitsize == 10) {
+            stride = static_cast<qsizetype>(width) * 4 + eolpadding; // one rgb pixel per 32-bit word
+        }
+        else if (bitsize == 16) {
+            stride = static_cast<qsizetype>(width) * 6 + eolpadding;
+        }
+        return true;
+    }
+}
+
+AVDpxBackend::AVDpxBackend()
+{
+}
+
+AVDpxBackend::~AVDpxBackend()
+{
+    close(); // no decode may run once the overrides are gone
+}
+
+QString
+AVDpxBackend::name() const
+{
+    return "dpx";
+}
+
+bool
+AVDpxBackend::probe(const QString& filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QByteArray magic = file.read(4);
+    return magic == "SDPX" || magic == "XPDS";
+}
+
+QImage
+AVDpxBackend::decode(const QString& path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "warning: " << "unable to open dpx file:" << path << file.errorString();
+        return QImage();
+    }
+    uchar* data = file.map(0, file.size()); // unmapped when the file closes
+    AVDpxHeader header;
+    if (!data || !header.parse(data, file.size())) {
+        qWarning() << "warning: " << "unable to map dpx file:" << path;
+        return QImage();
+    }
+    if (header.descriptor != 50 || (header.bitsize != 10 && header.bitsize != 16) || header.offset % 4 != 0 ||
+        header.offset + header.stride * static_cast<qsizetype>(header.height) > header.size) {
+        qWarning() << "warning: " << "unsupported or truncated dpx file:" << path;
+        return QImage();
+    }
+    if (header.bitsize == 10 && header.packing != 1 && header.packing != 2) { // inspect() only checks the first file
+        qWarning() << "warning: " << "unsupported dpx packing" << header.packing << "in file:" << path;
+        return QImage();
+    }
+    QImage image = pool.image(QSize(static_cast<int>(header.width), static_cast<int>(header.height)), QImage::Format_RGBX64);
+    if (image.isNull()) {
+        qWarning() << "warning: " << "unable to allocate dpx frame:" << path;
+        return QImage();
+    }
+    AVUnpack::Packing packing = header.packing == 1 ? AVUnpack::METHOD_A : AVUnpack::METHOD_B;
+    for (quint32 row = 0; row < header.height; row++) {
+        const uchar* line = data + header.offset + header.stride * row;
+        quint16* rgbx = reinterpret_cast<quint16*>(image.scanLine(static_cast<int>(row)));
+        if (header.bitsize == 10) {
+            AVUnpack::unpack10(reinterpret_cast<const quint32*>(line), header.width, packing, header.swap, rgbx);
+        }
+        else {
+            const quint16* samples = reinterpret_cast<const quint16*>(line);
+            for (quint32 x = 0; x < header.width; x++) {
+                rgbx[0] = header.swap ? qbswap(samples[0]) : samples[0];
+                rgbx[1] = header.swap ? qbswap(samples[1]) : samples[1];
+                rgbx[2] = header.swap ? qbswap(samples[2]) : samples[2];
+                rgbx[3] = 0xffff;
+                samples += 3;
+                rgbx += 4;
+            }
+        }
+    }
+    return image;
+}
+
+bool
+AVDpxBackend::inspect(const QString& path, AVBackend::Info& info)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(AVReader::FILE_ERROR, QString("unable to open dpx file: %1: %2").arg(path).arg(file.errorString()));
+    }
+    uchar* data = file.map(0, file.size());
+    AVDpxHeader header;
+    if (!data || !header.parse(data, file.size())) {
+        return fail(AVReader::FILE_ERROR, QString("invalid dpx header in file: %1").arg(path));
+    }
+    if (header.descriptor != 50) {
+        return fail(AVReader::FILE_ERROR, QString("unsupported dpx descriptor %1, only rgb is supported: %2").arg(header.descriptor).arg(path));
+    }
+    if (header.bitsize != 10 && header.bitsize != 16) {
+        return fail(AVReader::FILE_ERROR, QString("unsupported dpx bit size %1: %2").arg(header.bitsize).arg(path));
+    }
+    if (header.bitsize == 10 && header.packing != 1 && header.packing != 2) {
+        return fail(AVReader::FILE_ERROR, QString("unsupported dpx packing %1, 10-bit needs method a or b: %2").arg(header.packing).arg(path));
+    }
+    // the film frame rate describes the scan, the television rate the video, whichever is set
+    float rate = header.f32(1724) > 0.0f ? header.f32(1724) : header.f32(1940);
+    if (rate > 0.0f) {
+        qint64 frame = info.start.frames();
+        info.fps = AVFps::guess(rate);
+        info.start = AVTime(frame, info.fps);
+    }
+    quint32 timecode = header.u32(1920);
+    if (timecode != undefined && timecode != 0) {
+        QString label = QString("%1:%2:%3%4%5")
+                            .arg((timecode >> 24) & 0xff, 2, 16, QChar('0'))
+                            .arg((timecode >> 16) & 0xff, 2, 16, QChar('0'))
+                            .arg((timecode >> 8) & 0xff, 2, 16, QChar('0'))
+                            .arg(info.fps.drop_frame() ? ';' : ':')
+                            .arg(timecode & 0x3f, 2, 16, QChar('0')); // bcd, flag bits above the frame tens
+        qint64 frame = 0;
+        if (AVSmpteTime::parse(label.toLatin1(), info.fps, frame)) {
+            info.start = AVTime(frame, info.fps);
+            info.metadata.add_pair("timecode", label);
+        }
+        else {
+            qWarning() << "warning: " << "invalid dpx timecode:" << label << "in file:" << path;
+        }
+    }
+    info.metadata.add_pair("format", "dpx");
+    info.metadata.add_pair("resolution", QString("%1x%2").arg(header.width).arg(header.height));
+    info.metadata.add_pair("bit size", QString::number(header.bitsize));
+    info.metadata.add_pair("packing", header.bitsize == 10 ? (header.packing == 2 ? "method b" : "method a") : "none");
+    info.metadata.add_pair("byte order", header.bigendian ? "big endian" : "little endian");
+    info.metadata.add_pair("transfer", QString::number(data[801]));
+    info.metadata.add_pair("colorimetric", QString::number(data[802]));
+    if (rate > 0.0f) {
+        info.metadata.add_pair("frame rate", QString::number(rate));
+    }
+    const QList<QPair<QString, QPair<qsizetype, qsizetype>>> texts = {
+        { "creation time", { 136, 24 } },
+        { "creator", { 160, 100 } },
+        { "project", { 260, 200 } },
+        { "copyright", { 460, 200 } },
+        { "input device", { 1556, 32 } },
+        { "input serial", { 1588, 32 } },
+        { "frame id", { 1732, 32 } },
+        { "slate", { 1764, 100 } }
+    };
+    for (const auto& text : texts) {
+        QString value = header.text(text.second.first, text.second.second);
+        if (!value.isEmpty()) {
+            info.metadata.add_pair(text.first, value);
+        }
+    }
+    return true;
+}
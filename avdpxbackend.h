@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avframepool.h"
+#include "avsequencebackend.h"
+
+class AVDpxBackend : public AVSequenceBackend {
+    public:
+        AVDpxBackend();
+        virtual ~AVDpxBackend();
+        QString name() const override;
+        bool probe(const QString& filename) const override;
+
+    protected:
+        QImage decode(const QString& path) const override; // mapped, 10-bit rgb unpacked to RGBX64
+        bool inspect(const QString& path, AVBackend::Info& info) override;
+
+    private:
+        mutable AVFramePool pool; // unpacked frames, shared by the decode workers
+};
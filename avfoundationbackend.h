@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avbackend.h"
+#include "avhistogram.h"
+
+#include <QScopedPointer>
+
+class AVFoundationBackendPrivate;
+class AVFoundationBackend : public AVBackend {
+    public:
+        AVFoundationBackend();
+        virtual ~AVFoundationBackend();
+        QString name() const override;
+        bool open(const QString& filename) override;
+        void close() override;
+        bool seek(const AVTime& time) override;
+        bool read(QImage& image, AVTime& time) override;
+        bool drop(AVTime& time) override;
+        AVTimestamps timestamps() override;
+        AVBackend::Info info() const override;
+        AVHistogram seek_rebuilds() const; // seek latency in nanos, reader restarted at the keyframe
+        AVHistogram seek_reuses() const; // seek latency in nanos, running reader decoded forward
+        qint64 samples() const; // indexed with sample cursors, 0 when every seek restarts the reader
+        AVReader::Error error() const override;
+        QString error_message() const override;
+
+    private:
+        QScopedPointer<AVFoundationBackendPrivate> p;
+};
@@ -0,0 +1,643 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avfoundationbackend.h"
+#include "avframepool.h"
+#include "avhistogram.h"
+#include "avsmptetime.h"
+
+#include <AVFoundation/AVFoundation.h>
+#include <CoreMedia/CoreMedia.h>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+
+#include <algorithm>
+#include <cstring>
+
+class AVFoundationBackendPrivate
+{
+    public:
+        AVFoundationBackendPrivate();
+        ~AVFoundationBackendPrivate();
+        bool open();
+        void close();
+        bool read(QImage& image, AVTime& time);
+        bool drop(AVTime& time);
+        bool seek(const AVTime& time);
+        bool start(const AVTime& time);
+        bool index(AVAssetTrack* track);
+        qint64 position(const AVTime& time) const;
+        AVTimestamps load();
+        bool fail(AVReader::Error error, const QString& message);
+
+    public:
+        CMTime to_time(const AVTime& other);
+        AVTime to_time(const CMTime& other);
+        AVTimeRange to_timerange(const CMTimeRange& other);
+        struct Sample
+        {
+            qint64 pts = 0; // track timescale
+            qint64 dts = 0;
+            qint64 decode = 0; // position in decode order
+            qint64 keyframe = 0; // decode position of the sync sample it decodes from
+            qint64 offset = -1; // bytes into the file, -1 when not known
+            qint64 size = 0;
+            bool sync = false;
+        };
+        struct Data
+        {
+            AVAsset* asset = nil;
+            AVAssetReader* reader = nil;
+            AVAssetReaderTrackOutput* videooutput = nil;
+            QList<Sample> samples; // presentation order, built on open, empty without sample cursors
+            QHash<qint64, qint64> positions; // pts to presentation position
+            qint32 indextimescale = 0;
+            qint64 keyframes = 0;
+            qint64 position = -1; // presentation position of the next sample out of the reader, -1 when not known
+            AVHistogram rebuilds; // seek latency in nanoseconds, reader torn down and restarted
+            AVHistogram reuses; // seek latency in nanoseconds, reader kept and decoded forward
+            AVFramePool pool; // frames copied out of the decoder buffers, recycled once released
+            AVBackend::Info info;
+            qint32 timescale = 0;
+            QString filename;
+            QString errormessage;
+            AVReader::Error error = AVReader::NO_ERROR;
+        };
+        Data d;
+};
+
+AVFoundationBackendPrivate::AVFoundationBackendPrivate()
+{
+}
+
+AVFoundationBackendPrivate::~AVFoundationBackendPrivate()
+{
+}
+
+bool
+AVFoundationBackendPrivate::fail(AVReader::Error error, const QString& message)
+{
+    d.error = error;
+    d.errormessage = message;
+    qWarning() << "warning: " << d.errormessage;
+    return false;
+}
+
+bool
+AVFoundationBackendPrivate::open()
+{
+    NSURL* url = [NSURL fileURLWithPath:d.filename.toNSString()];
+    d.asset = [AVAsset assetWithURL:url];
+    if (!d.asset) {
+        return fail(AVReader::FILE_ERROR, QString("unable to load asset from file: %1").arg(d.filename));
+    }
+    NSError* averror = nil;
+    d.reader = [[AVAssetReader alloc] initWithAsset:d.asset error:&averror];
+    if (!d.reader) {
+        return fail(AVReader::API_ERROR, QString("unable to create AVAssetReader for video: %1").arg(QString::fromNSString(averror.localizedDescription)));
+    }
+    NSArray<NSString *>* metadataformats = @[
+        AVMetadataKeySpaceCommon,
+        AVMetadataFormatQuickTimeUserData,
+        AVMetadataQuickTimeUserDataKeyAlbum,
+        AVMetadataFormatISOUserData,
+        AVMetadataISOUserDataKeyCopyright,
+        AVMetadataISOUserDataKeyDate,
+        AVMetadataFormatQuickTimeMetadata,
+        AVMetadataQuickTimeMetadataKeyAuthor,
+        AVMetadataFormatiTunesMetadata,
+        AVMetadataiTunesMetadataKeyAlbum,
+        AVMetadataFormatID3Metadata,
+        AVMetadataID3MetadataKeyAudioEncryption,
+        AVMetadataKeySpaceIcy,
+        AVMetadataIcyMetadataKeyStreamTitle,
+        AVMetadataFormatHLSMetadata,
+        AVMetadataKeySpaceHLSDateRange,
+        AVMetadataKeySpaceAudioFile,
+        AVMetadataFormatUnknown
+    ];
+    for (NSString *format in metadataformats) {
+        NSArray<AVMetadataItem *> *metadataForFormat = [d.asset metadataForFormat:format];
+        if (metadataForFormat) {
+            for (AVMetadataItem* item in metadataForFormat) {
+                QString key = QString::fromNSString(item.commonKey);
+                QString value = QString::fromNSString(item.value.description);
+                if (!key.isEmpty() || !value.isEmpty()) {
+                    if (key == "title") { // todo: probably to simple but lets keep it for now
+                        d.info.title = value;
+                    }
+                    d.info.metadata.add_pair(key, value);
+                }
+            }
+        }
+    }
+    AVAssetTrack* videotrack = [[d.asset tracksWithMediaType:AVMediaTypeVideo] firstObject];
+    if (!videotrack) {
+        return fail(AVReader::API_ERROR, QString("no video track found in file: %1").arg(d.filename));
+    }
+    NSArray* formats = [videotrack formatDescriptions];
+    for (id formatDesc in formats) {
+        CMFormatDescriptionRef desc = (__bridge CMFormatDescriptionRef)formatDesc;
+        CMMediaType mediaType = CMFormatDescriptionGetMediaType(desc);
+        FourCharCode codecType = CMFormatDescriptionGetMediaSubType(desc);
+        NSString* media = [NSString stringWithFormat:@"%c%c%c%c",
+                                     (mediaType >> 24) & 0xFF,
+                                     (mediaType >> 16) & 0xFF,
+                                     (mediaType >> 8) & 0xFF,
+                                     mediaType & 0xFF];
+
+        NSString* codec = [NSString stringWithFormat:@"%c%c%c%c",
+                                     (codecType >> 24) & 0xFF,
+                                     (codecType >> 16) & 0xFF,
+                                     (codecType >> 8) & 0xFF,
+                                     codecType & 0xFF];
+
+        d.info.metadata.add_pair("media type", QString::fromNSString(media));
+        d.info.metadata.add_pair("codec type", QString::fromNSString(codec));
+    }
+    CMTime minduration = videotrack.minFrameDuration; // skip nominal frame rate for precision
+    qreal duration = static_cast<qreal>(minduration.value) / minduration.timescale;
+    d.info.fps = AVFps::guess(1.0 / duration);
+    d.info.variable = videotrack.nominalFrameRate > 0 && qAbs(videotrack.nominalFrameRate - d.info.fps.real()) > 0.01;
+    if (d.info.variable) { // nominal frame rate is the average, frames are placed by the timestamp table
+        d.info.fps = AVFps::guess(videotrack.nominalFrameRate);
+        d.timescale = videotrack.naturalTimeScale;
+        d.info.range = to_timerange(videotrack.timeRange);
+    }
+    else {
+        d.info.range = AVTimeRange::convert(to_timerange(videotrack.timeRange), d.info.fps);
+    }
+    d.info.start = d.info.range.start();
+    AVAssetTrack* timecodetrack = [[d.asset tracksWithMediaType:AVMediaTypeTimecode] firstObject];
+    if (timecodetrack) {
+        AVAssetReader* timecodereader = [[AVAssetReader alloc] initWithAsset:d.asset error:&averror];
+        if (!timecodereader) {
+            return fail(AVReader::API_ERROR, QString("unable to create AVAssetReader for timecode: %1").arg(QString::fromNSString(averror.localizedDescription)));
+        }
+        AVAssetReaderTrackOutput* timecodeoutput = [AVAssetReaderTrackOutput assetReaderTrackOutputWithTrack:timecodetrack outputSettings:nil];
+        [timecodereader addOutput:timecodeoutput];
+        bool success = [timecodereader startReading];
+        if (success) {
+            CMSampleBufferRef samplebuffer = NULL;
+            while ((samplebuffer = [timecodeoutput copyNextSampleBuffer])) {
+                CMBlockBufferRef blockbuffer = CMSampleBufferGetDataBuffer(samplebuffer);
+                CMFormatDescriptionRef formatdescription =  CMSampleBufferGetFormatDescription(samplebuffer);
+                if (blockbuffer && formatdescription) {
+                    size_t length = 0;
+                    size_t totallength = 0;
+                    char* data = NULL;
+                    OSStatus status = CMBlockBufferGetDataPointer(blockbuffer, 0, &length, &totallength, &data);
+                    if (status == kCMBlockBufferNoErr) {
+                        CMMediaType type = CMFormatDescriptionGetMediaSubType(formatdescription);
+                        uint32_t framequanta = CMTimeCodeFormatDescriptionGetFrameQuanta(formatdescription);
+                        uint32_t flags = CMTimeCodeFormatDescriptionGetTimeCodeFlags(formatdescription);
+                        bool dropframes = flags & kCMTimeCodeFlag_DropFrame;
+                        AVFps startfps = AVFps::guess(framequanta);
+                        Q_ASSERT("frame quanta does not match" && framequanta == startfps.frame_quanta());
+                        if (dropframes) {
+                            if (startfps == AVFps::fps_24()) {
+                                startfps = AVFps::fps_23_976();
+                            }
+                            else if (startfps == AVFps::fps_30()) {
+                                startfps = AVFps::fps_29_97();
+                            }
+                            else if (startfps == AVFps::fps_48()) {
+                                startfps = AVFps::fps_47_952();
+                            }
+                            else if (startfps == AVFps::fps_60()) {
+                                startfps = AVFps::fps_59_94();
+                            }
+                        }
+                        qint64 frame = 0;
+                        Q_ASSERT("drop frames does not match" && dropframes == startfps.drop_frame());
+                        if (type == kCMTimeCodeFormatType_TimeCode32) { // 32-bit little-endian to native
+                            frame = static_cast<qint64>(EndianS32_BtoN(*reinterpret_cast<int32_t*>(data)));
+                        }
+                        else if (type == kCMTimeCodeFormatType_TimeCode64) { // 64-bit big-endian to native
+                            frame = static_cast<qint64>(EndianS64_BtoN(*reinterpret_cast<int64_t*>(data)));
+                        }
+                        else {
+                            Q_ASSERT("no valid type found for format description" && false);
+                        }
+                        if (frame) {
+                            frame = AVSmpteTime::convert(frame, startfps, d.info.fps);
+                            d.info.start = AVTime::convert(AVTime(frame, d.info.fps), d.info.fps);
+                        }
+                    }
+                    else {
+                        CFRelease(samplebuffer);
+                        return fail(AVReader::API_ERROR, "unable to get data from block buffer for timecode");
+                    }
+                }
+                CFRelease(samplebuffer);
+            }
+        }
+        else {
+            return fail(AVReader::API_ERROR, "unable to read sample buffer at for timecode");
+        }
+    }
+    if (d.info.variable && d.info.start.timescale() != d.timescale) {
+        d.info.start = AVTime::convert(d.info.start, d.timescale);
+    }
+    index(videotrack);
+    d.videooutput = [[AVAssetReaderTrackOutput alloc]
+        initWithTrack:videotrack
+        outputSettings:@{
+            (NSString*)kCVPixelBufferPixelFormatTypeKey : @(kCVPixelFormatType_32BGRA)
+    }];
+    if (!d.videooutput) {
+        return fail(AVReader::API_ERROR, "unable to create AVAssetReaderTrackOutput");
+    }
+    [d.reader addOutput:d.videooutput];
+    [d.reader startReading];
+    d.position = d.samples.isEmpty() ? -1 : 0;
+    return true;
+}
+
+void
+AVFoundationBackendPrivate::close()
+{
+    if (d.reader) {
+        [d.reader cancelReading];
+        d.reader = nil;
+    }
+    d.asset = nil;
+    d.videooutput = nil;
+    d.samples.clear();
+    d.positions.clear();
+    d.indextimescale = 0;
+    d.keyframes = 0;
+    d.position = -1;
+    d.rebuilds.reset();
+    d.reuses.reset();
+    d.info = AVBackend::Info();
+    d.timescale = 0;
+    d.errormessage = QString();
+    d.error = AVReader::NO_ERROR;
+}
+
+bool
+AVFoundationBackendPrivate::read(QImage& image, AVTime& time)
+{
+    Q_ASSERT(d.reader || d.reader.status != AVAssetReaderStatusReading);
+
+    CMSampleBufferRef samplebuffer = [d.videooutput copyNextSampleBuffer];
+    if (!samplebuffer) {
+        return fail(AVReader::API_ERROR, "unable to read sample buffer at current frame");
+    }
+    CVImageBufferRef imagebuffer = CMSampleBufferGetImageBuffer(samplebuffer);
+    if (!imagebuffer) {
+        CFRelease(samplebuffer);
+        return fail(AVReader::API_ERROR, "CMSampleBuffer has no image buffer");
+    }
+    // copied into a pooled frame and the pixel buffer goes straight back to the decoder. wrapping it
+    // would keep it locked for as long as the cache holds the frame and drain the decoder pool
+    CVPixelBufferLockBaseAddress(imagebuffer, kCVPixelBufferLock_ReadOnly);
+    const uchar* baseAddress = static_cast<const uchar*>(CVPixelBufferGetBaseAddress(imagebuffer));
+    int width = static_cast<int>(CVPixelBufferGetWidth(imagebuffer));
+    int height = static_cast<int>(CVPixelBufferGetHeight(imagebuffer));
+    size_t bytes = CVPixelBufferGetBytesPerRow(imagebuffer);
+    image = d.pool.image(QSize(width, height), QImage::Format_ARGB32); // 32BGRA in memory on little endian
+    if (!image.isNull()) {
+        for (int y = 0; y < height; y++) {
+            std::memcpy(image.scanLine(y), baseAddress + y * bytes, static_cast<size_t>(width) * 4);
+        }
+    }
+    CVPixelBufferUnlockBaseAddress(imagebuffer, kCVPixelBufferLock_ReadOnly);
+    if (image.isNull()) {
+        CFRelease(samplebuffer);
+        return fail(AVReader::API_ERROR, "unable to allocate frame for sample buffer");
+    }
+    time = to_time(CMSampleBufferGetPresentationTimeStamp(samplebuffer));
+    if (!d.info.variable) {
+        time = AVTime::convert(time, d.info.fps);
+    }
+    CFRelease(samplebuffer);
+    if (d.position >= 0) {
+        d.position++;
+    }
+    return true;
+}
+
+bool
+AVFoundationBackendPrivate::drop(AVTime& time)
+{
+    Q_ASSERT(d.reader || d.reader.status != AVAssetReaderStatusReading);
+
+    CMSampleBufferRef samplebuffer = [d.videooutput copyNextSampleBuffer];
+    if (!samplebuffer) {
+        return fail(AVReader::API_ERROR, "unable to drop sample buffer at current frame");
+    }
+    time = to_time(CMSampleBufferGetPresentationTimeStamp(samplebuffer));
+    if (!d.info.variable) {
+        time = AVTime::convert(time, d.info.fps);
+    }
+    CFRelease(samplebuffer);
+    if (d.position >= 0) {
+        d.position++;
+    }
+    return true;
+}
+
+bool
+AVFoundationBackendPrivate::seek(const AVTime& time)
+{
+    QElapsedTimer timer;
+    timer.start();
+    qint64 target = position(time);
+    if (target >= 0 && d.position >= 0 && d.position <= target && d.reader.status == AVAssetReaderStatusReading) {
+        // forward within reach of the running reader, decoding on from its position costs no more than
+        // decoding from the keyframe of the target, which a restarted reader has to do
+        const Sample& sample = d.samples[target];
+        qint64 forward = sample.decode - d.samples[d.position].decode;
+        qint64 restart = sample.decode - sample.keyframe;
+        if (forward <= restart) {
+            bool reused = true;
+            while (d.position < target) {
+                CMSampleBufferRef samplebuffer = [d.videooutput copyNextSampleBuffer];
+                if (!samplebuffer) {
+                    reused = false;
+                    break;
+                }
+                CFRelease(samplebuffer);
+                d.position++;
+            }
+            if (reused) {
+                d.reuses.record(static_cast<quint64>(timer.nsecsElapsed()));
+                return true;
+            }
+        }
+    }
+    if (!start(time)) {
+        return false;
+    }
+    d.position = target;
+    d.rebuilds.record(static_cast<quint64>(timer.nsecsElapsed()));
+    return true;
+}
+
+bool
+AVFoundationBackendPrivate::start(const AVTime& time)
+{
+    if (d.reader) {
+        [d.reader cancelReading];
+        d.reader = nil;
+    }
+    NSError* averror = nil;
+    d.reader = [[AVAssetReader alloc] initWithAsset:d.asset error:&averror];
+    if (!d.reader) {
+        return fail(AVReader::API_ERROR, QString("failed to recreate AVAssetReader: %1").arg(QString::fromNSString(averror.localizedDescription)));
+    }
+    AVAssetTrack* track = [[d.asset tracksWithMediaType:AVMediaTypeVideo] firstObject];
+    if (!track) {
+        return fail(AVReader::API_ERROR, "no video track found in asset");
+    }
+    d.videooutput = [[AVAssetReaderTrackOutput alloc]
+        initWithTrack:track
+        outputSettings:@{
+            (NSString*)kCVPixelBufferPixelFormatTypeKey : @(kCVPixelFormatType_32BGRA)
+    }];
+    if (!d.videooutput) {
+        return fail(AVReader::API_ERROR, "unable to create AVAssetReaderTrackOutput");
+    }
+    [d.reader addOutput:d.videooutput];
+    AVTime duration = d.info.range.end() - time;
+    d.reader.timeRange = CMTimeRangeMake(to_time(time), to_time(duration));
+    if (![d.reader startReading]) {
+        return fail(AVReader::API_ERROR, "failed to start reading after seeking");
+    }
+    return true;
+}
+
+bool
+AVFoundationBackendPrivate::index(AVAssetTrack* track)
+{
+    if (!track.canProvideSampleCursors) { // seeks restart the reader
+        return false;
+    }
+    for (AVAssetTrackSegment* segment in track.segments) {
+        if (segment.isEmpty || CMTimeCompare(segment.timeMapping.source.start, segment.timeMapping.target.start) != 0) {
+            return false; // edits shift media time against track time, seeks restart the reader
+        }
+    }
+    d.indextimescale = track.naturalTimeScale;
+    AVSampleCursor* cursor = [track makeSampleCursorAtFirstSampleInDecodeOrder];
+    if (!cursor) {
+        return false;
+    }
+    d.samples.reserve(static_cast<qint64>(track.nominalFrameRate * CMTimeGetSeconds(track.timeRange.duration)) + 1);
+    qint64 keyframe = 0;
+    do { // metadata only, no sample data is read
+        Sample sample;
+        sample.pts = CMTimeConvertScale(cursor.presentationTimeStamp, d.indextimescale, kCMTimeRoundingMethod_RoundHalfAwayFromZero).value;
+        sample.dts = CMTimeConvertScale(cursor.decodeTimeStamp, d.indextimescale, kCMTimeRoundingMethod_RoundHalfAwayFromZero).value;
+        sample.decode = d.samples.size();
+        sample.sync = cursor.currentSampleSyncInfo.sampleIsFullSync;
+        if (sample.sync || sample.decode == 0) {
+            keyframe = sample.decode;
+            d.keyframes++;
+        }
+        sample.keyframe = keyframe;
+        AVSampleCursorStorageRange storage = cursor.currentSampleStorageRange;
+        if (storage.offset >= 0 && storage.length > 0) {
+            sample.offset = storage.offset;
+            sample.size = storage.length;
+        }
+        d.samples.append(sample);
+    } while ([cursor stepInDecodeOrderByCount:1] == 1);
+    std::stable_sort(d.samples.begin(), d.samples.end(), [](const Sample& a, const Sample& b) { return a.pts < b.pts; });
+    d.positions.reserve(d.samples.size());
+    for (qint64 i = 0; i < d.samples.size(); i++) {
+        d.positions.insert(d.samples[i].pts, i);
+    }
+    d.samples.squeeze();
+    return true;
+}
+
+qint64
+AVFoundationBackendPrivate::position(const AVTime& time) const
+{
+    if (d.samples.isEmpty()) {
+        return -1;
+    }
+    CMTime pts = CMTimeConvertScale(CMTimeMake(time.ticks(), time.timescale()), d.indextimescale, kCMTimeRoundingMethod_RoundHalfAwayFromZero);
+    auto found = d.positions.constFind(pts.value);
+    if (found != d.positions.constEnd()) { // aligned times land on a sample
+        return found.value();
+    }
+    auto it = std::upper_bound(d.samples.cbegin(), d.samples.cend(), pts.value, [](qint64 ticks, const Sample& sample) {
+        return ticks < sample.pts;
+    });
+    return it == d.samples.cbegin() ? 0 : static_cast<qint64>(it - d.samples.cbegin()) - 1;
+}
+
+AVTimestamps
+AVFoundationBackendPrivate::load()
+{
+    AVAssetTrack* track = [[d.asset tracksWithMediaType:AVMediaTypeVideo] firstObject];
+    if (!track) {
+        return AVTimestamps();
+    }
+    AVTimestamps timestamps(d.timescale);
+    if (track.canProvideSampleCursors) {
+        AVSampleCursor* cursor = [track makeSampleCursorWithPresentationTimeStamp:kCMTimeNegativeInfinity];
+        timestamps.reserve(static_cast<qint64>(track.nominalFrameRate * CMTimeGetSeconds(track.timeRange.duration)) + 1);
+        do {
+            CMTime pts = CMTimeConvertScale(cursor.presentationTimeStamp, d.timescale, kCMTimeRoundingMethod_RoundHalfAwayFromZero);
+            timestamps.append(pts.value);
+        } while ([cursor stepInPresentationOrderByCount:1] == 1);
+    }
+    else { // sample timing without decoding, samples arrive in decode order
+        NSError* averror = nil;
+        AVAssetReader* reader = [[AVAssetReader alloc] initWithAsset:d.asset error:&averror];
+        if (!reader) {
+            fail(AVReader::API_ERROR, QString("unable to create AVAssetReader for timestamps: %1").arg(QString::fromNSString(averror.localizedDescription)));
+            return AVTimestamps();
+        }
+        AVAssetReaderTrackOutput* output = [AVAssetReaderTrackOutput assetReaderTrackOutputWithTrack:track outputSettings:nil];
+        output.alwaysCopiesSampleData = NO;
+        [reader addOutput:output];
+        if (![reader startReading]) {
+            fail(AVReader::API_ERROR, "unable to start reading timestamps");
+            return AVTimestamps();
+        }
+        QList<qint64> ticks;
+        CMSampleBufferRef samplebuffer = NULL;
+        while ((samplebuffer = [output copyNextSampleBuffer])) {
+            CMTime pts = CMSampleBufferGetPresentationTimeStamp(samplebuffer);
+            if (CMTIME_IS_NUMERIC(pts) && CMSampleBufferGetNumSamples(samplebuffer) > 0) {
+                ticks.append(CMTimeConvertScale(pts, d.timescale, kCMTimeRoundingMethod_RoundHalfAwayFromZero).value);
+            }
+            CFRelease(samplebuffer);
+        }
+        std::sort(ticks.begin(), ticks.end());
+        ticks.erase(std::unique(ticks.begin(), ticks.end()), ticks.end());
+        timestamps.reserve(ticks.size());
+        for (qint64 tick : ticks) {
+            timestamps.append(tick);
+        }
+    }
+    timestamps.set_end(d.info.range.end().ticks());
+    timestamps.squeeze();
+    return timestamps;
+}
+
+CMTime
+AVFoundationBackendPrivate::to_time(const AVTime& other) {
+   return CMTimeMakeWithEpoch(other.ticks(), other.timescale(), 0); // default epoch and flags
+}
+
+AVTime
+AVFoundationBackendPrivate::to_time(const CMTime& other) {
+    Q_ASSERT("fps is not valid" && d.info.fps.valid());
+
+    AVTime time;
+    if (CMTIME_IS_VALID(other)) {
+        time.set_ticks(other.value);
+        time.set_timescale(other.timescale);
+        time.set_fps(d.info.fps);
+    }
+    return time;
+}
+
+AVTimeRange
+AVFoundationBackendPrivate::to_timerange(const CMTimeRange& timerange) {
+    AVTimeRange range;
+    if (CMTIMERANGE_IS_VALID(timerange)) {
+        range.set_start(to_time(timerange.start));
+        range.set_duration(to_time(timerange.duration));
+    }
+    return range;
+}
+
+AVFoundationBackend::AVFoundationBackend()
+: p(new AVFoundationBackendPrivate())
+{
+}
+
+AVFoundationBackend::~AVFoundationBackend()
+{
+    p->close();
+}
+
+QString
+AVFoundationBackend::name() const
+{
+    return "avfoundation";
+}
+
+bool
+AVFoundationBackend::open(const QString& filename)
+{
+    p->close();
+    p->d.filename = filename;
+    return p->open();
+}
+
+void
+AVFoundationBackend::close()
+{
+    p->close();
+}
+
+bool
+AVFoundationBackend::seek(const AVTime& time)
+{
+    return p->seek(time);
+}
+
+bool
+AVFoundationBackend::read(QImage& image, AVTime& time)
+{
+    return p->read(image, time);
+}
+
+bool
+AVFoundationBackend::drop(AVTime& time)
+{
+    return p->drop(time);
+}
+
+AVTimestamps
+AVFoundationBackend::timestamps()
+{
+    return p->load();
+}
+
+AVBackend::Info
+AVFoundationBackend::info() const
+{
+    return p->d.info;
+}
+
+AVHistogram
+AVFoundationBackend::seek_rebuilds() const
+{
+    return p->d.rebuilds;
+}
+
+AVHistogram
+AVFoundationBackend::seek_reuses() const
+{
+    return p->d.reuses;
+}
+
+qint64
+AVFoundationBackend::samples() const
+{
+    return p->d.samples.size();
+}
+
+AVReader::Error
+AVFoundationBackend::error() const
+{
+    return p->d.error;
+}
+
+QString
+AVFoundationBackend::error_message() const
+{
+    return p->d.errormessage;
+}
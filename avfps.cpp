@@ -2,66 +2,23 @@
 // Copyright (c) 2022 - present Mikael Sundell.
 
 #include "avfps.h"
+#include "avmath.h"
+#include "avrate.h"
 
-#include <QVector>
+#include <type_traits>
 
-class AVFpsPrivate
-{
-    public:
-        struct Data
-        {
-            qint32 numerator = 0;
-            qint32 denominator = 0;
-            bool drop_frame = false;
-        };
-        Data d;
-        QAtomicInt ref;
-};
-
-AVFps::AVFps()
-: p(new AVFpsPrivate())
-{
-}
-
-AVFps::AVFps(qint32 numerator, qint32 denominator, bool drop_frame)
-: p(new AVFpsPrivate())
-{
-    p->d.numerator = numerator;
-    p->d.denominator = denominator;
-    p->d.drop_frame = drop_frame;
-}
-
-AVFps::AVFps(const AVFps& other)
-: p(other.p)
-{
-}
-
-AVFps::~AVFps()
-{
-}
-
-qint64
-AVFps::numerator() const
-{
-    return p->d.numerator;
-}
-
-qint32
-AVFps::denominator() const
-{
-    return p->d.denominator;
-}
-
-bool
-AVFps::drop_frame() const
-{
-    return p->d.drop_frame;
-}
+static_assert(std::is_trivially_copyable_v<AVFps>, "fps must stay a flat value type");
 
 qint16
 AVFps::frame_quanta() const
 {
-    return static_cast<qint64>(std::round(real()));
+    Q_ASSERT("fps is not valid" && valid());
+
+    qint16 framequanta = 0;
+    if (AVRates::dispatch(*this, [&](auto rate) { framequanta = decltype(rate)::frame_quanta; })) {
+        return framequanta;
+    }
+    return static_cast<qint16>(AVMath::muldiv(1, numerator(), denominator()));
 }
 
 qreal
@@ -81,7 +38,7 @@ AVFps::seconds() const
 qreal
 AVFps::to_fps(qint64 frame, const AVFps& other) const
 {
-    return static_cast<qint64>(std::round(frame * (real() / other.real())));
+    return AVMath::muldiv(frame, numerator() * other.denominator(), static_cast<qint64>(denominator()) * other.numerator());
 }
 
 QString
@@ -90,83 +47,44 @@ AVFps::to_string() const
     return QString("%1").arg(seconds());
 }
 
-bool
-AVFps::valid() const {
-    return p->d.denominator > 0;
-}
-
 void
 AVFps::set_numerator(qint32 numerator)
 {
-    if (p->d.numerator != numerator) {
-        if (p->ref.loadRelaxed() > 1) {
-            p.detach();
-        }
-        p->d.numerator = numerator;
-    }
+    d.numerator = numerator;
 }
 
 void
 AVFps::set_denominator(qint32 denominator)
 {
-    if (p->d.denominator != denominator) {
-        if (denominator > 0) {
-            if (p->ref.loadRelaxed() > 1) {
-                p.detach();
-            }
-            p->d.denominator = denominator;
-        }
+    if (denominator > 0) {
+        d.denominator = denominator;
     }
 }
 
 void
 AVFps::set_dropframe(bool dropframe)
 {
-    if (p->d.drop_frame != dropframe) {
-        p->d.drop_frame = dropframe;
-    }
-}
-
-AVFps&
-AVFps::operator=(const AVFps& other)
-{
-    if (this != &other) {
-        p = other.p;
-    }
-    return *this;
-}
-
-bool
-AVFps::operator==(const AVFps& other) const
-{
-    return p->d.numerator == other.p->d.numerator &&
-           p->d.denominator == other.p->d.denominator &&
-           p->d.drop_frame == other.p->d.drop_frame;
-}
-
-bool
-AVFps::operator!=(const AVFps& other) const {
-    return !(*this == other);
+    d.drop_frame = dropframe;
 }
 
 bool
 AVFps::operator<(const AVFps& other) const {
-    return real() < other.real();
+    return AVMath::compare(numerator(), denominator(), other.numerator(), other.denominator()) < 0;
 }
 
 bool
 AVFps::operator>(const AVFps& other) const {
-    return real() > other.real();
+    return AVMath::compare(numerator(), denominator(), other.numerator(), other.denominator()) > 0;
 }
 
 bool
 AVFps::operator<=(const AVFps& other) const {
-    return real() <= other.real();
+    return AVMath::compare(numerator(), denominator(), other.numerator(), other.denominator()) <= 0;
 }
 
 bool
 AVFps::operator>=(const AVFps& other) const {
-    return real() >= other.real();
+    return AVMath::compare(numerator(), denominator(), other.numerator(), other.denominator()) >= 0;
 }
 
 AVFps::operator double() const
@@ -178,19 +96,7 @@ AVFps
 AVFps::guess(qreal fps)
 {
     const qreal epsilon = 0.005;
-    const QVector<AVFps> standards = {
-        fps_23_976(),
-        fps_24(),
-        fps_25(),
-        fps_29_97(),
-        fps_30(),
-        fps_47_952(),
-        fps_48(),
-        fps_50(),
-        fps_59_94(),
-        fps_60()
-    };
-    for (const AVFps& standard : standards) {
+    for (const AVFps& standard : AVRates::standards) {
         if (qAbs(standard.real() - fps) < epsilon) {
             return standard;
         }
@@ -198,68 +104,8 @@ AVFps::guess(qreal fps)
     return AVFps(static_cast<qint32>(fps * 1000), 1000);
 }
 
-AVFps
-AVFps::fps_23_976()
-{
-    return AVFps(24000, 1001, true);
-}
-
-AVFps
-AVFps::fps_24()
-{
-    return AVFps(24, 1);
-}
-
-AVFps
-AVFps::fps_25()
-{
-    return AVFps(25, 1);
-}
-
-AVFps
-AVFps::fps_29_97()
-{
-    return AVFps(30000, 1001, true);
-}
-
-AVFps
-AVFps::fps_30()
-{
-    return AVFps(30, 1);
-}
-
-AVFps
-AVFps::fps_47_952()
-{
-    return AVFps(48000, 1001, true);
-}
-
-AVFps
-AVFps::fps_48()
-{
-    return AVFps(48, 1);
-}
-
-AVFps
-AVFps::fps_50()
-{
-    return AVFps(50, 1);
-}
-
-AVFps
-AVFps::fps_59_94()
-{
-    return AVFps(60000, 1001, true);
-}
-
-AVFps
-AVFps::fps_60()
-{
-    return AVFps(60, 1);
-}
-
 qint64
 AVFps::convert(quint64 value, const AVFps& from, const AVFps& to)
 {
-    return qRound(static_cast<qreal>(value) * (to / from));
+    return AVMath::muldiv(value, to.numerator() * from.denominator(), static_cast<qint64>(to.denominator()) * from.numerator());
 }
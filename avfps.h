@@ -3,53 +3,66 @@
 
 #pragma once
 
-#include <QExplicitlySharedDataPointer>
+#include <QString>
+#include <QtGlobal>
 
-class AVFpsPrivate;
 class AVFps
 {
     public:
-        AVFps();
-        AVFps(qint32 numerator, qint32 denominator, bool drop_frame = false);
-        AVFps(const AVFps& other);
-        ~AVFps();
-        qint64 numerator() const;
-        qint32 denominator() const;
-        bool drop_frame() const;
+        constexpr AVFps() = default;
+        constexpr AVFps(qint32 numerator, qint32 denominator, bool drop_frame = false)
+        : d { numerator, denominator, drop_frame }
+        {
+        }
+        constexpr AVFps(const AVFps& other) = default;
+        ~AVFps() = default;
+        constexpr qint64 numerator() const { return d.numerator; }
+        constexpr qint32 denominator() const { return d.denominator; }
+        constexpr bool drop_frame() const { return d.drop_frame; }
         qint16 frame_quanta() const;
         qreal real() const;
         qreal seconds() const;
         qreal to_fps(qint64 frame, const AVFps& other) const;
         QString to_string() const;
-        bool valid() const;
-    
+        constexpr bool valid() const { return d.denominator > 0; }
+
         void set_numerator(qint32 nominator);
         void set_denominator(qint32 denominator);
         void set_dropframe(bool dropframe);
-    
-        AVFps& operator=(const AVFps& other);
-        bool operator==(const AVFps& other) const;
-        bool operator!=(const AVFps& other) const;
+
+        constexpr AVFps& operator=(const AVFps& other) = default;
+        constexpr bool operator==(const AVFps& other) const {
+            return d.numerator == other.d.numerator &&
+                   d.denominator == other.d.denominator &&
+                   d.drop_frame == other.d.drop_frame;
+        }
+        constexpr bool operator!=(const AVFps& other) const { return !(*this == other); }
         bool operator<(const AVFps& other) const;
         bool operator>(const AVFps& other) const;
         bool operator<=(const AVFps& other) const;
         bool operator>=(const AVFps& other) const;
         operator double() const;
-    
+
         static AVFps guess(qreal fps);
-        static AVFps fps_23_976();
-        static AVFps fps_24();
-        static AVFps fps_25();
-        static AVFps fps_29_97();
-        static AVFps fps_30();
-        static AVFps fps_47_952();
-        static AVFps fps_48();
-        static AVFps fps_50();
-        static AVFps fps_59_94();
-        static AVFps fps_60();
-    
+        static constexpr AVFps fps_23_976() { return AVFps(24000, 1001, true); }
+        static constexpr AVFps fps_24() { return AVFps(24, 1); }
+        static constexpr AVFps fps_25() { return AVFps(25, 1); }
+        static constexpr AVFps fps_29_97() { return AVFps(30000, 1001, true); }
+        static constexpr AVFps fps_30() { return AVFps(30, 1); }
+        static constexpr AVFps fps_47_952() { return AVFps(48000, 1001, true); }
+        static constexpr AVFps fps_48() { return AVFps(48, 1); }
+        static constexpr AVFps fps_50() { return AVFps(50, 1); }
+        static constexpr AVFps fps_59_94() { return AVFps(60000, 1001, true); }
+        static constexpr AVFps fps_60() { return AVFps(60, 1); }
+
         static qint64 convert(quint64 value, const AVFps& from, const AVFps& to);
 
     private:
-        QExplicitlySharedDataPointer<AVFpsPrivate> p;
+        struct Data
+        {
+            qint32 numerator = 0;
+            qint32 denominator = 0;
+            bool drop_frame = false;
+        };
+        Data d;
 };
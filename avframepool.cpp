@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avframepool.h"
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+
+#include <atomic>
+#include <cstdlib>
+
+namespace {
+    constexpr qsizetype alignment = 64; // cache line, and enough for every simd load and store
+    qsizetype align(qsizetype bytes) { return (bytes + alignment - 1) & ~(alignment - 1); }
+    std::atomic<qint64> allocations { 0 }; // every pool
+    std::atomic<qint64> reuses { 0 };
+}
+
+struct AVFramePoolBuffer
+{
+    AVFramePoolData* pool;
+    uchar* data;
+    qsizetype size;
+};
+
+class AVFramePoolData
+{
+    public:
+        ~AVFramePoolData();
+        void release(AVFramePoolBuffer* buffer);
+        void trim();
+        QList<AVFramePoolBuffer*> buffers; // free, most recently returned last
+        qsizetype limit = 8;
+        qint64 allocations = 0;
+        qint64 reuses = 0;
+        qint64 bytes = 0;
+        QMutex mutex;
+        QAtomicInt ref; // pool handles and every buffer in use
+        static void cleanup(void* info);
+};
+
+AVFramePoolData::~AVFramePoolData()
+{
+    limit = 0;
+    trim();
+}
+
+void
+AVFramePoolData::release(AVFramePoolBuffer* buffer)
+{
+    bytes -= buffer->size;
+    std::free(buffer->data);
+    delete buffer;
+}
+
+void
+AVFramePoolData::trim()
+{
+    while (buffers.size() > limit) {
+        release(buffers.takeFirst());
+    }
+}
+
+void
+AVFramePoolData::cleanup(void* info)
+{
+    AVFramePoolBuffer* buffer = static_cast<AVFramePoolBuffer*>(info);
+    AVFramePoolData* pool = buffer->pool;
+    {
+        QMutexLocker locker(&pool->mutex);
+        pool->buffers.append(buffer);
+        pool->trim();
+    }
+    if (!pool->ref.deref()) { // the last image outlived every pool handle
+        delete pool;
+    }
+}
+
+AVFramePool::AVFramePool()
+: p(new AVFramePoolData())
+{
+}
+
+AVFramePool::AVFramePool(const AVFramePool& other) = default;
+
+AVFramePool::~AVFramePool()
+{
+}
+
+QImage
+AVFramePool::image(const QSize& size, QImage::Format format)
+{
+    qsizetype stride = AVFramePool::stride(size.width(), format);
+    qsizetype bytes = stride * qMax(1, size.height());
+    AVFramePoolBuffer* buffer = nullptr;
+    {
+        QMutexLocker locker(&p->mutex);
+        for (qsizetype i = p->buffers.size() - 1; i >= 0; i--) {
+            if (p->buffers[i]->size == bytes) {
+                buffer = p->buffers.takeAt(i);
+                p->reuses++;
+                reuses.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        if (!buffer) {
+            uchar* data = static_cast<uchar*>(std::aligned_alloc(alignment, align(bytes)));
+            if (!data) {
+                return QImage();
+            }
+            buffer = new AVFramePoolBuffer { p.data(), data, bytes };
+            p->allocations++;
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            p->bytes += bytes;
+        }
+        p->ref.ref();
+    }
+    return QImage(buffer->data, size.width(), size.height(), stride, format, &AVFramePoolData::cleanup, buffer);
+}
+
+qint64
+AVFramePool::allocations() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->allocations;
+}
+
+qint64
+AVFramePool::reuses() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->reuses;
+}
+
+qint64
+AVFramePool::bytes() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->bytes;
+}
+
+qsizetype
+AVFramePool::available() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->buffers.size();
+}
+
+qsizetype
+AVFramePool::limit() const
+{
+    QMutexLocker locker(&p->mutex);
+    return p->limit;
+}
+
+void
+AVFramePool::set_limit(qsizetype buffers)
+{
+    QMutexLocker locker(&p->mutex);
+    p->limit = qMax(qsizetype(0), buffers);
+    p->trim();
+}
+
+void
+AVFramePool::clear()
+{
+    QMutexLocker locker(&p->mutex);
+    qsizetype limit = p->limit;
+    p->limit = 0;
+    p->trim();
+    p->limit = limit;
+}
+
+AVFramePool&
+AVFramePool::operator=(const AVFramePool& other) = default;
+
+qsizetype
+AVFramePool::stride(int width, QImage::Format format)
+{
+    qsizetype bits = static_cast<qsizetype>(width) * QImage::toPixelFormat(format).bitsPerPixel();
+    return align((bits + 7) / 8);
+}
+
+qint64
+AVFramePool::total_allocations()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+qint64
+AVFramePool::total_reuses()
+{
+    return reuses.load(std::memory_order_relaxed);
+}
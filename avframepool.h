@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include <QImage>
+#include <QSize>
+
+#include <QExplicitlySharedDataPointer>
+
+// recycled frame buffers handed out as images. rows start 64-byte aligned, the image is a reference to
+// the buffer and the buffer returns to the pool when the last copy of the image is gone, also after the
+// pool itself is destroyed. after warm-up a steady stream of same sized frames allocates nothing
+class AVFramePoolData;
+class AVFramePool
+{
+    public:
+        AVFramePool();
+        AVFramePool(const AVFramePool& other);
+        ~AVFramePool();
+        QImage image(const QSize& size, QImage::Format format); // contents are undefined
+        qint64 allocations() const; // buffers allocated since the pool was created
+        qint64 reuses() const;
+        qint64 bytes() const; // allocated, in use or free
+        qsizetype available() const; // free buffers
+        qsizetype limit() const;
+        void set_limit(qsizetype buffers); // free buffers kept, the rest are released
+        void clear(); // releases the free buffers
+
+        AVFramePool& operator=(const AVFramePool& other);
+
+        static qsizetype stride(int width, QImage::Format format); // bytes per line, 64-byte aligned
+        static qint64 total_allocations(); // of every pool in the process, for stream stats
+        static qint64 total_reuses();
+
+    private:
+        QExplicitlySharedDataPointer<AVFramePoolData> p;
+};
@@ -0,0 +1,192 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avhistogram.h"
+
+#include <QList>
+
+#include <cmath>
+#include <limits>
+
+class AVHistogramPrivate
+{
+    public:
+        AVHistogramPrivate();
+        AVHistogramPrivate(const AVHistogramPrivate& other);
+        struct Data
+        {
+            QList<quint64> counts; // allocated on first record, recording never allocates after that
+            quint64 count = 0;
+            quint64 min = std::numeric_limits<quint64>::max();
+            quint64 max = 0;
+            qreal sum = 0.0;
+        };
+        Data d;
+        QAtomicInt ref;
+};
+
+AVHistogramPrivate::AVHistogramPrivate()
+{
+}
+
+AVHistogramPrivate::AVHistogramPrivate(const AVHistogramPrivate& other)
+: d(other.d) // detached copies start with a fresh ref count
+{
+}
+
+AVHistogram::AVHistogram()
+: p(new AVHistogramPrivate())
+{
+}
+
+AVHistogram::AVHistogram(const AVHistogram& other)
+: p(other.p)
+{
+}
+
+AVHistogram::~AVHistogram()
+{
+}
+
+quint64
+AVHistogram::count() const
+{
+    return p->d.count;
+}
+
+quint64
+AVHistogram::count(quint64 above) const
+{
+    quint64 count = 0;
+    for (qsizetype i = index(above) + 1; i < p->d.counts.size(); i++) {
+        count += p->d.counts[i];
+    }
+    return count;
+}
+
+quint64
+AVHistogram::min() const
+{
+    return is_empty() ? 0 : p->d.min;
+}
+
+quint64
+AVHistogram::max() const
+{
+    return p->d.max;
+}
+
+qreal
+AVHistogram::mean() const
+{
+    return is_empty() ? 0.0 : p->d.sum / p->d.count;
+}
+
+quint64
+AVHistogram::percentile(qreal percentile) const
+{
+    Q_ASSERT("percentile must be within 0 and 100" && percentile >= 0.0 && percentile <= 100.0);
+
+    if (is_empty()) {
+        return 0;
+    }
+    // highest value equivalent to the bucket holding the rank, clamped to the recorded range
+    quint64 rank = qMax(static_cast<quint64>(std::ceil(percentile / 100.0 * p->d.count)), quint64(1));
+    quint64 count = 0;
+    for (qsizetype i = 0; i < p->d.counts.size(); i++) {
+        count += p->d.counts[i];
+        if (count >= rank) {
+            return qBound(p->d.min, highest(i), p->d.max);
+        }
+    }
+    return p->d.max;
+}
+
+QString
+AVHistogram::to_string() const
+{
+    return QString("count: %1, min: %2, p50: %3, p99: %4, p99.9: %5, max: %6, mean: %7")
+        .arg(count())
+        .arg(min())
+        .arg(percentile(50.0))
+        .arg(percentile(99.0))
+        .arg(percentile(99.9))
+        .arg(max())
+        .arg(mean(), 0, 'f', 1);
+}
+
+bool
+AVHistogram::is_empty() const
+{
+    return p->d.count == 0;
+}
+
+void
+AVHistogram::reserve()
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    if (p->d.counts.isEmpty()) {
+        p->d.counts.resize(buckets);
+    }
+}
+
+void
+AVHistogram::record(quint64 value, quint64 count)
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    if (p->d.counts.isEmpty()) {
+        p->d.counts.resize(buckets);
+    }
+    p->d.counts[index(value)] += count;
+    p->d.count += count;
+    p->d.min = qMin(p->d.min, value);
+    p->d.max = qMax(p->d.max, value);
+    p->d.sum += static_cast<qreal>(value) * count;
+}
+
+void
+AVHistogram::merge(const AVHistogram& other)
+{
+    if (other.is_empty()) {
+        return;
+    }
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    if (p->d.counts.isEmpty()) {
+        p->d.counts.resize(buckets);
+    }
+    for (qsizetype i = 0; i < buckets; i++) {
+        p->d.counts[i] += other.p->d.counts[i];
+    }
+    p->d.count += other.p->d.count;
+    p->d.min = qMin(p->d.min, other.p->d.min);
+    p->d.max = qMax(p->d.max, other.p->d.max);
+    p->d.sum += other.p->d.sum;
+}
+
+void
+AVHistogram::reset()
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->d.counts.fill(0);
+    p->d.count = 0;
+    p->d.min = std::numeric_limits<quint64>::max();
+    p->d.max = 0;
+    p->d.sum = 0.0;
+}
+
+AVHistogram&
+AVHistogram::operator=(const AVHistogram& other)
+{
+    if (this != &other) {
+        p = other.p;
+    }
+    return *this;
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include <QExplicitlySharedDataPointer>
+#include <QString>
+#include <QtAlgorithms>
+
+class AVHistogramPrivate;
+class AVHistogram
+{
+    public:
+        AVHistogram();
+        AVHistogram(const AVHistogram& other);
+        ~AVHistogram();
+        quint64 count() const;
+        quint64 count(quint64 above) const; // in buckets above the value
+        quint64 min() const;
+        quint64 max() const;
+        qreal mean() const;
+        quint64 percentile(qreal percentile) const;
+        QString to_string() const;
+        bool is_empty() const;
+        void reserve(); // allocates the buckets up front, recording never allocates after
+        void record(quint64 value, quint64 count = 1);
+        void merge(const AVHistogram& other);
+        void reset();
+
+        AVHistogram& operator=(const AVHistogram& other);
+
+        static constexpr int precision = 5; // 32 sub buckets per power of two, within 3.2% of the value
+        static constexpr qsizetype buckets = (64 - precision + 1) << precision;
+        static constexpr qsizetype index(quint64 value) {
+            int msb = 63 - static_cast<int>(qCountLeadingZeroBits(value | 1));
+            qsizetype shift = qMax(msb - precision, 0);
+            return (shift << precision) + static_cast<qsizetype>(value >> shift);
+        }
+        static constexpr quint64 lowest(qsizetype index) {
+            qsizetype shift = qMax((index >> precision) - 1, qsizetype(0));
+            return static_cast<quint64>(index - (shift << precision)) << shift;
+        }
+        static constexpr quint64 highest(qsizetype index) {
+            qsizetype shift = qMax((index >> precision) - 1, qsizetype(0));
+            return lowest(index) + ((quint64(1) << shift) - 1);
+        }
+
+    private:
+        QExplicitlySharedDataPointer<AVHistogramPrivate> p;
+};
@@ -0,0 +1,494 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avltc.h"
+#include "avmath.h"
+
+#include <QFile>
+#include <QtAlgorithms>
+#include <QtEndian>
+
+#include <QDebug>
+
+namespace {
+    constexpr quint16 syncword = 0xBFFC; // bits 64 to 79, 0011 1111 1111 1101 in transmission order
+    constexpr quint16 reversesyncword = 0x3FFD; // sync word of audio played backwards
+    constexpr int wordbits = 80;
+}
+
+class AVLtcEncoderPrivate
+{
+    public:
+        AVLtcEncoderPrivate();
+        qint64 edge(qint64 halfbit) const;
+        template <typename T>
+        qsizetype encode(const AVSmpteWord& word, QSpan<T> buffer, T high);
+        struct Data
+        {
+            AVFps fps;
+            qint32 samplerate = 0;
+            qint64 frame = 0;
+            qreal amplitude = 0.5; // -6 dBFS
+            bool level = false;
+        };
+        Data d;
+};
+
+AVLtcEncoderPrivate::AVLtcEncoderPrivate()
+{
+}
+
+qint64
+AVLtcEncoderPrivate::edge(qint64 halfbit) const
+{
+    // exact sample of each half bit, fractional rates spread the remainder over the frames
+    return AVMath::muldiv_floor(halfbit, qint64(d.samplerate) * d.fps.denominator(), d.fps.numerator() * wordbits * 2);
+}
+
+template <typename T>
+qsizetype
+AVLtcEncoderPrivate::encode(const AVSmpteWord& word, QSpan<T> buffer, T high)
+{
+    qint64 halfbit = d.frame * wordbits * 2;
+    qint64 origin = edge(halfbit);
+    qsizetype count = edge(halfbit + wordbits * 2) - origin;
+    Q_ASSERT("buffer is smaller than a frame" && buffer.size() >= count);
+    if (buffer.size() < count) {
+        return 0;
+    }
+    quint64 bits = AVLtcEncoder::polarity(word, d.fps).bits();
+    qsizetype from = 0;
+    auto fill = [&](qsizetype to) {
+        T value = d.level ? high : static_cast<T>(-high);
+        while (from < to) {
+            buffer[from++] = value;
+        }
+    };
+    for (int bit = 0; bit < wordbits; bit++) {
+        bool one = bit < 64 ? (bits >> bit) & 1 : (syncword >> (bit - 64)) & 1;
+        d.level = !d.level; // biphase mark, a transition at every bit boundary
+        fill(edge(halfbit + 1) - origin);
+        if (one) {
+            d.level = !d.level; // and one in the middle of each one bit
+        }
+        fill(edge(halfbit + 2) - origin);
+        halfbit += 2;
+    }
+    d.frame++;
+    return count;
+}
+
+class AVLtcDecoderPrivate
+{
+    public:
+        AVLtcDecoderPrivate();
+        void reset();
+        void sample(float value);
+        void edge(double position);
+        void bit(bool one, double start, double end);
+        template <typename T>
+        qsizetype decode(QSpan<const T> samples, float scale, QList<AVLtcFrame>& frames);
+        static quint64 reverse(quint64 bits);
+        struct Data
+        {
+            AVFps fps;
+            qint32 samplerate = 0;
+            qint64 position = 0;
+            float previous = 0.0f;
+            float high = 0.0f; // envelope, the threshold follows dc offsets and level changes
+            float low = 0.0f;
+            float decay = 0.0f;
+            bool level = false;
+            bool half = false;
+            bool synced = false; // an edge has been seen
+            double edge = 0.0;
+            double start = 0.0; // start of the bit when waiting for its second half
+            double nominal = 0.0; // samples per bit at play speed
+            double period = 0.0; // samples per bit, follows varispeed and shuttle
+            quint128 bits = 0; // last 80 bits, the most recent in bit 79
+            qint64 count = 0; // bits since last sync loss
+            double starts[wordbits];
+            QList<AVLtcFrame>* frames = nullptr;
+            QString errormessage;
+            AVLtcDecoder::Error error = AVLtcDecoder::NO_ERROR;
+        };
+        Data d;
+};
+
+AVLtcDecoderPrivate::AVLtcDecoderPrivate()
+{
+}
+
+void
+AVLtcDecoderPrivate::reset()
+{
+    d.position = 0;
+    d.previous = 0.0f;
+    d.high = 0.0f;
+    d.low = 0.0f;
+    d.decay = d.samplerate > 0 ? 20.0f / d.samplerate : 0.0f; // envelope falls back over 50 ms
+    d.level = false;
+    d.half = false;
+    d.synced = false;
+    d.edge = 0.0;
+    d.nominal = d.fps.valid() ? static_cast<double>(d.samplerate) * d.fps.denominator() / (d.fps.numerator() * wordbits) : 0.0;
+    d.period = d.nominal;
+    d.bits = 0;
+    d.count = 0;
+}
+
+void
+AVLtcDecoderPrivate::sample(float value)
+{
+    d.high = value > d.high ? value : d.high - (d.high - d.low) * d.decay;
+    d.low = value < d.low ? value : d.low + (d.high - d.low) * d.decay;
+    float swing = d.high - d.low;
+    float middle = (d.high + d.low) * 0.5f;
+    float hysteresis = swing * 0.1f;
+    if (swing > 0.01f) { // ignore silence and noise below -46 dBFS
+        if (d.level ? value < middle - hysteresis : value > middle + hysteresis) {
+            d.level = !d.level;
+            double position = d.position;
+            if (d.previous != value) { // interpolate the crossing between samples
+                position += qBound(0.0, static_cast<double>((d.previous - middle) / (d.previous - value)), 1.0) - 1.0;
+            }
+            edge(position);
+        }
+    }
+    d.previous = value;
+    d.position++;
+}
+
+void
+AVLtcDecoderPrivate::edge(double position)
+{
+    double interval = position - d.edge;
+    double start = d.edge;
+    d.edge = position;
+    if (!d.synced || interval > d.period * 1.75) { // first edge or dropout, wait for the next word
+        d.synced = true;
+        d.half = false;
+        d.count = 0;
+        return;
+    }
+    if (interval < d.period * 0.75) {
+        d.period += (interval * 2.0 - d.period) * 0.1;
+        if (d.half) {
+            d.half = false;
+            bit(true, d.start, position);
+        }
+        else {
+            d.half = true;
+            d.start = start;
+        }
+    }
+    else {
+        d.period += (interval - d.period) * 0.1;
+        if (d.half) { // lost bit phase, the pending half was the end of a zero
+            d.half = false;
+            d.count = 0;
+        }
+        bit(false, start, position);
+    }
+    d.period = qBound(d.nominal * 0.25, d.period, d.nominal * 4.0);
+}
+
+void
+AVLtcDecoderPrivate::bit(bool one, double start, double end)
+{
+    d.bits = (d.bits >> 1) | (static_cast<quint128>(one) << (wordbits - 1));
+    d.starts[d.count % wordbits] = start;
+    if (++d.count < wordbits) {
+        return;
+    }
+    AVLtcFrame frame;
+    if (static_cast<quint16>(d.bits >> 64) == syncword) {
+        frame.word = AVSmpteWord(static_cast<quint64>(d.bits));
+    }
+    else if (static_cast<quint16>(d.bits) == reversesyncword) {
+        frame.word = AVSmpteWord(reverse(static_cast<quint64>(d.bits >> 16)));
+        frame.reverse = true;
+    }
+    else {
+        return;
+    }
+    if (frame.word.valid()) {
+        frame.start = qRound64(d.starts[d.count % wordbits]); // oldest of the last 80 bits
+        frame.end = qRound64(end);
+        d.frames->append(frame);
+    }
+}
+
+template <typename T>
+qsizetype
+AVLtcDecoderPrivate::decode(QSpan<const T> samples, float scale, QList<AVLtcFrame>& frames)
+{
+    Q_ASSERT("samplerate is not valid" && d.nominal > 0.0);
+
+    qsizetype count = frames.size();
+    d.frames = &frames;
+    for (T value : samples) {
+        sample(value * scale);
+    }
+    d.frames = nullptr;
+    return frames.size() - count;
+}
+
+quint64
+AVLtcDecoderPrivate::reverse(quint64 bits)
+{
+    quint64 reversed = 0;
+    for (int bit = 0; bit < 64; bit++) {
+        reversed = (reversed << 1) | ((bits >> bit) & 1);
+    }
+    return reversed;
+}
+
+AVLtcEncoder::AVLtcEncoder(const AVFps& fps, qint32 samplerate)
+: p(new AVLtcEncoderPrivate())
+{
+    Q_ASSERT("ltc supports up to 30 fps" && fps.frame_quanta() <= 30);
+    Q_ASSERT("samplerate is not valid" && samplerate > 0);
+
+    p->d.fps = fps;
+    p->d.samplerate = samplerate;
+}
+
+AVLtcEncoder::~AVLtcEncoder()
+{
+}
+
+AVFps
+AVLtcEncoder::fps() const
+{
+    return p->d.fps;
+}
+
+qint32
+AVLtcEncoder::samplerate() const
+{
+    return p->d.samplerate;
+}
+
+qreal
+AVLtcEncoder::amplitude() const
+{
+    return p->d.amplitude;
+}
+
+qint64
+AVLtcEncoder::position() const
+{
+    return p->edge(p->d.frame * wordbits * 2);
+}
+
+qsizetype
+AVLtcEncoder::samples() const
+{
+    qint64 halfbit = p->d.frame * wordbits * 2;
+    return p->edge(halfbit + wordbits * 2) - p->edge(halfbit);
+}
+
+qsizetype
+AVLtcEncoder::encode(const AVSmpteWord& word, QSpan<float> buffer)
+{
+    return p->encode(word, buffer, static_cast<float>(p->d.amplitude));
+}
+
+qsizetype
+AVLtcEncoder::encode(const AVSmpteWord& word, QSpan<qint16> buffer)
+{
+    return p->encode(word, buffer, static_cast<qint16>(qRound(p->d.amplitude * 32767)));
+}
+
+void
+AVLtcEncoder::set_amplitude(qreal amplitude)
+{
+    p->d.amplitude = qBound(0.0, amplitude, 1.0);
+}
+
+void
+AVLtcEncoder::reset()
+{
+    p->d.frame = 0;
+    p->d.level = false;
+}
+
+qsizetype
+AVLtcEncoder::max_samples(const AVFps& fps, qint32 samplerate)
+{
+    qint64 samples = qint64(samplerate) * fps.denominator();
+    return (samples + fps.numerator() - 1) / fps.numerator();
+}
+
+AVSmpteWord
+AVLtcEncoder::polarity(const AVSmpteWord& word, const AVFps& fps)
+{
+    // polarity correction keeps an even number of zeros, every word then starts on the same edge
+    quint64 bit = 1ULL << (fps.frame_quanta() == 25 ? 59 : 27);
+    quint64 bits = word.bits() & ~bit;
+    int zeros = 64 - qPopulationCount(bits) + 3; // sync word has three zeros
+    return AVSmpteWord(zeros % 2 ? bits | bit : bits);
+}
+
+AVLtcDecoder::AVLtcDecoder(const AVFps& fps, qint32 samplerate)
+: p(new AVLtcDecoderPrivate())
+{
+    Q_ASSERT("ltc supports up to 30 fps" && fps.frame_quanta() <= 30);
+
+    p->d.fps = fps;
+    p->d.samplerate = samplerate;
+    p->reset();
+}
+
+AVLtcDecoder::~AVLtcDecoder()
+{
+}
+
+AVFps
+AVLtcDecoder::fps() const
+{
+    return p->d.fps;
+}
+
+qint32
+AVLtcDecoder::samplerate() const
+{
+    return p->d.samplerate;
+}
+
+qint64
+AVLtcDecoder::position() const
+{
+    return p->d.position;
+}
+
+qsizetype
+AVLtcDecoder::decode(QSpan<const float> samples, QList<AVLtcFrame>& frames)
+{
+    return p->decode(samples, 1.0f, frames);
+}
+
+qsizetype
+AVLtcDecoder::decode(QSpan<const qint16> samples, QList<AVLtcFrame>& frames)
+{
+    return p->decode(samples, 1.0f / 32768, frames);
+}
+
+qsizetype
+AVLtcDecoder::decode(const QString& filename, QList<AVLtcFrame>& frames, qint32 channel)
+{
+    p->d.error = AVLtcDecoder::NO_ERROR;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        p->d.error = AVLtcDecoder::FILE_ERROR;
+        p->d.errormessage = QString("unable to open wav file: %1").arg(filename);
+        qWarning() << "warning: " << p->d.errormessage;
+        return 0;
+    }
+    QByteArray riff = file.read(12);
+    if (riff.size() < 12 || !riff.startsWith("RIFF") || riff.mid(8, 4) != "WAVE") {
+        p->d.error = AVLtcDecoder::FORMAT_ERROR;
+        p->d.errormessage = QString("file is not a riff wave file: %1").arg(filename);
+        qWarning() << "warning: " << p->d.errormessage;
+        return 0;
+    }
+    quint16 format = 0;
+    quint16 channels = 0;
+    quint16 bitspersample = 0;
+    quint32 samplerate = 0;
+    qint64 datasize = -1;
+    while (datasize < 0) {
+        QByteArray chunk = file.read(8);
+        if (chunk.size() < 8) {
+            break;
+        }
+        quint32 size = qFromLittleEndian<quint32>(chunk.constData() + 4);
+        if (chunk.startsWith("fmt ")) {
+            QByteArray fmt = file.read(size);
+            if (fmt.size() >= 16) {
+                format = qFromLittleEndian<quint16>(fmt.constData());
+                channels = qFromLittleEndian<quint16>(fmt.constData() + 2);
+                samplerate = qFromLittleEndian<quint32>(fmt.constData() + 4);
+                bitspersample = qFromLittleEndian<quint16>(fmt.constData() + 14);
+                if (format == 0xfffe && fmt.size() >= 26) { // extensible, format is the start of the subformat guid
+                    format = qFromLittleEndian<quint16>(fmt.constData() + 24);
+                }
+            }
+            file.seek(file.pos() + (size & 1));
+        }
+        else if (chunk.startsWith("data")) {
+            datasize = size;
+        }
+        else {
+            file.seek(file.pos() + size + (size & 1)); // chunks are word aligned
+        }
+    }
+    bool pcm = format == 1 && (bitspersample == 8 || bitspersample == 16 || bitspersample == 24 || bitspersample == 32);
+    bool floating = format == 3 && bitspersample == 32;
+    if (datasize < 0 || (!pcm && !floating) || channel < 0 || channel >= channels || samplerate == 0) {
+        p->d.error = AVLtcDecoder::FORMAT_ERROR;
+        p->d.errormessage = QString("unsupported wav format %1 with %2 bits and %3 channels: %4")
+            .arg(format).arg(bitspersample).arg(channels).arg(filename);
+        qWarning() << "warning: " << p->d.errormessage;
+        return 0;
+    }
+    p->d.samplerate = samplerate; // decode at the rate of the file
+    p->reset();
+
+    qsizetype count = frames.size();
+    qint64 bytes = bitspersample / 8;
+    qint64 stride = channels * bytes;
+    qint64 remaining = datasize / stride;
+    QList<float> samples(4096);
+    while (remaining > 0) {
+        QByteArray block = file.read(qMin<qint64>(remaining, samples.size()) * stride);
+        qint64 length = block.size() / stride;
+        if (length == 0) {
+            break;
+        }
+        const char* data = block.constData() + channel * bytes;
+        for (qint64 i = 0; i < length; i++, data += stride) {
+            float sample = 0.0f;
+            if (floating) {
+                sample = qFromLittleEndian<float>(data);
+            }
+            else if (bytes == 1) {
+                sample = (static_cast<quint8>(*data) - 128) / 128.0f;
+            }
+            else if (bytes == 2) {
+                sample = qFromLittleEndian<qint16>(data) / 32768.0f;
+            }
+            else if (bytes == 3) {
+                qint32 value = static_cast<qint32>(static_cast<quint32>(qFromLittleEndian<quint16>(data)) << 8 |
+                    static_cast<quint32>(static_cast<quint8>(data[2])) << 24) >> 8;
+                sample = value / 8388608.0f;
+            }
+            else {
+                sample = qFromLittleEndian<qint32>(data) / 2147483648.0f;
+            }
+            samples[i] = sample;
+        }
+        p->decode(QSpan<const float>(samples.constData(), length), 1.0f, frames);
+        remaining -= length;
+    }
+    return frames.size() - count;
+}
+
+void
+AVLtcDecoder::reset()
+{
+    p->reset();
+}
+
+AVLtcDecoder::Error
+AVLtcDecoder::error() const
+{
+    return p->d.error;
+}
+
+QString
+AVLtcDecoder::error_message() const
+{
+    return p->d.errormessage;
+}
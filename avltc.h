@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avfps.h"
+#include "avsmptetime.h"
+
+#include <QList>
+#include <QScopedPointer>
+#include <QSpan>
+#include <QString>
+
+struct AVLtcFrame
+{
+    AVSmpteWord word;
+    qint64 start = 0; // sample of the first transition, in stream order
+    qint64 end = 0; // sample of the last transition
+    bool reverse = false; // decoded from audio played backwards
+};
+
+class AVLtcEncoderPrivate;
+class AVLtcEncoder
+{
+    public:
+        AVLtcEncoder(const AVFps& fps, qint32 samplerate);
+        ~AVLtcEncoder();
+        AVFps fps() const;
+        qint32 samplerate() const;
+        qreal amplitude() const;
+        qint64 position() const;
+        qsizetype samples() const;
+        qsizetype encode(const AVSmpteWord& word, QSpan<float> buffer);
+        qsizetype encode(const AVSmpteWord& word, QSpan<qint16> buffer);
+        void set_amplitude(qreal amplitude);
+        void reset();
+
+        static qsizetype max_samples(const AVFps& fps, qint32 samplerate);
+        static AVSmpteWord polarity(const AVSmpteWord& word, const AVFps& fps);
+
+    private:
+        QScopedPointer<AVLtcEncoderPrivate> p;
+};
+
+class AVLtcDecoderPrivate;
+class AVLtcDecoder
+{
+    public:
+        enum Error { NO_ERROR, FILE_ERROR, FORMAT_ERROR };
+
+    public:
+        AVLtcDecoder(const AVFps& fps, qint32 samplerate);
+        ~AVLtcDecoder();
+        AVFps fps() const;
+        qint32 samplerate() const;
+        qint64 position() const;
+        qsizetype decode(QSpan<const float> samples, QList<AVLtcFrame>& frames);
+        qsizetype decode(QSpan<const qint16> samples, QList<AVLtcFrame>& frames);
+        qsizetype decode(const QString& filename, QList<AVLtcFrame>& frames, qint32 channel = 0);
+        void reset();
+        AVLtcDecoder::Error error() const;
+        QString error_message() const;
+
+    private:
+        QScopedPointer<AVLtcDecoderPrivate> p;
+};
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <limits>
+
+class AVMath
+{
+    public:
+        static constexpr qint64 gcd(qint64 a, qint64 b) {
+            a = a < 0 ? -a : a;
+            b = b < 0 ? -b : b;
+            while (b) {
+                qint64 t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
+        // value * numerator / denominator with a 128-bit intermediate, rounds half away from zero
+        static constexpr qint64 muldiv(qint64 value, qint64 numerator, qint64 denominator) {
+            Q_ASSERT("denominator is zero" && denominator != 0);
+            if (!denominator) {
+                return 0;
+            }
+            qint128 product = static_cast<qint128>(value) * numerator;
+            qint128 quotient = product / denominator;
+            qint128 remainder = product % denominator;
+            if (remainder != 0) {
+                qint128 twice = remainder < 0 ? -remainder * 2 : remainder * 2;
+                qint128 divisor = denominator < 0 ? -static_cast<qint128>(denominator) : denominator;
+                if (twice >= divisor) {
+                    quotient += ((product < 0) != (denominator < 0)) ? -1 : 1;
+                }
+            }
+            return static_cast<qint64>(quotient);
+        }
+        // value * numerator / denominator for compile-time ratios, multiply and shift when the product fits 64 bits
+        template <qint64 Numerator, qint64 Denominator>
+        static constexpr qint64 muldiv(qint64 value) {
+            static_assert(Numerator > 0 && Denominator > 0, "ratio must be positive");
+            constexpr qint64 divisor = gcd(Numerator, Denominator);
+            constexpr qint64 numerator = Numerator / divisor;
+            constexpr qint64 denominator = Denominator / divisor;
+            constexpr qint64 limit = (std::numeric_limits<qint64>::max() - denominator / 2) / numerator;
+            if (value > limit || value < -limit) {
+                return muldiv(value, numerator, denominator);
+            }
+            qint64 product = value * numerator;
+            if constexpr (denominator == 1) {
+                return product;
+            }
+            return product < 0 ? -((denominator / 2 - product) / denominator) : (product + denominator / 2) / denominator;
+        }
+        // value * numerator / denominator with a 128-bit intermediate, rounds towards negative infinity
+        static constexpr qint64 muldiv_floor(qint64 value, qint64 numerator, qint64 denominator) {
+            Q_ASSERT("denominator is zero" && denominator != 0);
+            if (!denominator) {
+                return 0;
+            }
+            qint128 product = static_cast<qint128>(value) * numerator;
+            qint128 quotient = product / denominator;
+            if ((product % denominator != 0) && ((product < 0) != (denominator < 0))) {
+                quotient -= 1;
+            }
+            return static_cast<qint64>(quotient);
+        }
+        // sign of a / b - c / d for positive denominators b and d
+        static constexpr int compare(qint64 a, qint64 b, qint64 c, qint64 d) {
+            qint128 lhs = static_cast<qint128>(a) * d;
+            qint128 rhs = static_cast<qint128>(c) * b;
+            return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+        }
+};
@@ -0,0 +1,496 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avpatternbackend.h"
+
+#include <QColor>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+
+#include <QDebug>
+
+#include <cstring>
+
+namespace {
+    // bars at the top, a strip of moving bars, ramps and a bottom band with the barcode left and noise right
+    struct Layout
+    {
+        int strip;
+        int ramps;
+        int bottom;
+        int codewidth;
+        int cell;
+    };
+    constexpr int cells = 34; // start cell, 32 bits msb first, stop cell
+    constexpr int tile = 256; // noise tile, repeated across the band
+
+    Layout
+    layout(const QSize& size)
+    {
+        Layout layout;
+        layout.strip = size.height() / 2;
+        layout.ramps = layout.strip + size.height() / 8;
+        layout.bottom = size.height() * 7 / 8;
+        layout.codewidth = size.width() / 2;
+        layout.cell = layout.codewidth / cells;
+        return layout;
+    }
+
+    struct Format
+    {
+        const char* token;
+        QImage::Format format;
+    };
+    constexpr Format formats[] = {
+        { "rgba8", QImage::Format_RGBA8888 },
+        { "rgbx8", QImage::Format_RGBX8888 },
+        { "argb32", QImage::Format_ARGB32 },
+        { "rgb32", QImage::Format_RGB32 },
+        { "rgba16", QImage::Format_RGBA64 },
+        { "rgbx16", QImage::Format_RGBX64 },
+        { "rgba16f", QImage::Format_RGBA16FPx4 },
+        { "rgba32f", QImage::Format_RGBA32FPx4 }
+    };
+
+    QString
+    token(QImage::Format image)
+    {
+        for (const Format& format : formats) {
+            if (format.format == image) {
+                return format.token;
+            }
+        }
+        return QString();
+    }
+
+    QRgba64
+    color(qreal red, qreal green, qreal blue)
+    {
+        return qRgba64(qRound(red * 65535), qRound(green * 65535), qRound(blue * 65535), 65535);
+    }
+
+    QByteArray
+    pixel(const QRgba64& rgba, QImage::Format format)
+    {
+        QImage image(1, 1, QImage::Format_RGBA64);
+        image.setPixelColor(0, 0, QColor(rgba));
+        image = image.convertToFormat(format);
+        return QByteArray(reinterpret_cast<const char*>(image.constScanLine(0)), image.depth() / 8);
+    }
+
+    void
+    fill(uchar* data, const QByteArray& pixel, int count)
+    {
+        for (int i = 0; i < count; i++) {
+            std::memcpy(data, pixel.constData(), pixel.size());
+            data += pixel.size();
+        }
+    }
+}
+
+class AVPatternBackendPrivate
+{
+    public:
+        AVPatternBackendPrivate();
+        bool open();
+        void close();
+        bool parse();
+        void render();
+        void stamp(QImage& image, qint64 frame) const;
+        AVTime time(qint64 frame) const;
+        bool fail(AVReader::Error error, const QString& message);
+        struct Data
+        {
+            QSize size = QSize(1920, 1080);
+            QImage::Format format = QImage::Format_RGBA8888;
+            AVFps fps = AVFps::fps_24();
+            qint64 count = 24 * 60;
+            AVBackend::Info info;
+            QImage base; // static bars and ramps
+            QImage strip; // one row of bars, two periods wide so any offset is a single copy
+            QImage noise; // two tiles wide for the same reason
+            QByteArray white;
+            QByteArray black;
+            AVFramePool pool; // frames, recycled once the reader and the cache release them
+            qint64 frame = 0;
+            QString filename;
+            QString errormessage;
+            AVReader::Error error = AVReader::NO_ERROR;
+        };
+        Data d;
+};
+
+AVPatternBackendPrivate::AVPatternBackendPrivate()
+{
+}
+
+bool
+AVPatternBackendPrivate::fail(AVReader::Error error, const QString& message)
+{
+    d.error = error;
+    d.errormessage = message;
+    qWarning() << "warning: " << d.errormessage;
+    return false;
+}
+
+bool
+AVPatternBackendPrivate::parse()
+{
+    static const QRegularExpression size("^(\\d+)x(\\d+)$");
+    static const QRegularExpression rate("^(\\d+(?:\\.\\d+)?)fps$");
+    static const QRegularExpression seconds("^(\\d+(?:\\.\\d+)?)s$");
+    static const QRegularExpression frames("^(\\d+)f$");
+    qreal duration = -1.0;
+    const QList<QString> tokens = QFileInfo(d.filename).completeBaseName().toLower().split('_');
+    for (const QString& token : tokens) {
+        QRegularExpressionMatch match;
+        if ((match = size.match(token)).hasMatch()) {
+            d.size = QSize(match.captured(1).toInt(), match.captured(2).toInt());
+        }
+        else if ((match = rate.match(token)).hasMatch()) {
+            d.fps = AVFps::guess(match.captured(1).toDouble());
+        }
+        else if ((match = seconds.match(token)).hasMatch()) {
+            duration = match.captured(1).toDouble();
+        }
+        else if ((match = frames.match(token)).hasMatch()) {
+            d.count = match.captured(1).toLongLong();
+        }
+        else {
+            for (const Format& format : formats) {
+                if (token == format.token) {
+                    d.format = format.format;
+                }
+            }
+        }
+    }
+    if (!d.fps.valid()) {
+        return fail(AVReader::FILE_ERROR, QString("invalid pattern fps: %1").arg(d.filename));
+    }
+    if (duration >= 0.0) { // seconds need the rate, whichever order the tokens came in
+        d.count = qRound64(duration / d.fps.seconds());
+    }
+    QSize max = AVPatternBackend::max_size();
+    if (d.size.width() < 128 || d.size.height() < 32 || d.size.width() > max.width() || d.size.height() > max.height()) {
+        return fail(AVReader::FILE_ERROR, QString("unsupported pattern size %1x%2, 128x32 to %3x%4: %5")
+                                              .arg(d.size.width()).arg(d.size.height())
+                                              .arg(max.width()).arg(max.height()).arg(d.filename));
+    }
+    if (d.count <= 0) {
+        return fail(AVReader::FILE_ERROR, QString("pattern has no frames: %1").arg(d.filename));
+    }
+    if (token(d.format).isEmpty()) {
+        return fail(AVReader::FILE_ERROR, QString("unsupported pattern image format %1: %2").arg(d.format).arg(d.filename));
+    }
+    return true;
+}
+
+bool
+AVPatternBackendPrivate::open()
+{
+    if (!parse()) {
+        return false;
+    }
+    render();
+    qint32 timescale = d.fps.frame_quanta() * 1000;
+    AVTime start(0, timescale, d.fps);
+    d.info.title = QFileInfo(d.filename).completeBaseName();
+    d.info.fps = d.fps;
+    d.info.start = start;
+    d.info.range = AVTimeRange(start, AVTime(start, start.ticks(d.count)));
+    d.info.metadata.add_pair("media type", "test pattern");
+    d.info.metadata.add_pair("resolution", QString("%1x%2").arg(d.size.width()).arg(d.size.height()));
+    d.info.metadata.add_pair("format", token(d.format));
+    d.info.metadata.add_pair("frames", QString::number(d.count));
+    d.frame = 0;
+    return true;
+}
+
+void
+AVPatternBackendPrivate::close()
+{
+    d.info = AVBackend::Info();
+    d.base = QImage();
+    d.strip = QImage();
+    d.noise = QImage();
+    d.pool.clear();
+    d.frame = 0;
+    d.errormessage = QString();
+    d.error = AVReader::NO_ERROR;
+}
+
+void
+AVPatternBackendPrivate::render()
+{
+    // everything is drawn once in RGBA64 and converted, generation cost is paid at open
+    const int width = d.size.width();
+    const int height = d.size.height();
+    const Layout l = layout(d.size);
+    const QRgba64 bars[] = {
+        color(0.75, 0.75, 0.75), color(0.75, 0.75, 0.0), color(0.0, 0.75, 0.75), color(0.0, 0.75, 0.0),
+        color(0.75, 0.0, 0.75), color(0.75, 0.0, 0.0), color(0.0, 0.0, 0.75), color(0.0, 0.0, 0.0)
+    };
+    QImage base(width, height, QImage::Format_RGBA64);
+    base.fill(Qt::black);
+    QRgba64* row = reinterpret_cast<QRgba64*>(base.scanLine(0));
+    for (int x = 0; x < width; x++) {
+        row[x] = bars[x * 8 / width];
+    }
+    for (int y = 1; y < l.strip; y++) {
+        std::memcpy(base.scanLine(y), row, width * sizeof(QRgba64));
+    }
+    for (int y = l.ramps; y < l.bottom; y++) {
+        int ramp = (y - l.ramps) * 4 / (l.bottom - l.ramps); // gray, red, green, blue
+        QRgba64* line = reinterpret_cast<QRgba64*>(base.scanLine(y));
+        for (int x = 0; x < width; x++) {
+            quint16 value = static_cast<quint16>(static_cast<qint64>(x) * 65535 / (width - 1));
+            line[x] = qRgba64(ramp == 0 || ramp == 1 ? value : 0, ramp == 0 || ramp == 2 ? value : 0,
+                              ramp == 0 || ramp == 3 ? value : 0, 65535);
+        }
+    }
+    d.base = base.convertToFormat(d.format);
+
+    QImage strip(width * 2, 1, QImage::Format_RGBA64);
+    QRgba64* line = reinterpret_cast<QRgba64*>(strip.scanLine(0));
+    for (int x = 0; x < width * 2; x++) {
+        line[x] = bars[7 - (x % width) * 8 / width]; // reversed, the motion is visible against the bars above
+    }
+    d.strip = strip.convertToFormat(d.format);
+
+    QImage noise(tile * 2, tile, QImage::Format_RGBA64);
+    QRandomGenerator random(1);
+    for (int y = 0; y < tile; y++) {
+        QRgba64* texels = reinterpret_cast<QRgba64*>(noise.scanLine(y));
+        for (int x = 0; x < tile; x++) {
+            quint16 value = static_cast<quint16>(random.bounded(65536));
+            texels[x] = texels[x + tile] = qRgba64(value, value, value, 65535);
+        }
+    }
+    d.noise = noise.convertToFormat(d.format);
+    d.white = pixel(color(1.0, 1.0, 1.0), d.format);
+    d.black = pixel(color(0.0, 0.0, 0.0), d.format);
+}
+
+void
+AVPatternBackendPrivate::stamp(QImage& image, qint64 frame) const
+{
+    // every pixel outside the static regions is rewritten, read copies those from the base
+    const int width = d.size.width();
+    const int height = d.size.height();
+    const qsizetype bytes = image.depth() / 8;
+    const Layout l = layout(d.size);
+    qint64 offset = (frame * qMax(1, width / 96)) % width;
+    uchar* first = image.scanLine(l.strip);
+    std::memcpy(first, d.strip.constScanLine(0) + offset * bytes, width * bytes);
+    for (int y = l.strip + 1; y < l.ramps; y++) {
+        std::memcpy(image.scanLine(y), first, width * bytes);
+    }
+    first = image.scanLine(l.bottom);
+    for (int i = 0; i < cells; i++) {
+        bool on = i == 0 || (i < cells - 1 && ((frame >> (cells - 2 - i)) & 1));
+        fill(first + i * l.cell * bytes, on ? d.white : d.black, l.cell);
+    }
+    fill(first + cells * l.cell * bytes, d.black, l.codewidth - cells * l.cell);
+    for (int y = l.bottom + 1; y < height; y++) {
+        std::memcpy(image.scanLine(y), first, l.codewidth * bytes);
+    }
+    quint32 hash = static_cast<quint32>(frame) * 2654435761u; // deterministic, a seek shows the same noise
+    int x0 = hash % tile;
+    int y0 = (hash >> 16) % tile;
+    for (int y = l.bottom; y < height; y++) {
+        const uchar* source = d.noise.constScanLine((y0 + y) % tile) + x0 * bytes;
+        uchar* data = image.scanLine(y) + l.codewidth * bytes;
+        for (int remaining = width - l.codewidth; remaining > 0; remaining -= tile) {
+            int count = qMin(tile, remaining);
+            std::memcpy(data, source, count * bytes);
+            data += count * bytes;
+        }
+    }
+}
+
+AVTime
+AVPatternBackendPrivate::time(qint64 frame) const
+{
+    return AVTime(d.info.start, d.info.start.ticks(frame));
+}
+
+AVPatternBackend::AVPatternBackend()
+: p(new AVPatternBackendPrivate())
+{
+}
+
+AVPatternBackend::~AVPatternBackend()
+{
+}
+
+QString
+AVPatternBackend::name() const
+{
+    return "pattern";
+}
+
+bool
+AVPatternBackend::probe(const QString& filename) const
+{
+    Q_UNUSED(filename);
+    return true;
+}
+
+bool
+AVPatternBackend::open(const QString& filename)
+{
+    p->close();
+    p->d.filename = filename;
+    return p->open();
+}
+
+void
+AVPatternBackend::close()
+{
+    p->close();
+}
+
+bool
+AVPatternBackend::seek(const AVTime& time)
+{
+    if (p->d.base.isNull()) {
+        return p->fail(AVReader::API_ERROR, "unable to seek, no pattern is open");
+    }
+    p->d.frame = qBound(qint64(0), time.frames(), p->d.count - 1);
+    return true;
+}
+
+bool
+AVPatternBackend::read(QImage& image, AVTime& time)
+{
+    if (p->d.frame >= p->d.count) {
+        return p->fail(AVReader::API_ERROR, "unable to read frame past the end of the pattern");
+    }
+    image = p->d.pool.image(p->d.size, p->d.format);
+    if (image.isNull()) {
+        return p->fail(AVReader::API_ERROR, "unable to allocate pattern frame");
+    }
+    // pooled contents are undefined, the buffer may have held another stream
+    const Layout l = layout(p->d.size);
+    const qsizetype bytes = static_cast<qsizetype>(p->d.size.width()) * image.depth() / 8;
+    for (int y = 0; y < l.strip; y++) {
+        std::memcpy(image.scanLine(y), p->d.base.constScanLine(y), bytes);
+    }
+    for (int y = l.ramps; y < l.bottom; y++) {
+        std::memcpy(image.scanLine(y), p->d.base.constScanLine(y), bytes);
+    }
+    p->stamp(image, p->d.frame);
+    return drop(time);
+}
+
+bool
+AVPatternBackend::drop(AVTime& time)
+{
+    if (p->d.frame >= p->d.count) {
+        return p->fail(AVReader::API_ERROR, "unable to drop frame past the end of the pattern");
+    }
+    time = p->time(p->d.frame++);
+    return true;
+}
+
+AVBackend::Info
+AVPatternBackend::info() const
+{
+    return p->d.info;
+}
+
+AVReader::Error
+AVPatternBackend::error() const
+{
+    return p->d.error;
+}
+
+QString
+AVPatternBackend::error_message() const
+{
+    return p->d.errormessage;
+}
+
+QSize
+AVPatternBackend::size() const
+{
+    return p->d.size;
+}
+
+QImage::Format
+AVPatternBackend::format() const
+{
+    return p->d.format;
+}
+
+qint64
+AVPatternBackend::count() const
+{
+    return p->d.count;
+}
+
+AVFramePool
+AVPatternBackend::pool() const
+{
+    return p->d.pool;
+}
+
+void
+AVPatternBackend::set_size(const QSize& size)
+{
+    p->d.size = size;
+}
+
+void
+AVPatternBackend::set_format(QImage::Format format)
+{
+    p->d.format = format;
+}
+
+void
+AVPatternBackend::set_fps(const AVFps& fps)
+{
+    p->d.fps = fps;
+}
+
+void
+AVPatternBackend::set_count(qint64 frames)
+{
+    p->d.count = frames;
+}
+
+qint64
+AVPatternBackend::barcode(const QImage& image)
+{
+    if (image.width() < 128 || image.height() < 32) {
+        return -1;
+    }
+    const Layout l = layout(image.size());
+    const int y = (l.bottom + image.height()) / 2;
+    auto on = [&](int cell) { return image.pixelColor(cell * l.cell + l.cell / 2, y).lightnessF() > 0.5; };
+    if (!on(0) || on(cells - 1)) {
+        return -1;
+    }
+    qint64 frame = 0;
+    for (int i = 1; i < cells - 1; i++) {
+        frame = (frame << 1) | (on(i) ? 1 : 0);
+    }
+    return frame;
+}
+
+QList<QString>
+AVPatternBackend::formats()
+{
+    QList<QString> tokens;
+    for (const Format& format : ::formats) {
+        tokens.append(format.token);
+    }
+    return tokens;
+}
+
+QSize
+AVPatternBackend::max_size()
+{
+    return QSize(8192, 4320);
+}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avbackend.h"
+#include "avframepool.h"
+
+#include <QScopedPointer>
+#include <QSize>
+
+// synthetic source for benchmarks, no file is read. the name describes the stream, tokens separated by
+// underscores in any order, e.g. bench_3840x2160_23.976fps_120s_rgba16.pattern
+//
+// static bars and ramps are rendered once, moving bars, a frame number barcode and noise are stamped
+// into pooled frames with row copies from precomputed tiles
+class AVPatternBackendPrivate;
+class AVPatternBackend : public AVBackend {
+    public:
+        AVPatternBackend();
+        virtual ~AVPatternBackend();
+        QString name() const override;
+        bool probe(const QString& filename) const override; // the file does not need to exist
+        bool open(const QString& filename) override;
+        void close() override;
+        bool seek(const AVTime& time) override;
+        bool read(QImage& image, AVTime& time) override;
+        bool drop(AVTime& time) override;
+        AVBackend::Info info() const override;
+        AVReader::Error error() const override;
+        QString error_message() const override;
+        QSize size() const;
+        QImage::Format format() const;
+        qint64 count() const;
+        AVFramePool pool() const; // shared handle, for allocation stats
+        void set_size(const QSize& size); // defaults until open, tokens in the name override them
+        void set_format(QImage::Format format);
+        void set_fps(const AVFps& fps);
+        void set_count(qint64 frames);
+
+        static qint64 barcode(const QImage& image); // frame number stamped in the image, -1 if not found
+        static QList<QString> formats(); // format tokens, rgba8, rgbx8, argb32, rgb32, rgba16, rgbx16, rgba16f, rgba32f
+        static QSize max_size(); // 8k
+
+    private:
+        QScopedPointer<AVPatternBackendPrivate> p;
+};
@@ -0,0 +1,372 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avpipeline.h"
+#include "avbackend.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
+class AVPipelinePrivate
+{
+    public:
+        AVPipelinePrivate();
+        ~AVPipelinePrivate();
+        void spawn(int threads);
+        void join();
+        void decode();
+        void convert();
+        void purge(qint64 frame);
+        struct Data
+        {
+            int depth = 8;
+            QImage::Format format = QImage::Format_Invalid;
+            QList<QImage::Format> formats; // already presentable, never converted
+            QList<QThread*> workers; // decode first, then convert
+            bool quit = false;
+            AVBackend* backend = nullptr;
+            qint64 next = 0; // next frame to decode
+            qint64 end = 0;
+            qint64 wanted = 0; // frames before it are dropped
+            qint64 inflight = 0; // read and not yet taken or dropped
+            qint64 generation = 0; // bumped by start and stop, stale work is discarded
+            bool active = false;
+            bool finished = false; // decode reached the end or failed
+            bool decoding = false; // inside the backend
+            int busy = 0; // converts running
+            QQueue<AVPipeline::Frame> converting;
+            QMap<qint64, AVPipeline::Frame> ready; // reassembled in frame order
+            qint64 stalls = 0;
+            qint64 dropped = 0;
+            qint64 copied = 0; // bytes written by conversions
+            QString errormessage;
+            AVReader::Error error = AVReader::NO_ERROR;
+            mutable QMutex mutex;
+            QWaitCondition changed;
+        };
+        Data d;
+};
+
+AVPipelinePrivate::AVPipelinePrivate()
+{
+}
+
+AVPipelinePrivate::~AVPipelinePrivate()
+{
+    join();
+}
+
+void
+AVPipelinePrivate::spawn(int threads)
+{
+    d.workers.append(QThread::create([this] { decode(); }));
+    for (int i = 0; i < threads; i++) {
+        d.workers.append(QThread::create([this] { convert(); }));
+    }
+    for (QThread* worker : d.workers) {
+        worker->start();
+    }
+}
+
+void
+AVPipelinePrivate::join()
+{
+    {
+        QMutexLocker locker(&d.mutex);
+        d.quit = true;
+        d.changed.wakeAll();
+    }
+    for (QThread* worker : d.workers) {
+        worker->wait();
+        delete worker;
+    }
+    d.workers.clear();
+    d.quit = false;
+}
+
+void
+AVPipelinePrivate::decode()
+{
+    QMutexLocker locker(&d.mutex);
+    while (!d.quit) {
+        if (!d.active || d.finished) {
+            d.changed.wait(&d.mutex);
+            continue;
+        }
+        if (d.next >= d.end) {
+            d.finished = true;
+            d.changed.wakeAll();
+            continue;
+        }
+        bool skip = d.next < d.wanted;
+        if (!skip && d.inflight >= d.depth) { // backpressure, the pacer is behind
+            d.changed.wait(&d.mutex);
+            continue;
+        }
+        qint64 frame = d.next;
+        qint64 generation = d.generation;
+        AVBackend* backend = d.backend;
+        d.decoding = true;
+        locker.unlock();
+        AVPipeline::Frame decoded;
+        decoded.frame = frame;
+        bool result = skip ? backend->drop(decoded.time) : backend->read(decoded.image, decoded.time);
+        locker.relock();
+        d.decoding = false;
+        if (generation == d.generation) {
+            if (!result) {
+                d.error = backend->error();
+                d.errormessage = backend->error_message();
+                d.finished = true;
+            }
+            else if (skip) {
+                d.next++;
+                d.dropped++;
+            }
+            else {
+                d.next++;
+                d.inflight++;
+                d.converting.enqueue(decoded);
+            }
+        }
+        d.changed.wakeAll();
+    }
+}
+
+void
+AVPipelinePrivate::convert()
+{
+    QMutexLocker locker(&d.mutex);
+    while (!d.quit) {
+        if (d.converting.isEmpty()) {
+            d.changed.wait(&d.mutex);
+            continue;
+        }
+        AVPipeline::Frame frame = d.converting.dequeue();
+        if (frame.frame < d.wanted) { // skipped while queued, not worth converting
+            d.inflight--;
+            d.dropped++;
+            d.changed.wakeAll();
+            continue;
+        }
+        qint64 generation = d.generation;
+        QImage::Format format = d.format;
+        bool presentable = d.formats.contains(frame.image.format());
+        d.busy++;
+        locker.unlock();
+        qint64 copied = 0;
+        if (format != QImage::Format_Invalid && frame.image.format() != format && !presentable) {
+            frame.image = frame.image.convertToFormat(format);
+            copied = frame.image.sizeInBytes();
+        }
+        locker.relock();
+        d.busy--;
+        d.copied += copied;
+        if (generation == d.generation) {
+            if (frame.frame < d.wanted) {
+                d.inflight--;
+                d.dropped++;
+            }
+            else {
+                d.ready.insert(frame.frame, frame);
+            }
+        }
+        d.changed.wakeAll();
+    }
+}
+
+void
+AVPipelinePrivate::purge(qint64 frame)
+{
+    d.wanted = qMax(d.wanted, frame);
+    for (auto it = d.ready.begin(); it != d.ready.end() && it.key() < d.wanted;) {
+        it = d.ready.erase(it);
+        d.inflight--;
+        d.dropped++;
+    }
+    d.changed.wakeAll();
+}
+
+AVPipeline::AVPipeline()
+: p(new AVPipelinePrivate())
+{
+    p->spawn(2);
+}
+
+AVPipeline::~AVPipeline()
+{
+    stop();
+}
+
+void
+AVPipeline::start(AVBackend* backend, qint64 first, qint64 end)
+{
+    stop();
+    QMutexLocker locker(&p->d.mutex);
+    p->d.backend = backend;
+    p->d.next = first;
+    p->d.end = end;
+    p->d.wanted = first;
+    p->d.finished = false;
+    p->d.errormessage = QString();
+    p->d.error = AVReader::NO_ERROR;
+    p->d.active = true;
+    p->d.changed.wakeAll();
+}
+
+void
+AVPipeline::stop()
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->d.active = false;
+    p->d.generation++;
+    p->d.changed.wakeAll();
+    while (p->d.decoding || p->d.busy > 0) {
+        p->d.changed.wait(&p->d.mutex);
+    }
+    p->d.backend = nullptr;
+    p->d.converting.clear();
+    p->d.ready.clear();
+    p->d.inflight = 0;
+}
+
+bool
+AVPipeline::take(qint64 frame, AVPipeline::Frame& ready)
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->purge(frame);
+    bool waited = false;
+    while (!p->d.ready.contains(frame)) {
+        if (!p->d.active || (p->d.finished && p->d.converting.isEmpty() && p->d.busy == 0)) {
+            return false; // nothing more will arrive
+        }
+        waited = true;
+        p->d.changed.wait(&p->d.mutex);
+    }
+    if (waited) {
+        p->d.stalls++;
+    }
+    ready = p->d.ready.take(frame);
+    p->d.inflight--;
+    p->d.wanted = frame + 1;
+    p->d.changed.wakeAll();
+    return true;
+}
+
+void
+AVPipeline::skip(qint64 frame)
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->purge(frame);
+}
+
+bool
+AVPipeline::is_running() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.active;
+}
+
+int
+AVPipeline::depth() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.depth;
+}
+
+int
+AVPipeline::threads() const
+{
+    return static_cast<int>(p->d.workers.size()) - 1;
+}
+
+QImage::Format
+AVPipeline::format() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.format;
+}
+
+QList<QImage::Format>
+AVPipeline::formats() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.formats;
+}
+
+qint64
+AVPipeline::buffered() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.inflight;
+}
+
+qint64
+AVPipeline::stalls() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.stalls;
+}
+
+qint64
+AVPipeline::dropped() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.dropped;
+}
+
+qint64
+AVPipeline::copied() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.copied;
+}
+
+void
+AVPipeline::set_depth(int frames)
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->d.depth = qMax(1, frames);
+    p->d.changed.wakeAll();
+}
+
+void
+AVPipeline::set_threads(int threads)
+{
+    Q_ASSERT("pipeline is running" && !is_running());
+    if (threads != this->threads()) {
+        p->join();
+        p->spawn(qMax(1, threads));
+    }
+}
+
+void
+AVPipeline::set_format(QImage::Format format)
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->d.format = format;
+}
+
+void
+AVPipeline::set_formats(const QList<QImage::Format>& formats)
+{
+    QMutexLocker locker(&p->d.mutex);
+    p->d.formats = formats;
+}
+
+AVReader::Error
+AVPipeline::error() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.error;
+}
+
+QString
+AVPipeline::error_message() const
+{
+    QMutexLocker locker(&p->d.mutex);
+    return p->d.errormessage;
+}
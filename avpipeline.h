@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avreader.h"
+#include "avtime.h"
+
+#include <QImage>
+#include <QScopedPointer>
+
+// decode, convert and present stages for streaming. a decode thread reads the backend ahead of the
+// pacer into a bounded number of frames, convert workers bring them to the present format and the
+// pacer takes them back in frame order. frames the pacer skips are dropped in the backend when not
+// yet read, so late frames cost no decode
+class AVBackend;
+class AVPipelinePrivate;
+class AVPipeline
+{
+    public:
+        struct Frame
+        {
+            QImage image;
+            AVTime time;
+            qint64 frame = -1;
+        };
+
+    public:
+        AVPipeline(); // workers start here, with the scheduling and affinity of the calling thread
+        ~AVPipeline();
+        void start(AVBackend* backend, qint64 first, qint64 end); // backend positioned at first, not touched until stop
+        void stop(); // waits for the stages to let go of the backend
+        bool take(qint64 frame, AVPipeline::Frame& ready); // waits for the frame, false at the end or on error
+        void skip(qint64 frame); // frames before it are not presented
+        bool is_running() const;
+        int depth() const;
+        int threads() const;
+        QImage::Format format() const;
+        QList<QImage::Format> formats() const;
+        qint64 buffered() const; // frames read and not yet taken, at most depth
+        qint64 stalls() const; // takes that waited for their frame
+        qint64 dropped() const;
+        qint64 copied() const; // bytes written converting frames, none when frames arrive in the present format
+        void set_depth(int frames);
+        void set_threads(int threads); // convert workers, restarts them, not while running
+        void set_format(QImage::Format format); // QImage::Format_Invalid presents frames as decoded
+        void set_formats(const QList<QImage::Format>& formats); // presented as decoded, others are converted to format
+        AVReader::Error error() const;
+        QString error_message() const;
+
+    private:
+        QScopedPointer<AVPipelinePrivate> p;
+};
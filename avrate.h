@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avfps.h"
+#include "avmath.h"
+
+#include <type_traits>
+
+template <qint32 Numerator, qint32 Denominator, bool DropFrame>
+class AVRate
+{
+    public:
+        static constexpr AVFps fps() { return AVFps(Numerator, Denominator, DropFrame); }
+        static constexpr qint64 frame_quanta = AVMath::muldiv(1, Numerator, Denominator);
+        static constexpr qint64 drop_frames = DropFrame ? (frame_quanta + 7) / 15 : 0; // round(fps * 0.066666)
+        static constexpr qint64 frames_minute = frame_quanta * 60;
+        static constexpr qint64 frames_dropminute = frames_minute - drop_frames;
+        static constexpr qint64 frames_10minutes = frames_minute * 10 - drop_frames * 9;
+
+        template <qint32 Timescale>
+        static constexpr qint64 ticks(qint64 frame) {
+            return AVMath::muldiv<static_cast<qint64>(Timescale) * Denominator, Numerator>(frame);
+        }
+        template <qint32 Timescale>
+        static constexpr qint64 frame(qint64 ticks) {
+            return AVMath::muldiv<Numerator, static_cast<qint64>(Timescale) * Denominator>(ticks);
+        }
+        // timecode label to frame, skips the dropped labels for every minute but each tenth
+        static constexpr qint64 from_label(qint64 label) {
+            if constexpr (drop_frames == 0) {
+                return label;
+            }
+            qint64 minutes = label / frames_minute;
+            return label - drop_frames * (minutes - minutes / 10);
+        }
+        // frame to timecode label
+        static constexpr qint64 to_label(qint64 frame) {
+            if constexpr (drop_frames == 0) {
+                return frame;
+            }
+            qint64 blocks = frame / frames_10minutes;
+            qint64 remaining = frame % frames_10minutes;
+            qint64 adjust = blocks * 9 * drop_frames;
+            if (remaining > drop_frames) {
+                adjust += drop_frames * ((remaining - drop_frames) / frames_dropminute);
+            }
+            return frame + adjust;
+        }
+};
+
+class AVRates
+{
+    public:
+        static constexpr AVFps standards[] = {
+            AVFps::fps_23_976(),
+            AVFps::fps_24(),
+            AVFps::fps_25(),
+            AVFps::fps_29_97(),
+            AVFps::fps_30(),
+            AVFps::fps_47_952(),
+            AVFps::fps_48(),
+            AVFps::fps_50(),
+            AVFps::fps_59_94(),
+            AVFps::fps_60()
+        };
+        // calls function with the AVRate of a standard fps, returns false for other rates
+        template <typename Function>
+        static bool dispatch(const AVFps& fps, Function&& function) {
+            return rates<true>(fps, function);
+        }
+        // calls function with the AVRate and timescale constant, drop frame does not change tick math
+        template <typename Function>
+        static bool dispatch(const AVFps& fps, qint32 timescale, Function&& function) {
+            auto rate = [&](auto rate) {
+                return AVRates::timescale(timescale, [&](auto constant) {
+                    function(rate, constant);
+                });
+            };
+            return rates<false>(fps, rate);
+        }
+
+    private:
+        template <bool DropFrame, typename Function>
+        static bool rates(const AVFps& fps, Function& function) {
+            switch (fps.numerator()) {
+                case 24000: return rate<24000, 1001, DropFrame>(fps, function);
+                case 24: return rate<24, 1, DropFrame>(fps, function);
+                case 25: return rate<25, 1, DropFrame>(fps, function);
+                case 30000: return rate<30000, 1001, DropFrame>(fps, function);
+                case 30: return rate<30, 1, DropFrame>(fps, function);
+                case 48000: return rate<48000, 1001, DropFrame>(fps, function);
+                case 48: return rate<48, 1, DropFrame>(fps, function);
+                case 50: return rate<50, 1, DropFrame>(fps, function);
+                case 60000: return rate<60000, 1001, DropFrame>(fps, function);
+                case 60: return rate<60, 1, DropFrame>(fps, function);
+            }
+            return false;
+        }
+        template <qint32 Numerator, qint32 Denominator, bool DropFrame, typename Function>
+        static bool rate(const AVFps& fps, Function& function) {
+            if (fps.denominator() != Denominator) {
+                return false;
+            }
+            if constexpr (DropFrame) {
+                if (fps.drop_frame()) {
+                    return invoke(function, AVRate<Numerator, Denominator, true>());
+                }
+            }
+            return invoke(function, AVRate<Numerator, Denominator, false>());
+        }
+        template <typename Function>
+        static bool timescale(qint32 timescale, Function&& function) {
+            switch (timescale) { // quicktime, default and per rate timescales from AVTime::convert
+                case 600: function(std::integral_constant<qint32, 600>()); return true;
+                case 24000: function(std::integral_constant<qint32, 24000>()); return true;
+                case 25000: function(std::integral_constant<qint32, 25000>()); return true;
+                case 30000: function(std::integral_constant<qint32, 30000>()); return true;
+                case 48000: function(std::integral_constant<qint32, 48000>()); return true;
+                case 50000: function(std::integral_constant<qint32, 50000>()); return true;
+                case 60000: function(std::integral_constant<qint32, 60000>()); return true;
+                case 90000: function(std::integral_constant<qint32, 90000>()); return true;
+            }
+            return false;
+        }
+        template <typename Function, typename Rate>
+        static bool invoke(Function& function, Rate rate) {
+            if constexpr (std::is_same_v<decltype(function(rate)), bool>) {
+                return function(rate);
+            }
+            else {
+                function(rate);
+                return true;
+            }
+        }
+};
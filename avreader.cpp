@@ -0,0 +1,671 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avreader.h"
+#include "avbackend.h"
+#include "avcache.h"
+#include "avclock.h"
+#include "avframepool.h"
+#include "avpipeline.h"
+#include "avrealtime.h"
+#include "avtimer.h"
+
+#include <QMutex>
+#include <QPointer>
+#include <QThread>
+#include <QtGlobal>
+
+#include <QDebug>
+
+#include <atomic>
+
+class AVReaderPrivate
+{
+    public:
+        AVReaderPrivate();
+        ~AVReaderPrivate();
+        void init();
+        void open();
+        void close();
+        void read();
+        void seek(const AVTime& time);
+        void stream();
+        AVTimestamps timestamps();
+        bool next(AVTimer& timer, const AVTimestamps& timestamps, qint64 frame) const;
+        void fail();
+
+    public:
+        struct Data
+        {
+            QScopedPointer<AVBackend> backend;
+            AVTimeRange timerange;
+            AVTimeRange iorange;
+            AVTime startstamp;
+            AVTime timestamp;
+            AVTime ptstamp;
+            AVSmpteTime timecode;
+            AVTimestamps timestamps;
+            QMutex timestampsmutex;
+            bool timestampsloaded = false;
+            bool variable = false;
+            AVFps fps;
+            QString filename;
+            QString title;
+            std::atomic<bool> loop = false;
+            std::atomic<bool> everyframe = false;
+            std::atomic<bool> streaming = false;
+            AVClock* clock = AVClock::system();
+            bool realtime = false; // opt-in, fifo scheduling needs privileges and competes with the ui
+            AVPipeline pipeline; // workers are created with the reader, never with realtime scheduling
+            AVCache cache;
+            AVTimer frametimer; // paces streaming, its wake error histogram is read live from any thread
+            bool deferred = false; // backend seek left to the next read that misses the cache
+            AVMetadata metadata;
+            AVSidecar sidecar;
+            QString errormessage;
+            AVReader::Error error = AVReader::NO_ERROR;
+        };
+        Data d;
+        QPointer<AVReader> object;
+};
+
+AVReaderPrivate::AVReaderPrivate()
+{
+}
+
+AVReaderPrivate::~AVReaderPrivate()
+{
+}
+
+void
+AVReaderPrivate::init()
+{
+}
+
+void
+AVReaderPrivate::fail()
+{
+    d.error = d.backend->error();
+    d.errormessage = d.backend->error_message();
+}
+
+void
+AVReaderPrivate::open()
+{
+    QString filename = d.filename;
+    close();
+    d.filename = filename;
+    d.backend.reset(AVBackend::create(d.filename));
+    if (!d.backend) {
+        d.error = AVReader::FILE_ERROR;
+        d.errormessage = QString("no reader backend supports file: %1").arg(d.filename);
+        qWarning() << "warning: " << d.errormessage;
+        return;
+    }
+    if (!d.backend->open(d.filename)) {
+        fail();
+        return;
+    }
+    AVBackend::Info info = d.backend->info();
+    d.title = info.title;
+    d.metadata = info.metadata;
+    d.fps = info.fps;
+    d.variable = info.variable;
+    d.timerange = info.range;
+    d.startstamp = info.start;
+    d.timestamp = d.timerange.start();
+    object->opened(d.filename);
+}
+
+void
+AVReaderPrivate::close()
+{
+    if (d.backend) {
+        d.backend->close();
+        d.backend.reset();
+    }
+    d.timerange = AVTimeRange();
+    d.iorange = AVTimeRange();
+    d.startstamp = AVTime();
+    d.timestamp = AVTime();
+    d.ptstamp = AVTime();
+    d.fps = AVFps();
+    d.timestamps = AVTimestamps();
+    d.timestampsloaded = false;
+    d.variable = false;
+    d.filename = QString();
+    d.title = QString();
+    d.loop = false;
+    d.everyframe = false;
+    d.streaming = false;
+    d.metadata = AVMetadata();
+    d.sidecar = AVSidecar();
+    d.cache.clear();
+    d.cache.set_pinned(AVTimeRange());
+    d.cache.reset_stats();
+    d.deferred = false;
+    d.errormessage = QString();
+    d.error = AVReader::NO_ERROR;
+}
+
+void
+AVReaderPrivate::read()
+{
+    Q_ASSERT("reader is not open" && d.backend);
+
+    QImage image;
+    if (d.cache.find(d.timestamp, image)) { // revisited, no decode and the backend stays where it is
+        d.ptstamp = d.timestamp;
+        object->video_changed(image);
+        return;
+    }
+    if (d.deferred) {
+        d.deferred = false;
+        if (!d.backend->seek(d.timestamp)) {
+            fail();
+            return;
+        }
+    }
+    if (!d.backend->read(image, d.ptstamp)) {
+        fail();
+        return;
+    }
+    Q_ASSERT("read timestamp and ptstamp does not match" && d.timestamp == d.ptstamp);
+    QImage::Format format = d.pipeline.format();
+    if (format != QImage::Format_Invalid && image.format() != format && !d.pipeline.formats().contains(image.format())) {
+        image = image.convertToFormat(format); // cached as presented, like streamed frames
+    }
+    d.cache.insert(d.ptstamp, image);
+    object->video_changed(image);
+}
+
+void
+AVReaderPrivate::seek(const AVTime& time)
+{
+    Q_ASSERT("reader is not open" && d.backend);
+    AVTimestamps timestamps = this->timestamps();
+    Q_ASSERT("ticks are not aligned" && (timestamps.valid() || time.ticks() == time.align(time.ticks())));
+
+    d.timestamp = d.timerange.bound(time, d.loop);
+    if (timestamps.valid()) {
+        d.timestamp.set_ticks(timestamps.align(d.timestamp.ticks()));
+    }
+    d.deferred = d.cache.contains(d.timestamp); // the backend only seeks when a read misses the cache
+    if (!d.deferred && !d.backend->seek(d.timestamp)) {
+        fail();
+        return;
+    }
+    d.timecode.set_time(d.startstamp + d.timestamp);
+    object->time_changed(d.timestamp);
+    object->timecode_changed(d.startstamp + d.timestamp);
+}
+
+void
+AVReaderPrivate::stream()
+{
+    d.streaming = true;
+    object->stream_changed(d.streaming);
+    AVRealtime realtime; // restored when streaming stops
+    if (d.realtime) {
+        // scheduling only, not pinned, nothing keeps the ui and decode threads off a pinned cpu. memory
+        // is not locked process wide, the pacing tables are locked below
+        realtime.set_policy(AVRealtime::FIFO);
+        realtime.set_period(static_cast<quint64>(1e9 * d.fps.seconds()));
+        realtime.apply();
+        for (const QString& message : realtime.report()) {
+            qDebug() << "realtime:" << message;
+        }
+    }
+    else {
+        QThread::currentThread()->setPriority(QThread::TimeCriticalPriority);
+    }
+    AVTimer statstimer;
+    statstimer.set_clock(d.clock);
+    statstimer.start();
+    
+    AVTimer fpstimer;
+    fpstimer.set_clock(d.clock);
+    fpstimer.start();
+    
+    qint64 frame = 0;
+    qint64 ticks = 0;
+    qint64 droppedframes = 0;
+    qint64 fpsframes = 0;
+    qint64 presented = 0;
+    qint64 copied = d.pipeline.copied();
+    qint64 allocations = AVFramePool::total_allocations(); // cached frames hold their buffers, 1 per frame until the budget evicts
+    AVTimestamps timestamps = this->timestamps(); // empty for constant frame rates
+    bool variable = timestamps.valid();
+    bool locked = d.realtime && variable && timestamps.lock(); // read every frame, no page faults while pacing
+    if (d.realtime && variable) {
+        qDebug() << "realtime:" << (locked ? "locked timestamps" : "locking timestamps failed");
+    }
+    d.frametimer.set_clock(d.clock);
+    d.frametimer.set_mode(AVTimer::SPIN); // sleep close to the deadline, spin the last 200 us
+    d.frametimer.reset_histogram(); // across loop passes, live while playing
+    while (d.streaming) {
+        qint64 start = variable ? timestamps.frame(d.timestamp.ticks()) : d.timestamp.frames();
+        qint64 duration = variable ? timestamps.count() : d.timerange.end().frames(); // ranges may start past zero
+        ticks = d.timestamp.ticks();
+        seek(d.timestamp);
+        if (d.deferred) { // the pipeline reads from the backend position
+            d.deferred = false;
+            if (!d.backend->seek(d.timestamp)) {
+                fail();
+                d.streaming = false;
+            }
+        }
+        qint64 timecode = d.timecode.frame() - start; // timecode follows frame incrementally
+        statstimer.lap();
+
+        if (variable) {
+            d.frametimer.start(timestamps.duration(start), timestamps.timescale());
+        }
+        else {
+            d.frametimer.start(d.fps);
+        }
+        d.pipeline.start(d.backend.data(), start, duration); // decodes ahead while the pacer waits
+        for (frame = start; frame < duration; frame++) {
+            if (!d.streaming) {
+                break;
+            }
+            d.timestamp.set_ticks(variable ? timestamps.ticks(frame) : d.timestamp.ticks(frame));
+            QImage image;
+            if (d.cache.find(d.timestamp, image)) { // replay and backward seeks, the decode thread drops the frame unread
+                d.pipeline.skip(frame + 1);
+                d.ptstamp = d.timestamp;
+            }
+            else {
+                AVPipeline::Frame ready;
+                if (!d.pipeline.take(frame, ready)) {
+                    if (d.pipeline.error() != AVReader::NO_ERROR) {
+                        fail();
+                    }
+                    break;
+                }
+                d.ptstamp = ready.time;
+                Q_ASSERT("read timestamp and ptstamp does not match" && d.timestamp == d.ptstamp);
+                d.cache.insert(ready.time, ready.image); // by reference, the decode buffer stays with the frame until evicted
+                image = ready.image;
+            }
+            object->video_changed(image); // by reference, queued to the ui without a copy
+            presented++;
+            d.timecode.advance(timecode + frame - d.timecode.frame());
+            
+            object->time_changed(d.timestamp);
+            object->timecode_changed(d.startstamp + d.timestamp); // a queued copy of d.timecode would detach on the next advance
+            fpsframes++;
+            d.frametimer.wait();
+            qint64 due = frame;
+            while (!next(d.frametimer, timestamps, frame + 1) && !d.everyframe) {
+                frame++;
+                fpsframes++;
+                droppedframes++;
+                d.timestamp.set_ticks(variable ? timestamps.ticks(frame) : d.timestamp.ticks(frame));
+            }
+            if (frame != due) {
+                d.pipeline.skip(frame + 1); // not yet read frames are dropped without decode
+            }
+            if (fpsframes % 10 == 0) {
+                qreal actualfps = fpsframes / AVTimer::convert(fpstimer.elapsed(), AVTimer::Unit::SECONDS);
+                object->actualfps_changed(actualfps);
+                fpstimer.restart();
+                fpsframes = 0;
+            }
+        }
+        d.pipeline.stop(); // the backend is ours again for the seek
+        if (!d.loop || !d.streaming || d.error != AVReader::NO_ERROR) {
+            break;
+        }
+        d.timestamp = d.timerange.start();
+    }
+    d.streaming = false;
+    statstimer.stop();
+    
+    object->stream_changed(d.streaming);
+    if (locked) {
+        timestamps.unlock();
+    }
+    if (d.realtime) {
+        realtime.restore();
+    }
+    else {
+        QThread::currentThread()->setPriority(QThread::NormalPriority);
+    }
+    
+    AVHistogram wakes = d.frametimer.histogram();
+    qreal elapsed = AVTimer::convert(statstimer.elapsed(), AVTimer::Unit::SECONDS);
+    qreal expected = AVTime(d.timestamp, d.timestamp.ticks() - ticks).seconds();
+    qreal deviation = elapsed - expected;
+    
+    qDebug() << "stats: "
+             << "timestamp: " << d.timestamp.to_string() << "|"
+             << "elapsed:" << elapsed << "seconds" << AVTime(elapsed, d.fps).to_string() << "|"
+             << "expected:" << expected
+             << "deviation:" << deviation << "msecs:" << deviation * 1000 << "%:" << (deviation / expected) * 100
+             << "seek:" << AVTimer::convert(statstimer.laps().first(), AVTimer::Unit::SECONDS) * 1000
+             << "| frames dropped:" << droppedframes
+             << "| read-ahead:" << d.pipeline.depth() << "underruns:" << d.pipeline.stalls()
+             << "copied bytes/frame:" << (presented > 0 ? (d.pipeline.copied() - copied) / presented : 0)
+             << "pool allocations/frame:" << (presented > 0 ? (AVFramePool::total_allocations() - allocations) / static_cast<qreal>(presented) : 0.0)
+             << "| cache frames:" << d.cache.count() << "mbytes:" << d.cache.bytes() / (1024.0 * 1024.0)
+             << "hit rate:" << d.cache.hit_rate()
+             << "| wake usecs p50:" << wakes.percentile(50.0) / 1000.0 << "p99:" << wakes.percentile(99.0) / 1000.0
+             << "p99.9:" << wakes.percentile(99.9) / 1000.0 << "max:" << wakes.max() / 1000.0;
+}
+
+AVTimestamps
+AVReaderPrivate::timestamps()
+{
+    QMutexLocker locker(&d.timestampsmutex);
+    if (d.variable && !d.timestampsloaded) { // loaded on first use, constant frame rates use fps
+        d.timestampsloaded = true;
+        d.timestamps = d.backend->timestamps();
+        qDebug() << "timestamps: " << d.timestamps.count() << "frames" << d.timestamps.bytes() << "bytes"
+                 << (d.timestamps.constant() ? "constant" : "variable");
+        AVTimestamps timestamps = d.timestamps;
+        locker.unlock();
+        object->timestamps_changed(timestamps); // from the thread that needed them, the ui never loads
+        return timestamps;
+    }
+    return d.timestamps;
+}
+
+bool
+AVReaderPrivate::next(AVTimer& timer, const AVTimestamps& timestamps, qint64 frame) const
+{
+    if (timestamps.valid()) {
+        return timer.next(timestamps.duration(frame), timestamps.timescale()); // exact in the track timescale
+    }
+    return timer.next(d.fps);
+}
+
+AVReader::AVReader()
+: p(new AVReaderPrivate())
+{
+    p->init();
+    p->object = this;
+}
+
+AVReader::~AVReader()
+{
+}
+
+void
+AVReader::open(const QString& filename)
+{
+    p->d.filename = filename;
+    p->open();
+}
+
+void
+AVReader::read()
+{
+    p->read();
+}
+
+void
+AVReader::close()
+{
+    p->close();
+}
+
+bool
+AVReader::is_open() const
+{
+    return (p->d.backend && p->d.error == AVReader::NO_ERROR);
+}
+
+bool
+AVReader::is_closed() const
+{
+    return !p->d.backend;
+}
+
+bool
+AVReader::is_streaming() const
+{
+    return p->d.streaming;
+}
+
+bool
+AVReader::is_supported(const QString& extension) const
+{
+    return AVBackend::extensions().contains(extension.toLower());
+}
+
+QString
+AVReader::filename() const
+{
+    return p->d.filename;
+}
+
+QString
+AVReader::title() const
+{
+    return p->d.title;
+}
+
+AVTimeRange
+AVReader::range() const
+{
+    return p->d.timerange;
+}
+
+AVTimeRange
+AVReader::io() const
+{
+    return p->d.iorange;
+}
+
+AVTime
+AVReader::start() const
+{
+    return p->d.startstamp;
+}
+
+AVTime
+AVReader::time() const
+{
+    return p->d.timestamp;
+}
+
+AVSmpteTime
+AVReader::timecode() const
+{
+    return AVSmpteTime(p->d.startstamp + p->d.timestamp); // never shares d.timecode, the streaming thread advances it
+}
+
+AVTimestamps
+AVReader::timestamps() const
+{
+    return p->timestamps();
+}
+
+AVFps
+AVReader::fps() const
+{
+    return p->d.fps;
+}
+
+bool
+AVReader::loop() const
+{
+    return p->d.loop;
+}
+
+QList<QString>
+AVReader::extensions() const
+{
+    return AVBackend::extensions();
+}
+
+QString
+AVReader::backend() const
+{
+    return p->d.backend ? p->d.backend->name() : QString();
+}
+
+AVMetadata
+AVReader::metadata()
+{
+    return p->d.metadata;
+}
+
+AVSidecar
+AVReader::sidecar()
+{
+    return p->d.sidecar;
+}
+
+bool
+AVReader::realtime() const
+{
+    return p->d.realtime;
+}
+
+AVClock*
+AVReader::clock() const
+{
+    return p->d.clock;
+}
+
+int
+AVReader::readahead() const
+{
+    return p->d.pipeline.depth();
+}
+
+QImage::Format
+AVReader::format() const
+{
+    return p->d.pipeline.format();
+}
+
+QList<QImage::Format>
+AVReader::formats() const
+{
+    return p->d.pipeline.formats();
+}
+
+qint64
+AVReader::cache_budget() const
+{
+    return p->d.cache.budget();
+}
+
+qint64
+AVReader::cache_bytes() const
+{
+    return p->d.cache.bytes();
+}
+
+qreal
+AVReader::cache_hit_rate() const
+{
+    return p->d.cache.hit_rate();
+}
+
+AVHistogram
+AVReader::wake_errors() const
+{
+    return p->d.frametimer.histogram();
+}
+
+AVReader::Error
+AVReader::error() const
+{
+    return p->d.error;
+}
+
+QString
+AVReader::error_message() const
+{
+    return p->d.errormessage;
+}
+
+void
+AVReader::set_loop(bool loop)
+{
+    if (p->d.loop != loop) {
+        p->d.loop = loop;
+        loop_changed(loop);
+    }
+}
+
+void
+AVReader::set_io(const AVTimeRange& io)
+{
+    if (p->d.iorange != io) {
+        p->d.iorange = io;
+        p->d.cache.set_pinned(io); // the range being reviewed is never evicted
+        io_changed(io);
+    }
+}
+
+void
+AVReader::set_realtime(bool realtime)
+{
+    Q_ASSERT("realtime changed while streaming" && !p->d.streaming);
+    p->d.realtime = realtime;
+}
+
+void
+AVReader::set_clock(AVClock* clock)
+{
+    Q_ASSERT("clock changed while streaming" && !p->d.streaming);
+    p->d.clock = clock ? clock : AVClock::system();
+}
+
+void
+AVReader::set_readahead(int frames)
+{
+    p->d.pipeline.set_depth(frames);
+}
+
+void
+AVReader::set_cache_budget(qint64 bytes)
+{
+    p->d.cache.set_budget(bytes);
+}
+
+void
+AVReader::set_format(QImage::Format format)
+{
+    Q_ASSERT("format changed while streaming" && !p->d.streaming);
+    p->d.pipeline.set_format(format);
+}
+
+void
+AVReader::set_formats(const QList<QImage::Format>& formats)
+{
+    Q_ASSERT("formats changed while streaming" && !p->d.streaming);
+    p->d.pipeline.set_formats(formats);
+}
+
+void
+AVReader::set_everyframe(bool everyframe)
+{
+    if (p->d.everyframe != everyframe) {
+        p->d.everyframe = everyframe;
+        everyframe_changed(everyframe);
+    }
+}
+
+void
+AVReader::seek(const AVTime& time)
+{
+    p->seek(time);
+}
+
+void
+AVReader::stream()
+{
+    p->stream();
+}
+
+void
+AVReader::stop()
+{
+    p->d.streaming = false;
+}
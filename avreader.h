@@ -4,16 +4,19 @@
 #pragma once
 
 #include "avfps.h"
+#include "avhistogram.h"
 #include "avmetadata.h"
 #include "avsidecar.h"
 #include "avsmptetime.h"
 #include "avtime.h"
 #include "avtimerange.h"
+#include "avtimestamps.h"
 
 #include <QImage>
 #include <QObject>
 #include <QScopedPointer>
 
+class AVClock;
 class AVReaderPrivate;
 class AVReader : public QObject {
     Q_OBJECT
@@ -38,11 +41,28 @@ class AVReader : public QObject {
         AVTime start() const;
         AVTime time() const;
         AVSmpteTime timecode() const;
+        AVTimestamps timestamps() const;
         AVFps fps() const;
         bool loop() const;
         AVMetadata metadata();
         AVSidecar sidecar();
         QList<QString> extensions() const;
+        QString backend() const; // name of the backend decoding the open file
+        bool realtime() const;
+        AVClock* clock() const;
+        int readahead() const;
+        QImage::Format format() const;
+        QList<QImage::Format> formats() const;
+        qint64 cache_budget() const;
+        qint64 cache_bytes() const; // decoded frames resident
+        qreal cache_hit_rate() const; // of reads since open
+        AVHistogram wake_errors() const; // of the current stream, live while streaming
+        void set_realtime(bool realtime); // realtime scheduling of the streaming thread, off by default
+        void set_clock(AVClock* clock); // not owned, a virtual clock paces streaming in simulated time
+        void set_readahead(int frames); // frames decoded ahead of presentation while streaming
+        void set_cache_budget(qint64 bytes); // frames kept for seeks and replay, 0 disables caching
+        void set_format(QImage::Format format); // frames are converted off the streaming thread, invalid keeps them as decoded
+        void set_formats(const QList<QImage::Format>& formats); // presented as decoded, without a conversion to format
         AVReader::Error error() const;
         QString error_message() const;
 
@@ -60,7 +80,8 @@ class AVReader : public QObject {
         void io_changed(const AVTimeRange& io);
         void start_changed(const AVTime& time);
         void time_changed(const AVTime& time);
-        void timecode_changed(const AVTime& time);
+        void timestamps_changed(const AVTimestamps& timestamps); // variable frame rates, once loaded
+        void timecode_changed(const AVTime& timecode); // start plus time, a flat value safe to queue every frame
         void video_changed(const QImage& image);
         void audio_changed(const QByteArray& buffer);
         void loop_changed(bool loop);
@@ -0,0 +1,344 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avrealtime.h"
+
+#include <QThread>
+
+#include <QDebug>
+
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#if defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#include <mach/mach_time.h>
+#include <mach/thread_policy.h>
+#else
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class AVRealtimePrivate
+{
+    public:
+        AVRealtimePrivate();
+        ~AVRealtimePrivate();
+        bool scheduling();
+        bool affinity();
+        bool memory();
+        QString error(int error) const;
+        struct Data
+        {
+            AVRealtime::Policy policy = AVRealtime::FIFO;
+            int priority = 40;
+            quint64 period = 0; // nanos, macos time constraint needs the frame period
+            QList<int> cpus;
+            bool lockmemory = false;
+            pthread_t thread;
+            bool threaded = false;
+            bool applied[3] = { false, false, false };
+            QString messages[3];
+            int previouspolicy = 0;
+            int previouspriority = 0;
+            int previousnice = 0;
+            bool niced = false;
+#if !defined(Q_OS_MACOS)
+            pid_t tid = 0;
+            cpu_set_t previouscpus;
+#endif
+        };
+        Data d;
+};
+
+AVRealtimePrivate::AVRealtimePrivate()
+{
+}
+
+AVRealtimePrivate::~AVRealtimePrivate()
+{
+}
+
+QString
+AVRealtimePrivate::error(int error) const
+{
+    return QString::fromLatin1(std::strerror(error));
+}
+
+bool
+AVRealtimePrivate::scheduling()
+{
+    QString& message = d.messages[AVRealtime::SCHEDULING];
+    if (d.policy == AVRealtime::DEFAULT) {
+        message = "default scheduling";
+        return true;
+    }
+    sched_param param;
+    pthread_getschedparam(d.thread, &d.previouspolicy, &param);
+    d.previouspriority = param.sched_priority;
+#if defined(Q_OS_MACOS)
+    if (d.period == 0) {
+        message = "time constraint failed: no frame period set, using default scheduling";
+        return false;
+    }
+    // the mach equivalent of a realtime policy, computation within a quarter and finished within half
+    // the period, the scheduler demotes threads that exceed it instead of starving the ui
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    auto ticks = [&](quint64 nanos) { return static_cast<uint32_t>((nanos * timebase.denom) / timebase.numer); };
+    thread_time_constraint_policy_data_t policy;
+    policy.period = ticks(d.period);
+    policy.computation = ticks(d.period / 4);
+    policy.constraint = ticks(d.period / 2);
+    policy.preemptible = true;
+    kern_return_t result = thread_policy_set(pthread_mach_thread_np(d.thread), THREAD_TIME_CONSTRAINT_POLICY,
+                                             reinterpret_cast<thread_policy_t>(&policy), THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+    if (result != KERN_SUCCESS) {
+        message = QString("time constraint failed: %1, using default scheduling").arg(mach_error_string(result));
+        return false;
+    }
+    message = QString("time constraint, period %1 us").arg(d.period / 1000);
+    return true;
+#else
+    int policy = d.policy == AVRealtime::RR ? SCHED_RR : SCHED_FIFO;
+    QString name = d.policy == AVRealtime::RR ? "SCHED_RR" : "SCHED_FIFO";
+    param.sched_priority = qBound(sched_get_priority_min(policy), d.priority, sched_get_priority_max(policy));
+    int result = pthread_setschedparam(d.thread, policy, &param);
+    if (result == 0) {
+        message = QString("%1 priority %2").arg(name).arg(param.sched_priority);
+        return true;
+    }
+    // without CAP_SYS_NICE or an rtprio limit, fall back to the highest nice level allowed for the thread
+    errno = 0;
+    d.previousnice = getpriority(PRIO_PROCESS, d.tid);
+    for (int nice = -20; nice < d.previousnice; nice += 5) {
+        if (setpriority(PRIO_PROCESS, d.tid, nice) == 0) {
+            d.niced = true;
+            message = QString("%1 failed: %2, fell back to nice %3").arg(name).arg(error(result)).arg(nice);
+            return false;
+        }
+    }
+    message = QString("%1 failed: %2, nice failed: %3, using default scheduling").arg(name).arg(error(result)).arg(error(errno));
+    return false;
+#endif
+}
+
+bool
+AVRealtimePrivate::affinity()
+{
+    QString& message = d.messages[AVRealtime::AFFINITY];
+    if (d.cpus.isEmpty()) {
+        message = "not pinned";
+        return true;
+    }
+#if defined(Q_OS_MACOS)
+    message = "pinning failed: cpu affinity is not supported on macos";
+    return false;
+#else
+    pthread_getaffinity_np(d.thread, sizeof(cpu_set_t), &d.previouscpus);
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    QList<QString> names;
+    for (int cpu : d.cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpus);
+            names.append(QString::number(cpu));
+        }
+    }
+    int result = pthread_setaffinity_np(d.thread, sizeof(cpu_set_t), &cpus);
+    if (result != 0) {
+        message = QString("pinning failed: %1").arg(error(result));
+        return false;
+    }
+    message = QString("pinned to cpu %1").arg(names.join(", "));
+    return true;
+#endif
+}
+
+bool
+AVRealtimePrivate::memory()
+{
+    QString& message = d.messages[AVRealtime::MEMORY];
+    if (!d.lockmemory) {
+        message = "not locked";
+        return true;
+    }
+#if defined(Q_OS_MACOS)
+    message = "locking failed: mlockall is not supported on macos, lock frame buffers instead";
+    return false;
+#else
+    if (mlockall(MCL_CURRENT) != 0) { // MCL_FUTURE would fail later allocations beyond RLIMIT_MEMLOCK
+        message = QString("locking failed: %1").arg(error(errno));
+        return false;
+    }
+    message = "locked current pages";
+    return true;
+#endif
+}
+
+AVRealtime::AVRealtime()
+: p(new AVRealtimePrivate())
+{
+}
+
+AVRealtime::~AVRealtime()
+{
+    restore();
+}
+
+bool
+AVRealtime::apply()
+{
+    Q_ASSERT("realtime profile already applied" && !p->d.threaded);
+
+    p->d.thread = pthread_self();
+    p->d.threaded = true;
+#if !defined(Q_OS_MACOS)
+    p->d.tid = static_cast<pid_t>(syscall(SYS_gettid));
+#endif
+    p->d.applied[SCHEDULING] = p->scheduling();
+    p->d.applied[AFFINITY] = p->affinity();
+    p->d.applied[MEMORY] = p->memory();
+    bool applied = p->d.applied[SCHEDULING] && p->d.applied[AFFINITY] && p->d.applied[MEMORY];
+    if (!applied) {
+        qWarning() << "warning: " << "realtime profile partially applied:" << report();
+    }
+    return applied;
+}
+
+void
+AVRealtime::restore()
+{
+    if (!p->d.threaded) {
+        return;
+    }
+    if (p->d.policy != DEFAULT && p->d.applied[SCHEDULING]) {
+#if defined(Q_OS_MACOS)
+        thread_standard_policy_data_t policy;
+        thread_policy_set(pthread_mach_thread_np(p->d.thread), THREAD_STANDARD_POLICY,
+                          reinterpret_cast<thread_policy_t>(&policy), THREAD_STANDARD_POLICY_COUNT);
+#else
+        sched_param param;
+        param.sched_priority = p->d.previouspriority;
+        pthread_setschedparam(p->d.thread, p->d.previouspolicy, &param);
+#endif
+    }
+#if !defined(Q_OS_MACOS)
+    if (p->d.niced) {
+        setpriority(PRIO_PROCESS, p->d.tid, p->d.previousnice);
+        p->d.niced = false;
+    }
+    if (!p->d.cpus.isEmpty() && p->d.applied[AFFINITY]) {
+        pthread_setaffinity_np(p->d.thread, sizeof(cpu_set_t), &p->d.previouscpus);
+    }
+    if (p->d.lockmemory && p->d.applied[MEMORY]) {
+        munlockall();
+    }
+#endif
+    p->d.threaded = false;
+    p->d.applied[SCHEDULING] = p->d.applied[AFFINITY] = p->d.applied[MEMORY] = false;
+}
+
+bool
+AVRealtime::is_applied(Step step) const
+{
+    return p->d.applied[step];
+}
+
+QString
+AVRealtime::message(Step step) const
+{
+    return p->d.messages[step];
+}
+
+QList<QString>
+AVRealtime::report() const
+{
+    return {
+        QString("scheduling: %1").arg(p->d.messages[SCHEDULING]),
+        QString("affinity: %1").arg(p->d.messages[AFFINITY]),
+        QString("memory: %1").arg(p->d.messages[MEMORY])
+    };
+}
+
+AVRealtime::Policy
+AVRealtime::policy() const
+{
+    return p->d.policy;
+}
+
+int
+AVRealtime::priority() const
+{
+    return p->d.priority;
+}
+
+quint64
+AVRealtime::period() const
+{
+    return p->d.period;
+}
+
+QList<int>
+AVRealtime::cpus() const
+{
+    return p->d.cpus;
+}
+
+bool
+AVRealtime::lock_memory() const
+{
+    return p->d.lockmemory;
+}
+
+void
+AVRealtime::set_policy(Policy policy)
+{
+    p->d.policy = policy;
+}
+
+void
+AVRealtime::set_priority(int priority)
+{
+    p->d.priority = priority;
+}
+
+void
+AVRealtime::set_period(quint64 nanos)
+{
+    p->d.period = nanos;
+}
+
+void
+AVRealtime::set_cpus(const QList<int>& cpus)
+{
+    p->d.cpus = cpus;
+}
+
+void
+AVRealtime::set_lock_memory(bool lock)
+{
+    p->d.lockmemory = lock;
+}
+
+int
+AVRealtime::cpu_count()
+{
+    return QThread::idealThreadCount();
+}
+
+bool
+AVRealtime::lock(const void* data, qsizetype size)
+{
+    return mlock(data, static_cast<size_t>(size)) == 0;
+}
+
+bool
+AVRealtime::unlock(const void* data, qsizetype size)
+{
+    return munlock(data, static_cast<size_t>(size)) == 0;
+}
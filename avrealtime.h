@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include <QList>
+#include <QScopedPointer>
+#include <QString>
+
+class AVRealtimePrivate;
+class AVRealtime
+{
+    public:
+        enum Policy { DEFAULT, FIFO, RR }; // SCHED_FIFO and SCHED_RR on linux, time constraint on macos
+        enum Step { SCHEDULING, AFFINITY, MEMORY };
+
+    public:
+        AVRealtime();
+        ~AVRealtime();
+        bool apply(); // to the calling thread, true if every requested step succeeded
+        void restore();
+        bool is_applied(Step step) const;
+        QString message(Step step) const;
+        QList<QString> report() const;
+        AVRealtime::Policy policy() const;
+        int priority() const;
+        quint64 period() const;
+        QList<int> cpus() const;
+        bool lock_memory() const;
+        void set_policy(Policy policy);
+        void set_priority(int priority);
+        void set_period(quint64 nanos);
+        void set_cpus(const QList<int>& cpus);
+        void set_lock_memory(bool lock); // process wide mlockall of current pages, restore() also drops locks taken with lock()
+
+        static int cpu_count();
+        static bool lock(const void* data, qsizetype size); // keeps frame buffers resident
+        static bool unlock(const void* data, qsizetype size);
+
+    private:
+        QScopedPointer<AVRealtimePrivate> p;
+};
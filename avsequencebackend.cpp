@@ -0,0 +1,410 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avsequencebackend.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QImageReader>
+#include <QMap>
+#include <QRegularExpression>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <QDebug>
+
+class AVSequenceBackendPrivate
+{
+    public:
+        AVSequenceBackendPrivate();
+        ~AVSequenceBackendPrivate();
+        bool open();
+        void close();
+        void schedule();
+        void cancel();
+        qint64 readahead() const;
+        AVTime time(qint64 frame) const;
+        bool fail(AVReader::Error error, const QString& message);
+        struct Data
+        {
+            QList<QString> paths; // one per frame from the first to the last file
+            QString pattern;
+            qint64 first = 0;
+            qint64 missing = 0;
+            AVFps fps = AVFps::fps_24();
+            AVBackend::Info info;
+            QThreadPool pool; // decode workers, not shared with the global pool
+            QHash<qint64, QFuture<QImage>> pending; // decodes in flight, delivered in frame order
+            qint64 readahead = 0; // frames, twice the workers when 0
+            qint64 frame = 0; // next frame to read
+            qint64 previous = -1;
+            qint64 direction = 1;
+            QString filename;
+            QString errormessage;
+            AVReader::Error error = AVReader::NO_ERROR;
+        };
+        Data d;
+        AVSequenceBackend* object;
+};
+
+AVSequenceBackendPrivate::AVSequenceBackendPrivate()
+{
+    d.pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+AVSequenceBackendPrivate::~AVSequenceBackendPrivate()
+{
+    cancel();
+}
+
+bool
+AVSequenceBackendPrivate::fail(AVReader::Error error, const QString& message)
+{
+    d.error = error;
+    d.errormessage = message;
+    qWarning() << "warning: " << d.errormessage;
+    return false;
+}
+
+bool
+AVSequenceBackendPrivate::open()
+{
+    QFileInfo fileinfo(d.filename);
+    if (!fileinfo.isFile()) {
+        return fail(AVReader::FILE_ERROR, QString("unable to find image file: %1").arg(d.filename));
+    }
+    // name.####.ext, the last run of digits before the extension is the frame number
+    static const QRegularExpression expression("^(.*?)(\\d+)(\\.[^.]+)$");
+    QRegularExpressionMatch match = expression.match(fileinfo.fileName());
+    QMap<qint64, QString> files;
+    if (match.hasMatch()) {
+        QString prefix = match.captured(1);
+        QString digits = match.captured(2);
+        QString extension = match.captured(3);
+        bool padded = digits.startsWith('0') && digits.size() > 1;
+        QDir dir = fileinfo.dir();
+        const QList<QString> entries = dir.entryList({ prefix + "*" + extension }, QDir::Files);
+        for (const QString& entry : entries) {
+            QRegularExpressionMatch other = expression.match(entry);
+            if (!other.hasMatch() || other.captured(1) != prefix || other.captured(3) != extension) {
+                continue;
+            }
+            QString number = other.captured(2);
+            if (padded && number.size() != digits.size()) { // 0001 and 1 are different sequences
+                continue;
+            }
+            files.insert(number.toLongLong(), dir.filePath(entry));
+        }
+        d.pattern = prefix + QString(padded ? digits.size() : 1, '#') + extension;
+    }
+    else {
+        files.insert(0, fileinfo.filePath()); // a single image is a one frame sequence
+        d.pattern = fileinfo.fileName();
+    }
+    d.first = files.firstKey();
+    qint64 last = files.lastKey();
+    d.paths.reserve(last - d.first + 1);
+    QString previous;
+    for (qint64 number = d.first; number <= last; number++) {
+        auto it = files.constFind(number);
+        if (it != files.constEnd()) {
+            previous = it.value();
+        }
+        else {
+            d.missing++;
+        }
+        d.paths.append(previous);
+    }
+    AVBackend::Info info;
+    info.fps = d.fps;
+    info.start = AVTime(d.first, info.fps); // frame numbers are the timecode unless the file has one
+    info.title = d.pattern;
+    info.metadata.add_pair("media type", "image sequence");
+    info.metadata.add_pair("pattern", d.pattern);
+    if (!object->inspect(d.paths.first(), info)) {
+        return false;
+    }
+    // the range starts at the first frame number, the start timecode is relative to it
+    qint32 timescale = info.fps.frame_quanta() * 1000;
+    AVTime zero(0, timescale, info.fps);
+    qint64 timecode = AVTime::convert(info.start, timescale).frames();
+    d.info = info;
+    d.info.start = AVTime(zero, zero.ticks(timecode - d.first));
+    d.info.range = AVTimeRange(AVTime(zero, zero.ticks(d.first)), AVTime(zero, zero.ticks(d.paths.size())));
+    d.info.metadata.add_pair("frames", QString::number(d.paths.size()));
+    d.info.metadata.add_pair("missing frames", QString::number(d.missing));
+    d.frame = 0;
+    d.previous = -1;
+    d.direction = 1;
+    schedule();
+    return true;
+}
+
+void
+AVSequenceBackendPrivate::close()
+{
+    cancel();
+    d.paths.clear();
+    d.pattern = QString();
+    d.first = 0;
+    d.missing = 0;
+    d.info = AVBackend::Info();
+    d.frame = 0;
+    d.previous = -1;
+    d.direction = 1;
+    d.errormessage = QString();
+    d.error = AVReader::NO_ERROR;
+}
+
+void
+AVSequenceBackendPrivate::schedule()
+{
+    // keeps the next frames in the playback direction decoding, results are taken in frame order
+    qint64 count = readahead();
+    for (auto it = d.pending.begin(); it != d.pending.end();) {
+        qint64 distance = (it.key() - d.frame) * d.direction;
+        if (distance < 0 || distance >= count) { // behind or beyond the window, finishes in the background
+            it = d.pending.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    for (qint64 i = 0; i < count; i++) {
+        qint64 frame = d.frame + i * d.direction;
+        if (frame < 0 || frame >= d.paths.size()) {
+            break;
+        }
+        if (!d.pending.contains(frame)) {
+            d.pending.insert(frame, QtConcurrent::run(&d.pool, [this, path = d.paths[frame]] {
+                return object->decode(path);
+            }));
+        }
+    }
+}
+
+void
+AVSequenceBackendPrivate::cancel()
+{
+    d.pool.clear(); // queued decodes never start, their futures are dropped with them
+    d.pool.waitForDone();
+    d.pending.clear();
+}
+
+qint64
+AVSequenceBackendPrivate::readahead() const
+{
+    return d.readahead > 0 ? d.readahead : qMax(2, d.pool.maxThreadCount()) * 2;
+}
+
+AVTime
+AVSequenceBackendPrivate::time(qint64 frame) const
+{
+    return AVTime(d.info.range.start(), d.info.range.start().ticks(d.first + frame));
+}
+
+AVSequenceBackend::AVSequenceBackend()
+: p(new AVSequenceBackendPrivate())
+{
+    p->object = this;
+}
+
+AVSequenceBackend::~AVSequenceBackend()
+{
+}
+
+QString
+AVSequenceBackend::name() const
+{
+    return "sequence";
+}
+
+bool
+AVSequenceBackend::probe(const QString& filename) const
+{
+    QFileInfo fileinfo(filename);
+    return fileinfo.isFile() && QImageReader::supportedImageFormats().contains(fileinfo.suffix().toLower().toLatin1());
+}
+
+bool
+AVSequenceBackend::open(const QString& filename)
+{
+    p->close();
+    p->d.filename = filename;
+    return p->open();
+}
+
+void
+AVSequenceBackend::close()
+{
+    p->close();
+}
+
+bool
+AVSequenceBackend::seek(const AVTime& time)
+{
+    if (p->d.paths.isEmpty()) {
+        return p->fail(AVReader::API_ERROR, "unable to seek, no sequence is open");
+    }
+    qint64 frame = qBound(qint64(0), time.frames() - p->d.first, p->d.paths.size() - 1);
+    qint64 direction = frame < p->d.previous ? -1 : 1;
+    if (direction != p->d.direction || qAbs(frame - p->d.frame) >= p->readahead()) {
+        p->cancel(); // outside the decodes in flight, start over at the new position
+    }
+    p->d.direction = direction;
+    p->d.frame = frame;
+    p->schedule();
+    return true;
+}
+
+bool
+AVSequenceBackend::read(QImage& image, AVTime& time)
+{
+    if (p->d.frame >= p->d.paths.size()) {
+        return p->fail(AVReader::API_ERROR, "unable to read frame past the end of the sequence");
+    }
+    qint64 frame = p->d.frame;
+    if (frame == p->d.previous + 1) {
+        p->d.direction = 1; // stepping forward again, a backward seek no longer holds the window behind
+    }
+    p->schedule();
+    QFuture<QImage> future = p->d.pending.take(frame);
+    image = future.result();
+    if (image.isNull()) {
+        return p->fail(AVReader::API_ERROR, QString("unable to decode image: %1").arg(p->d.paths[frame]));
+    }
+    return drop(time);
+}
+
+bool
+AVSequenceBackend::drop(AVTime& time)
+{
+    if (p->d.frame >= p->d.paths.size()) {
+        return p->fail(AVReader::API_ERROR, "unable to drop frame past the end of the sequence");
+    }
+    qint64 frame = p->d.frame++;
+    if (frame == p->d.previous + 1) {
+        p->d.direction = 1;
+    }
+    p->d.pending.remove(frame); // a dropped decode finishes in the background
+    p->d.previous = frame;
+    p->schedule();
+    time = p->time(frame);
+    return true;
+}
+
+AVBackend::Info
+AVSequenceBackend::info() const
+{
+    return p->d.info;
+}
+
+AVReader::Error
+AVSequenceBackend::error() const
+{
+    return p->d.error;
+}
+
+QString
+AVSequenceBackend::error_message() const
+{
+    return p->d.errormessage;
+}
+
+QString
+AVSequenceBackend::pattern() const
+{
+    return p->d.pattern;
+}
+
+QString
+AVSequenceBackend::path(qint64 frame) const
+{
+    return p->d.paths.value(frame);
+}
+
+qint64
+AVSequenceBackend::first() const
+{
+    return p->d.first;
+}
+
+qint64
+AVSequenceBackend::count() const
+{
+    return p->d.paths.size();
+}
+
+qint64
+AVSequenceBackend::missing() const
+{
+    return p->d.missing;
+}
+
+int
+AVSequenceBackend::threads() const
+{
+    return p->d.pool.maxThreadCount();
+}
+
+qint64
+AVSequenceBackend::readahead() const
+{
+    return p->readahead();
+}
+
+void
+AVSequenceBackend::set_fps(const AVFps& fps)
+{
+    p->d.fps = fps;
+}
+
+void
+AVSequenceBackend::set_threads(int threads)
+{
+    p->d.pool.setMaxThreadCount(qMax(1, threads));
+}
+
+void
+AVSequenceBackend::set_readahead(qint64 frames)
+{
+    p->d.readahead = frames;
+}
+
+QImage
+AVSequenceBackend::decode(const QString& path) const
+{
+    QImageReader reader(path);
+    QImage image = reader.read();
+    if (image.isNull()) {
+        qWarning() << "warning: " << "unable to decode image:" << path << reader.errorString();
+    }
+    return image;
+}
+
+bool
+AVSequenceBackend::inspect(const QString& path, AVBackend::Info& info)
+{
+    QImageReader reader(path);
+    if (!reader.canRead()) {
+        return p->fail(AVReader::FILE_ERROR, QString("unable to read image: %1: %2").arg(path).arg(reader.errorString()));
+    }
+    QSize size = reader.size();
+    info.metadata.add_pair("format", QString::fromLatin1(reader.format()));
+    info.metadata.add_pair("resolution", QString("%1x%2").arg(size.width()).arg(size.height()));
+    return true;
+}
+
+bool
+AVSequenceBackend::fail(AVReader::Error error, const QString& message)
+{
+    return p->fail(error, message);
+}
+
+QList<QString>
+AVSequenceBackend::formats()
+{
+    return { "png", "jpg", "jpeg", "tif", "tiff", "ppm", "pgm", "pbm", "bmp", "webp" };
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avbackend.h"
+
+#include <QScopedPointer>
+
+class AVSequenceBackendPrivate;
+class AVSequenceBackend : public AVBackend {
+    public:
+        AVSequenceBackend();
+        virtual ~AVSequenceBackend();
+        QString name() const override;
+        bool probe(const QString& filename) const override;
+        bool open(const QString& filename) override;
+        void close() override;
+        bool seek(const AVTime& time) override;
+        bool read(QImage& image, AVTime& time) override;
+        bool drop(AVTime& time) override;
+        AVBackend::Info info() const override;
+        AVReader::Error error() const override;
+        QString error_message() const override;
+        QString pattern() const; // name.####.ext
+        QString path(qint64 frame) const; // missing frames hold the previous file
+        qint64 first() const; // frame number of the first file
+        qint64 count() const;
+        qint64 missing() const;
+        int threads() const;
+        qint64 readahead() const;
+        void set_fps(const AVFps& fps); // sequences carry no rate, 24 fps until set before open
+        void set_threads(int threads);
+        void set_readahead(qint64 frames); // decodes in flight ahead of the read position
+
+        static QList<QString> formats();
+
+    protected:
+        // decode runs on the pool workers, subclasses close() in their destructor so none is in flight
+        virtual QImage decode(const QString& path) const;
+        virtual bool inspect(const QString& path, AVBackend::Info& info); // first file, may set fps, start and metadata
+        bool fail(AVReader::Error error, const QString& message);
+
+    private:
+        QScopedPointer<AVSequenceBackendPrivate> p;
+};
@@ -2,6 +2,7 @@
 // Copyright (c) 2022 - present Mikael Sundell.
 
 #include "avsmptetime.h"
+#include "avrate.h"
 
 #include <QDebug>
 
@@ -9,18 +10,38 @@ class AVSmpteTimePrivate
 {
     public:
         AVSmpteTimePrivate();
+        AVSmpteTimePrivate(const AVSmpteTimePrivate& other);
         qint64 frame() const;
         void update();
+        void increment();
+        void decrement();
+        void advance(qint64 frames);
+        struct Fields
+        {
+            qint16 hours = 0;
+            qint16 minutes = 0;
+            qint16 seconds = 0;
+            qint16 frames = 0;
+        };
+        Fields fields() const;
+        static Fields label(qint64 frame, const AVFps& fps, bool fullhours);
+        static Fields fields(const Fields& label, bool negative, bool negatives, bool fullhours);
+        static Fields fields(qint64 frame, const AVFps& fps, bool negatives, bool fullhours);
+        static qsizetype to_chars(char* buffer, qsizetype size, const Fields& fields, bool dropframe);
+        static char* digits(char* buffer, qint64 value, int width);
+        static qint64 dropframes(const AVFps& fps);
         struct Data
         {
             AVTime time;
-            quint32 counter = 0;
-            qint16 hours = 0;
+            qint64 frame = 0;
+            qint64 base = 0; // frame of time, time is derived once the counter has advanced
+            qint16 hours = 0; // label of the absolute frame, hours wrap at 24 for fullhours
             qint16 minutes = 0;
             qint16 seconds = 0;
             qint16 frames = 0;
-            qint16 subframes = 1;
-            qint16 subframe_divisor = 0;
+            qint16 framequanta = 0;
+            qint16 dropframes = 0;
+            bool negative = false;
             bool negatives = true;
             bool fullhours = true;
         };
@@ -32,12 +53,15 @@ AVSmpteTimePrivate::AVSmpteTimePrivate()
 {
 }
 
+AVSmpteTimePrivate::AVSmpteTimePrivate(const AVSmpteTimePrivate& other)
+: d(other.d) // detached copies start with a fresh ref count
+{
+}
+
 qint64
 AVSmpteTimePrivate::frame() const
 {
-    Q_ASSERT("time is not valid" && d.time.valid());
-    
-    return d.time.frames();
+    return d.frame;
 }
 
 void
@@ -45,94 +69,341 @@ AVSmpteTimePrivate::update()
 {
     Q_ASSERT("time is not valid" && d.time.valid());
     
-    qint64 frame = d.time.frames();
-    qint16 framequanta = d.time.fps().frame_quanta();
-    bool is_negative = false;
-    if (frame < 0) {
-        is_negative = true;
-        frame = -frame;
+    Fields smpte = label(qAbs(d.frame), d.time.fps(), d.fullhours);
+    d.hours = smpte.hours;
+    d.minutes = smpte.minutes;
+    d.seconds = smpte.seconds;
+    d.frames = smpte.frames;
+    d.framequanta = d.time.fps().frame_quanta();
+    d.dropframes = dropframes(d.time.fps());
+    d.negative = d.frame < 0;
+}
+
+void
+AVSmpteTimePrivate::increment()
+{
+    if (++d.frames < d.framequanta) {
+        return;
+    }
+    d.frames = 0;
+    if (++d.seconds < 60) {
+        return;
     }
-    frame = AVSmpteTime::convert(frame, d.time.fps(), true);
-    d.frames = frame % framequanta;
+    d.seconds = 0;
+    if (++d.minutes == 60) {
+        d.minutes = 0;
+        if (++d.hours == 24 && d.fullhours) {
+            d.hours = 0;
+        }
+    }
+    if (d.minutes % 10) { // skip dropped labels, once per minute
+        d.frames = d.dropframes;
+    }
+}
+
+void
+AVSmpteTimePrivate::decrement()
+{
+    qint16 first = (d.seconds == 0 && d.minutes % 10) ? d.dropframes : 0;
+    if (d.frames > first) {
+        d.frames--;
+        return;
+    }
+    d.frames = d.framequanta - 1;
+    if (d.seconds > 0) {
+        d.seconds--;
+        return;
+    }
+    d.seconds = 59;
+    if (d.minutes > 0) {
+        d.minutes--;
+        return;
+    }
+    d.minutes = 59;
+    d.hours = (d.hours == 0 && d.fullhours) ? 23 : d.hours - 1;
+}
+
+void
+AVSmpteTimePrivate::advance(qint64 frames)
+{
+    qint64 frame = d.frame + frames;
+    if ((frame < 0) != d.negative) { // crosses zero, label counts back up from 00:00:00:00
+        d.frame = frame;
+        update();
+        return;
+    }
+    qint64 steps = d.negative ? -frames : frames; // steps of the absolute frame
+    d.frame = frame;
+    if (steps == 1) {
+        increment();
+    }
+    else if (steps == -1) {
+        decrement();
+    }
+    else if (steps != 0) {
+        qint64 first = (d.seconds == 0 && d.minutes % 10) ? d.dropframes : 0;
+        qint64 next = d.frames + steps;
+        if (next >= first && next < d.framequanta) { // within the same second
+            d.frames = next;
+        }
+        else {
+            update();
+        }
+    }
+}
+
+AVSmpteTimePrivate::Fields
+AVSmpteTimePrivate::fields() const
+{
+    Fields smpte;
+    smpte.hours = d.hours;
+    smpte.minutes = d.minutes;
+    smpte.seconds = d.seconds;
+    smpte.frames = d.frames;
+    return fields(smpte, d.negative, d.negatives, d.fullhours);
+}
+
+AVSmpteTimePrivate::Fields
+AVSmpteTimePrivate::label(qint64 frame, const AVFps& fps, bool fullhours)
+{
+    Fields smpte;
+    qint16 framequanta = fps.frame_quanta();
+    frame = AVSmpteTime::convert(frame, fps, true);
+    smpte.frames = frame % framequanta;
     frame /= framequanta;
-    d.seconds =  frame % 60;
+    smpte.seconds =  frame % 60;
     frame /= 60;
-    d.minutes = frame % 60;
+    smpte.minutes = frame % 60;
     frame /= 60;
-    if (d.fullhours) {
+    if (fullhours) {
         frame %= 24;
-        if (is_negative && !d.negatives) {
-            is_negative = false;
-            frame = 23 - frame;
+    }
+    smpte.hours = frame;
+    return smpte;
+}
+
+AVSmpteTimePrivate::Fields
+AVSmpteTimePrivate::fields(const Fields& label, bool negative, bool negatives, bool fullhours)
+{
+    Fields smpte = label;
+    if (negative && fullhours && !negatives) {
+        smpte.hours = 23 - smpte.hours;
+    }
+    else if (negative) {
+        smpte.minutes |= 0x80; // indicate negative number
+    }
+    return smpte;
+}
+
+AVSmpteTimePrivate::Fields
+AVSmpteTimePrivate::fields(qint64 frame, const AVFps& fps, bool negatives, bool fullhours)
+{
+    return fields(label(qAbs(frame), fps, fullhours), frame < 0, negatives, fullhours);
+}
+
+qsizetype
+AVSmpteTimePrivate::to_chars(char* buffer, qsizetype size, const Fields& fields, bool dropframe)
+{
+    if (size < AVSmpteTime::max_chars) {
+        return 0;
+    }
+    char* out = buffer;
+    qint16 minutes = fields.minutes;
+    if (minutes & 0x80) {
+        *out++ = '-';
+        minutes &= 0x7f;
+    }
+    out = digits(out, fields.hours, 2);
+    *out++ = ':';
+    out = digits(out, minutes, 2);
+    *out++ = ':';
+    out = digits(out, fields.seconds, 2);
+    *out++ = dropframe ? '.' : ':'; // use . for drop frames
+    out = digits(out, fields.frames, 2);
+    *out = '\0';
+    return out - buffer;
+}
+
+char*
+AVSmpteTimePrivate::digits(char* buffer, qint64 value, int width)
+{
+    char reversed[20];
+    int count = 0;
+    do {
+        reversed[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count < width) {
+        reversed[count++] = '0';
+    }
+    while (count > 0) {
+        *buffer++ = reversed[--count];
+    }
+    return buffer;
+}
+
+qint64
+AVSmpteTimePrivate::dropframes(const AVFps& fps)
+{
+    if (!fps.drop_frame()) {
+        return 0;
+    }
+    qint64 dropframes = 0;
+    if (AVRates::dispatch(fps, [&](auto rate) { dropframes = decltype(rate)::drop_frames; })) {
+        return dropframes;
+    }
+    return (fps.frame_quanta() + 7) / 15; // round(fps * 0.066666) as in test.py, 2 for 29.97 and 4 for 59.94
+}
+
+AVSmpteWord::AVSmpteWord(qint16 hours, qint16 minutes, qint16 seconds, qint16 frames, bool dropframe)
+{
+    Q_ASSERT("fields are out of range" && hours >= 0 && hours < 40 && minutes >= 0 && minutes < 60 &&
+        seconds >= 0 && seconds < 60 && frames >= 0 && frames < 40);
+
+    auto bcd = [](qint16 value, int shift) {
+        return (quint64(value % 10) << shift) | (quint64(value / 10) << (shift + 8));
+    };
+    d.bits = bcd(hours, 48) | bcd(minutes, 32) | bcd(seconds, 16) | bcd(frames, 0);
+    set_drop_frame(dropframe);
+}
+
+AVSmpteWord::AVSmpteWord(qint64 frame, const AVFps& fps)
+{
+    qint64 framesday = AVSmpteTime::convert(fps.frame_quanta() * 60 * 60 * 24, fps); // frames in 24 hours of labels
+    frame %= framesday;
+    if (frame < 0) {
+        frame += framesday;
+    }
+    AVSmpteTimePrivate::Fields smpte = AVSmpteTimePrivate::label(frame, fps, true);
+    if (fps.frame_quanta() > 30) { // frame pairs for rates above 30 fps, as in ST 12-1
+        smpte.frames /= 2;
+    }
+    *this = AVSmpteWord(smpte.hours, smpte.minutes, smpte.seconds, smpte.frames, fps.drop_frame());
+}
+
+quint32
+AVSmpteWord::userbits() const
+{
+    quint32 userbits = 0;
+    for (int group = 0; group < 8; group++) {
+        userbits |= static_cast<quint32>((d.bits >> (group * 8 + 4)) & 0xf) << (group * 4);
+    }
+    return userbits;
+}
+
+qint64
+AVSmpteWord::frame(const AVFps& fps) const
+{
+    qint64 frames = fps.frame_quanta() > 30 ? this->frames() * 2 : this->frames(); // first frame of the pair
+    qint64 label = ((hours() * 60 + minutes()) * 60 + seconds()) * qint64(fps.frame_quanta()) + frames;
+    return AVSmpteTime::convert(label, fps, false);
+}
+
+qsizetype
+AVSmpteWord::to_chars(char* buffer, qsizetype size) const
+{
+    AVSmpteTimePrivate::Fields smpte;
+    smpte.hours = hours();
+    smpte.minutes = minutes();
+    smpte.seconds = seconds();
+    smpte.frames = frames();
+    return AVSmpteTimePrivate::to_chars(buffer, size, smpte, drop_frame());
+}
+
+QString
+AVSmpteWord::to_string() const
+{
+    char buffer[AVSmpteTime::max_chars];
+    return QString::fromLatin1(buffer, to_chars(buffer, sizeof(buffer)));
+}
+
+bool
+AVSmpteWord::valid() const
+{
+    for (int shift = 0; shift < 64; shift += 16) {
+        if (((d.bits >> shift) & 0xf) > 9) { // units digit of each field
+            return false;
         }
     }
-    d.hours = frame;
-    if (is_negative) {
-        d.minutes |= 0x80; // indicate negative number
+    return hours() < 24 && minutes() < 60 && seconds() < 60 && frames() < 30;
+}
+
+void
+AVSmpteWord::set_drop_frame(bool dropframe)
+{
+    d.bits = dropframe ? d.bits | dropframe_bit : d.bits & ~dropframe_bit;
+}
+
+void
+AVSmpteWord::set_color_frame(bool colorframe)
+{
+    d.bits = colorframe ? d.bits | colorframe_bit : d.bits & ~colorframe_bit;
+}
+
+void
+AVSmpteWord::set_userbits(quint32 userbits)
+{
+    d.bits &= ~userbits_mask;
+    for (int group = 0; group < 8; group++) {
+        d.bits |= static_cast<quint64>((userbits >> (group * 4)) & 0xf) << (group * 8 + 4);
     }
 }
+
+void
+AVSmpteWord::set_bits(quint64 bits)
+{
+    d.bits = bits;
+}
     
 AVSmpteTime::AVSmpteTime()
 : p(new AVSmpteTimePrivate())
 {
+    p->update();
 }
 
 AVSmpteTime::AVSmpteTime(const AVTime& time)
 : p(new AVSmpteTimePrivate())
 {
-    p->d.time = time;
-    p->update();
+    set_time(time);
 }
 
-AVSmpteTime::AVSmpteTime(const AVSmpteTime& other)
-: p(other.p)
+AVSmpteTime::AVSmpteTime(const AVSmpteWord& word, const AVFps& fps)
+: p(new AVSmpteTimePrivate())
 {
+    set_time(AVTime(word.frame(fps), fps));
 }
 
-AVSmpteTime::~AVSmpteTime()
+AVSmpteTime::AVSmpteTime(const AVSmpteTime& other)
+: p(other.p)
 {
 }
 
-quint32
-AVSmpteTime::counter() const
+AVSmpteTime::~AVSmpteTime()
 {
-    return p->d.counter;
 }
 
 qint16
 AVSmpteTime::hours() const
 {
-    return p->d.hours;
+    return p->fields().hours;
 }
 
 qint16
 AVSmpteTime::minutes() const
 {
-    return p->d.minutes;
+    return p->fields().minutes;
 }
 
 qint16
 AVSmpteTime::seconds() const
 {
-    return p->d.seconds;
+    return p->fields().seconds;
 }
 
 qint16
 AVSmpteTime::frames() const
 {
-    return p->d.frames;
-}
-
-qint16
-AVSmpteTime::subframes() const
-{
-    return p->d.subframes;
-}
-
-qint16
-AVSmpteTime::subframe_divisor() const
-{
-    return p->d.subframe_divisor;
+    return p->fields().frames;
 }
 
 qint64
@@ -144,15 +415,33 @@ AVSmpteTime::frame() const
 AVTime
 AVSmpteTime::time() const
 {
+    if (p->d.frame != p->d.base) {
+        return AVTime(p->d.time, p->d.time.ticks(p->d.frame));
+    }
     return p->d.time;
 }
 
+AVSmpteWord
+AVSmpteTime::word() const
+{
+    if (!p->d.negative && p->d.hours < 24 && p->d.framequanta <= 30) {
+        return AVSmpteWord(p->d.hours, p->d.minutes, p->d.seconds, p->d.frames, p->d.time.fps().drop_frame());
+    }
+    return AVSmpteWord(p->d.frame, p->d.time.fps()); // wraps into 24 hours
+}
+
 bool
 AVSmpteTime::negatives() const
 {
     return p->d.negatives;
 }
 
+bool
+AVSmpteTime::fullhours() const
+{
+    return p->d.fullhours;
+}
+
 void
 AVSmpteTime::set_time(const AVTime& time)
 {
@@ -160,9 +449,20 @@ AVSmpteTime::set_time(const AVTime& time)
         p.detach();
     }
     p->d.time = time;
+    p->d.frame = time.frames();
+    p->d.base = p->d.frame;
     p->update();
 }
 
+void
+AVSmpteTime::advance(qint64 frames)
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->advance(frames);
+}
+
 void
 AVSmpteTime::set_negatives(bool negatives)
 {
@@ -190,18 +490,14 @@ AVSmpteTime::set_fullhours(bool fullhours)
 QString
 AVSmpteTime::to_string() const
 {
-    QString text;
-    if (p->d.time.fps().drop_frame()) {
-        text = "%1:%2:%3.%4"; // use . for drop frames
-    }
-    else {
-        text = "%1:%2:%3:%4";
-    }
-    return QString(text)
-        .arg(p->d.hours, 2, 10, QChar('0'))
-        .arg(p->d.minutes, 2, 10, QChar('0'))
-        .arg(p->d.seconds, 2, 10, QChar('0'))
-        .arg(p->d.frames, 2, 10, QChar('0'));
+    char buffer[max_chars];
+    return QString::fromLatin1(buffer, to_chars(buffer, max_chars));
+}
+
+qsizetype
+AVSmpteTime::to_chars(char* buffer, qsizetype size) const
+{
+    return AVSmpteTimePrivate::to_chars(buffer, size, p->fields(), p->d.time.fps().drop_frame());
 }
 
 void
@@ -214,18 +510,18 @@ AVSmpteTime::invalidate() {
     
 bool
 AVSmpteTime::valid() const {
-    return p->d.hours >= 0 && p->d.hours < 24 &&
+    return p->d.time.valid() &&
+        p->d.hours >= 0 && (p->d.hours < 24 || !p->d.fullhours) &&
         p->d.minutes >= 0 && p->d.minutes < 60 &&
         p->d.seconds >= 0 && p->d.seconds < 60 &&
-        p->d.frames >= 0 && p->d.subframes >= 0 &&
-        p->d.subframe_divisor > 0;
+        p->d.frames >= 0 && p->d.frames < p->d.framequanta;
 }
 
 AVSmpteTime&
 AVSmpteTime::operator=(const AVSmpteTime& other)
 {
     if (this != &other) {
-        *p = *other.p;
+        p = other.p;
     }
     return *this;
 }
@@ -233,13 +529,11 @@ AVSmpteTime::operator=(const AVSmpteTime& other)
 bool
 AVSmpteTime::operator==(const AVSmpteTime& other) const
 {
-    return p->d.counter == other.p->d.counter &&
-        p->d.hours == other.p->d.hours &&
+    return p->d.hours == other.p->d.hours &&
         p->d.minutes == other.p->d.minutes &&
         p->d.seconds == other.p->d.seconds &&
         p->d.frames == other.p->d.frames &&
-        p->d.subframes == other.p->d.subframes &&
-        p->d.subframe_divisor == other.p->d.subframe_divisor;
+        p->d.negative == other.p->d.negative;
 }
 
 bool
@@ -248,6 +542,34 @@ AVSmpteTime::operator!=(const AVSmpteTime& other) const
     return !(*this == other);
 }
 
+AVSmpteTime&
+AVSmpteTime::operator++()
+{
+    advance(1);
+    return *this;
+}
+
+AVSmpteTime&
+AVSmpteTime::operator--()
+{
+    advance(-1);
+    return *this;
+}
+
+AVSmpteTime&
+AVSmpteTime::operator+=(qint64 frames)
+{
+    advance(frames);
+    return *this;
+}
+
+AVSmpteTime&
+AVSmpteTime::operator-=(qint64 frames)
+{
+    advance(-frames);
+    return *this;
+}
+
 bool
 AVSmpteTime::operator<(const AVSmpteTime& other) const {
     return this->frame() < other.frame();
@@ -271,7 +593,7 @@ AVSmpteTime::operator>=(const AVSmpteTime& other) const {
 AVSmpteTime
 AVSmpteTime::operator+(const AVSmpteTime& other) const {
     Q_ASSERT("fps must match" && p->d.time.fps() == other.time().fps());
-    qint64 frames = this->time().frames() + other.time().frames();
+    qint64 frames = frame() + other.frame();
     AVTime time = AVTime(frames, p->d.time.fps());
     return AVSmpteTime(time);
 }
@@ -279,7 +601,7 @@ AVSmpteTime::operator+(const AVSmpteTime& other) const {
 AVSmpteTime
 AVSmpteTime::operator-(const AVSmpteTime& other) const {
     Q_ASSERT("fps must match" && p->d.time.fps() == other.time().fps());
-    qint64 frames = this->time().frames() - other.time().frames();
+    qint64 frames = frame() - other.frame();
     AVTime time = AVTime(frames, p->d.time.fps());
     return AVSmpteTime(time);
 }
@@ -309,46 +631,106 @@ AVSmpteTime::convert(quint64 frame, const AVFps& from, const AVFps& to)
     return frame;
 }
 
+// changed with the formatter: the frame to label path lagged two frames per minute into each ten
+// minute block and handed out dropped labels such as 00:02:00;00, skipping valid ones, in the first
+// second of minutes 1-9. it now inverts the label to frame path exactly. drops are counted by rate, 2 for
+// 23.976 and 29.97, 3 for 47.952 and 4 for 59.94 where every drop frame rate used 2 before
 qint64
 AVSmpteTime::convert(quint64 frame, const AVFps& fps, bool reverse)
 {
     qint64 frametime = frame;
-    if (!reverse) {
-        if (fps.drop_frame()) {
-            qint16 framequanta = fps.frame_quanta();
-            qint64 framemin = framequanta * 60;
-            qint64 frame10min = framemin * 10 - 9 * 2;
-            qint64 num10s = frame / frame10min;
-            qint64 adjust = -num10s * (9 * 2);
-            qint64 left = frame % frame10min;
-            if (left > 1) {
-                qint64 num1s = left / framemin;
-                if (num1s > 0) {
-                    adjust -= (num1s - 1) * 2;
-                    left %= framemin;
-
-                    if (left > 1) {
-                        left = qBound(qint64(0), left - 2, framemin);
-                    } else {
-                        left = qBound(qint64(0), left - (left + 1), framemin);
-                    }
-                }
-            }
-            frametime += adjust;
-        }
+    if (AVRates::dispatch(fps, [&](auto rate) {
+        frametime = reverse ? decltype(rate)::to_label(frametime) : decltype(rate)::from_label(frametime);
+    })) {
+        return frametime;
     }
-    else {
-        if (fps.drop_frame()) {
-            qint64 framemin = fps.frame_quanta() * 60;
-            qint64 frame10min = framemin * 10 - 9 * 2;
+    qint64 dropframes = AVSmpteTimePrivate::dropframes(fps);
+    if (dropframes) {
+        qint64 framemin = fps.frame_quanta() * 60;
+        if (!reverse) { // timecode label to frame, skip dropped labels for every minute but each tenth
+            qint64 minutes = frametime / framemin;
+            frametime -= dropframes * (minutes - minutes / 10);
+        }
+        else { // frame to timecode label
+            qint64 frame10min = framemin * 10 - 9 * dropframes;
+            qint64 framedropmin = framemin - dropframes;
             qint64 frame10minblocks = frametime / frame10min;
             qint64 remaining = frametime % frame10min;
-            qint64 adjust = frame10minblocks * (9 * 2);
-            if (remaining >= framemin) {
-                adjust += (remaining / framemin) * 2;
+            qint64 adjust = frame10minblocks * 9 * dropframes;
+            if (remaining > dropframes) {
+                adjust += dropframes * ((remaining - dropframes) / framedropmin);
             }
             frametime = qBound(qint64(0), frametime + adjust, std::numeric_limits<qint64>::max());
         }
     }
     return frametime;
 }
+
+qsizetype
+AVSmpteTime::to_chars(const AVTime& time, char* buffer, qsizetype size)
+{
+    Q_ASSERT("time is not valid" && time.valid());
+
+    AVSmpteTimePrivate::Fields fields = AVSmpteTimePrivate::fields(time.frames(), time.fps(), true, true);
+    return AVSmpteTimePrivate::to_chars(buffer, size, fields, time.fps().drop_frame());
+}
+
+bool
+AVSmpteTime::parse(QByteArrayView text, const AVFps& fps, qint64& frame)
+{
+    text = text.trimmed();
+    const char* data = text.data();
+    qsizetype size = text.size();
+    qsizetype pos = 0;
+    bool negative = false;
+    if (pos < size && data[pos] == '-') {
+        negative = true;
+        pos++;
+    }
+    qint64 values[4] = { 0, 0, 0, 0 }; // hours, minutes, seconds, frames
+    for (int field = 0; field < 4; field++) {
+        if (field > 0) {
+            if (pos >= size) {
+                return false;
+            }
+            char separator = data[pos++];
+            if (separator != ':' && separator != ';' && separator != '.' && separator != ',') {
+                return false;
+            }
+        }
+        qsizetype start = pos;
+        while (pos < size && pos - start < 6 && data[pos] >= '0' && data[pos] <= '9') {
+            values[field] = values[field] * 10 + (data[pos++] - '0');
+        }
+        if (pos == start) {
+            return false;
+        }
+    }
+    qint64 framequanta = fps.frame_quanta();
+    if (pos != size || values[1] >= 60 || values[2] >= 60 || values[3] >= framequanta) {
+        return false;
+    }
+    qint64 dropframes = AVSmpteTimePrivate::dropframes(fps);
+    if (dropframes && values[2] == 0 && values[1] % 10 != 0 && values[3] < dropframes) {
+        return false; // dropped label, does not exist in drop frame timecode
+    }
+    qint64 label = ((values[0] * 60 + values[1]) * 60 + values[2]) * framequanta + values[3];
+    frame = convert(label, fps, false);
+    if (negative) {
+        frame = -frame;
+    }
+    return true;
+}
+
+qsizetype
+AVSmpteTime::parse(QSpan<const QByteArrayView> texts, const AVFps& fps, QSpan<qint64> frames)
+{
+    Q_ASSERT("span sizes does not match" && texts.size() == frames.size());
+
+    for (qsizetype i = 0; i < texts.size(); i++) {
+        if (!parse(texts[i], fps, frames[i])) {
+            return i;
+        }
+    }
+    return texts.size();
+}
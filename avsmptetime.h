@@ -6,36 +6,106 @@
 #include "avtime.h"
 #include "avfps.h"
 
+#include <QByteArrayView>
 #include <QExplicitlySharedDataPointer>
+#include <QHashFunctions>
+#include <QSpan>
+
+class AVSmpteWord
+{
+    public:
+        constexpr AVSmpteWord() = default;
+        constexpr explicit AVSmpteWord(quint64 bits)
+        : d { bits }
+        {
+        }
+        AVSmpteWord(qint16 hours, qint16 minutes, qint16 seconds, qint16 frames, bool dropframe = false);
+        AVSmpteWord(qint64 frame, const AVFps& fps);
+        constexpr AVSmpteWord(const AVSmpteWord& other) = default;
+        ~AVSmpteWord() = default;
+        constexpr qint16 hours() const { return digits(48, 2); }
+        constexpr qint16 minutes() const { return digits(32, 3); }
+        constexpr qint16 seconds() const { return digits(16, 3); }
+        constexpr qint16 frames() const { return digits(0, 2); }
+        constexpr bool drop_frame() const { return d.bits & dropframe_bit; }
+        constexpr bool color_frame() const { return d.bits & colorframe_bit; }
+        constexpr quint64 bits() const { return d.bits; }
+        constexpr quint64 key() const { return d.bits & time_mask; }
+        quint32 userbits() const;
+        qint64 frame(const AVFps& fps) const;
+        qsizetype to_chars(char* buffer, qsizetype size) const;
+        QString to_string() const;
+        bool valid() const;
+        void set_drop_frame(bool dropframe);
+        void set_color_frame(bool colorframe);
+        void set_userbits(quint32 userbits);
+        void set_bits(quint64 bits);
+
+        constexpr AVSmpteWord& operator=(const AVSmpteWord& other) = default;
+        constexpr bool operator==(const AVSmpteWord& other) const { return d.bits == other.d.bits; }
+        constexpr bool operator!=(const AVSmpteWord& other) const { return d.bits != other.d.bits; }
+        constexpr bool operator<(const AVSmpteWord& other) const {
+            return key() != other.key() ? key() < other.key() : d.bits < other.d.bits;
+        }
+        constexpr bool operator>(const AVSmpteWord& other) const { return other < *this; }
+        constexpr bool operator<=(const AVSmpteWord& other) const { return !(other < *this); }
+        constexpr bool operator>=(const AVSmpteWord& other) const { return !(*this < other); }
+
+        // ST 12-1 bit layout, bit 0 is the first bit sent in the LTC word
+        static constexpr quint64 time_mask = 0x030F070F070F030FULL; // bcd digits, hours in the top bits
+        static constexpr quint64 userbits_mask = 0xF0F0F0F0F0F0F0F0ULL; // eight 4-bit binary groups
+        static constexpr quint64 dropframe_bit = 1ULL << 10;
+        static constexpr quint64 colorframe_bit = 1ULL << 11;
+
+    private:
+        constexpr qint16 digits(int shift, int tens) const {
+            return static_cast<qint16>(((d.bits >> shift) & 0xf) + ((d.bits >> (shift + 8)) & ((1 << tens) - 1)) * 10);
+        }
+        struct Data
+        {
+            quint64 bits = 0;
+        };
+        Data d;
+};
+
+inline size_t qHash(const AVSmpteWord& word, size_t seed = 0)
+{
+    return qHash(word.bits(), seed);
+}
 
 class AVSmpteTimePrivate;
 class AVSmpteTime {
     public:
         AVSmpteTime();
         AVSmpteTime(const AVTime& time);
+        AVSmpteTime(const AVSmpteWord& word, const AVFps& fps);
         AVSmpteTime(const AVSmpteTime& other);
         ~AVSmpteTime();
-        quint32 counter() const;
         qint16 hours() const;
         qint16 minutes() const;
         qint16 seconds() const;
         qint16 frames() const;
-        qint16 subframes() const;
-        qint16 subframe_divisor() const;
         qint64 frame() const;
         AVTime time() const;
+        AVSmpteWord word() const;
         bool negatives() const;
         bool fullhours() const;
         QString to_string() const;
+        qsizetype to_chars(char* buffer, qsizetype size) const;
         void invalidate();
         bool valid() const;
         void set_time(const AVTime& time);
+        void advance(qint64 frames);
         void set_negatives(bool negatives);
         void set_fullhours(bool fullhours);
     
         AVSmpteTime& operator=(const AVSmpteTime& other);
         bool operator==(const AVSmpteTime& other) const;
         bool operator!=(const AVSmpteTime& other) const;
+        AVSmpteTime& operator++();
+        AVSmpteTime& operator--();
+        AVSmpteTime& operator+=(qint64 frames);
+        AVSmpteTime& operator-=(qint64 frames);
         bool operator<(const AVSmpteTime& other) const;
         bool operator>(const AVSmpteTime& other) const;
         bool operator<=(const AVSmpteTime& other) const;
@@ -45,6 +115,11 @@ class AVSmpteTime {
     
         static qint64 convert(quint64 frame, const AVFps& from, const AVFps& to);
         static qint64 convert(quint64 frame, const AVFps& fps, bool reverse = false);
+        static qsizetype to_chars(const AVTime& time, char* buffer, qsizetype size);
+        static bool parse(QByteArrayView text, const AVFps& fps, qint64& frame);
+        static qsizetype parse(QSpan<const QByteArrayView> texts, const AVFps& fps, QSpan<qint64> frames);
+    
+        static constexpr qsizetype max_chars = 24;
                                    
     private:
         QExplicitlySharedDataPointer<AVSmpteTimePrivate> p;
@@ -2,25 +2,42 @@
 // Copyright (c) 2022 - present Mikael Sundell.
 
 #include "avtime.h"
+#include "avmath.h"
+#include "avrate.h"
 
 #include <QDebug>
 
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<AVTime>, "time must stay a flat value type");
+
 class AVTimePrivate
 {
     public:
-        qreal tpf() {
-            return static_cast<qreal>(d.timescale) / d.fps.real();
-        };
-        qint64 ticks(qint64 frame) {
-            return static_cast<qint64>(std::round(frame * tpf()));
+        static qint64 ticks(qint64 frame, qint32 timescale, const AVFps& fps) {
+            Q_ASSERT("fps is not valid" && fps.valid());
+            qint64 ticks = 0;
+            if (AVRates::dispatch(fps, timescale, [&](auto rate, auto constant) {
+                ticks = decltype(rate)::template ticks<decltype(constant)::value>(frame);
+            })) {
+                return ticks;
+            }
+            return AVMath::muldiv(frame, static_cast<qint64>(timescale) * fps.denominator(), fps.numerator());
         }
-        qint64 frame(qint64 ticks) {
-            return static_cast<qint64>(std::round(ticks / tpf()));
+        static qint64 frame(qint64 ticks, qint32 timescale, const AVFps& fps) {
+            Q_ASSERT("fps is not valid" && fps.valid());
+            qint64 frame = 0;
+            if (AVRates::dispatch(fps, timescale, [&](auto rate, auto constant) {
+                frame = decltype(rate)::template frame<decltype(constant)::value>(ticks);
+            })) {
+                return frame;
+            }
+            return AVMath::muldiv(ticks, fps.numerator(), static_cast<qint64>(timescale) * fps.denominator());
         }
-        qint64 frames() {
-            return static_cast<qint64>(std::round(d.ticks / tpf()));
+        static int compare(const AVTime& time, const AVTime& other) {
+            return AVMath::compare(time.ticks(), time.timescale(), other.ticks(), other.timescale());
         }
-        QString to_string(qreal seconds) {
+        static QString to_string(qreal seconds) {
             qint64 secs = qFloor(seconds); // complete seconds
             qint64 minutes = secs / 60;
             qint64 hours = minutes / 60;
@@ -37,191 +54,92 @@ class AVTimePrivate
                     .arg(secs, 2, 10, QChar('0'));
             }
         }
-        struct Data
-        {
-            AVFps fps = AVFps::fps_24();
-            qint64 ticks = 0;
-            qint32 timescale = 24000; // default timescale
-        };
-        Data d;
-        QAtomicInt ref;
 };
 
-AVTime::AVTime()
-: p(new AVTimePrivate())
-{
-}
-
-AVTime::AVTime(qint64 ticks, qint32 timescale, const AVFps& fps)
-: p(new AVTimePrivate())
-{
-    p->d.ticks = ticks;
-    p->d.timescale = timescale;
-    p->d.fps = fps;
-}
-
 AVTime::AVTime(qint64 frame, const AVFps& fps)
-: p(new AVTimePrivate())
 {
-    p->d.fps = fps;
-    p->d.ticks = ticks(frame);
+    d.fps = fps;
+    d.ticks = ticks(frame);
 }
 
 AVTime::AVTime(qreal seconds, const AVFps& fps)
-: p(new AVTimePrivate())
-{
-    p->d.fps = fps;
-    p->d.ticks = p->d.timescale * seconds;
-}
-
-AVTime::AVTime(const AVTime& other, qint64 ticks)
-: p(other.p)
-{
-    set_ticks(ticks);
-}
-
-AVTime::AVTime(const AVTime& other, const AVFps& fps)
-: p(other.p)
-{
-    set_fps(fps);
-}
-
-AVTime::AVTime(const AVTime& other)
-: p(other.p)
-{
-}
-
-AVTime::~AVTime()
 {
-}
-
-AVFps
-AVTime::fps() const
-{
-    return p->d.fps;
-}
-
-qint64
-AVTime::ticks() const
-{
-    return p->d.ticks;
+    d.fps = fps;
+    d.ticks = d.timescale * seconds;
 }
 
 qint64
 AVTime::ticks(qint64 frame) const
 {
-    return p->ticks(frame);
-}
-
-qint32
-AVTime::timescale() const
-{
-    return p->d.timescale;
+    return AVTimePrivate::ticks(frame, d.timescale, d.fps);
 }
 
 qint64
 AVTime::tpf() const
 {
-    return static_cast<qint64>(std::round(p->tpf()));
+    return AVTimePrivate::ticks(1, d.timescale, d.fps);
 }
 
 qint64
 AVTime::frame(qint64 ticks) const
 {
-    return p->frame(ticks);
+    return AVTimePrivate::frame(ticks, d.timescale, d.fps);
 }
 
 qint64
 AVTime::frames() const
 {
-    return p->frames();
+    return frame(d.ticks);
 }
 
 qint64
 AVTime::align(qint64 ticks) const
 {
-    return this->ticks(p->frame(ticks));
+    return this->ticks(frame(ticks));
 }
 
 qreal
 AVTime::seconds() const
 {
-    return static_cast<qreal>(p->d.ticks) / p->d.timescale;
+    return static_cast<qreal>(d.ticks) / d.timescale;
 }
 
 QString
 AVTime::to_string(qint64 ticks) const
 {
-    return p->to_string(static_cast<qreal>(ticks) / p->d.timescale);
+    return AVTimePrivate::to_string(static_cast<qreal>(ticks) / d.timescale);
 }
 
 QString
 AVTime::to_string() const
 {
-    return p->to_string(seconds());
-}
-
-void
-AVTime::invalidate() {
-    if (p->ref.loadRelaxed() > 1) {
-        p.detach();
-    }
-    p->d.ticks = 0;
-    p->d.timescale = 0;
-    p->d.fps = AVFps();
-}
-
-bool
-AVTime::valid() const {
-    return p->d.timescale > 0;
-}
-
-void
-AVTime::set_ticks(qint64 ticks)
-{
-    if (p->d.ticks != ticks) {
-        if (p->ref.loadRelaxed() > 1) {
-            p.detach();
-        }
-        p->d.ticks = ticks;
-    }
+    return AVTimePrivate::to_string(seconds());
 }
 
-void
-AVTime::set_timescale(qint32 timescale)
+AVTime
+AVTime::normalized() const
 {
-    if (p->d.timescale != timescale) {
-        if (p->ref.loadRelaxed() > 1) {
-            p.detach();
-        }
-        p->d.timescale = timescale;
+    if (!valid()) {
+        return *this;
     }
+    qint64 divisor = AVMath::gcd(d.ticks, d.timescale);
+    return AVTime(d.ticks / divisor, static_cast<qint32>(d.timescale / divisor), d.fps);
 }
 
 void
-AVTime::set_fps(const AVFps& fps)
-{
-    if (p->d.fps != fps) {
-        if (p->ref.loadRelaxed() > 1) {
-            p.detach();
-        }
-        p->d.fps = fps;
-    }
-}
-
-AVTime&
-AVTime::operator=(const AVTime& other)
-{
-    if (this != &other) {
-        p = other.p;
-    }
-    return *this;
+AVTime::invalidate() {
+    d.ticks = 0;
+    d.timescale = 0;
+    d.fps = AVFps();
 }
 
 bool
 AVTime::operator==(const AVTime& other) const
 {
-    return p->d.ticks == other.p->d.ticks && p->d.timescale == other.p->d.timescale && p->d.fps == other.p->d.fps;
+    if (!valid() || !other.valid()) {
+        return d.ticks == other.d.ticks && d.timescale == other.d.timescale && d.fps == other.d.fps;
+    }
+    return d.fps == other.d.fps && AVTimePrivate::compare(*this, other) == 0;
 }
 
 bool
@@ -231,34 +149,34 @@ AVTime::operator!=(const AVTime& other) const {
 
 bool
 AVTime::operator<(const AVTime& other) const {
-    return seconds() < other.seconds();
+    return AVTimePrivate::compare(*this, other) < 0;
 }
 
 bool
 AVTime::operator>(const AVTime& other) const {
-    return seconds() > other.seconds();
+    return AVTimePrivate::compare(*this, other) > 0;
 }
 
 bool
 AVTime::operator<=(const AVTime& other) const {
-    return seconds() <= other.seconds();
+    return AVTimePrivate::compare(*this, other) <= 0;
 }
 
 bool
 AVTime::operator>=(const AVTime& other) const {
-    return seconds() >= other.seconds();
+    return AVTimePrivate::compare(*this, other) >= 0;
 }
 
 AVTime
 AVTime::operator+(const AVTime& other) const {
-    Q_ASSERT("timescale does not match" && p->d.timescale == other.p->d.timescale);
-    return AVTime(p->d.ticks + other.p->d.ticks, p->d.timescale, p->d.fps);
+    Q_ASSERT("timescale does not match" && d.timescale == other.d.timescale);
+    return AVTime(d.ticks + other.d.ticks, d.timescale, d.fps);
 }
 
 AVTime
 AVTime::operator-(const AVTime& other) const {
-    Q_ASSERT("timescale does not match" && p->d.timescale == other.p->d.timescale);
-    return AVTime(p->d.ticks - other.p->d.ticks, p->d.timescale, p->d.fps);
+    Q_ASSERT("timescale does not match" && d.timescale == other.d.timescale);
+    return AVTime(d.ticks - other.d.ticks, d.timescale, d.fps);
 }
 
 AVTime
@@ -270,16 +188,12 @@ AVTime::convert(const AVTime& time, const AVFps& to)
 AVTime
 AVTime::convert(const AVTime& time, qint32 timescale)
 {
-    qint64 numerator = time.ticks() * timescale;
-    qint64 remainder = numerator % time.timescale();
-    qint64 ticks = numerator / time.timescale();
-    if (remainder >= (time.timescale() / 2)) {
-        if (time.ticks() > 0) {
-            ticks += 1;
-        } else if (time.ticks() < 0) {
-            ticks -= 1;
-        }
-    }
-    return AVTime(ticks, timescale, time.fps());
+    return AVTime(AVMath::muldiv(time.ticks(), timescale, time.timescale()), timescale, time.fps());
 }
 
+size_t
+qHash(const AVTime& time, size_t seed)
+{
+    AVTime key = time.normalized();
+    return qHashMulti(seed, key.ticks(), key.timescale(), key.fps().numerator(), key.fps().denominator(), key.fps().drop_frame());
+}
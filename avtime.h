@@ -5,39 +5,48 @@
 
 #include "avfps.h"
 
-#include <QExplicitlySharedDataPointer>
+#include <QHashFunctions>
 
-class AVTimePrivate;
 class AVTime
 {
     public:
-        AVTime();
-        AVTime(qint64 ticks, qint32 timescale, const AVFps& fps);
+        constexpr AVTime() = default;
+        constexpr AVTime(qint64 ticks, qint32 timescale, const AVFps& fps)
+        : d { ticks, timescale, fps }
+        {
+        }
         AVTime(qint64 frame, const AVFps& fps);
         AVTime(qreal seconds, const AVFps& fps);
-        AVTime(const AVTime& other, qint64 ticks);
-        AVTime(const AVTime& other, const AVFps& fps);
-        AVTime(const AVTime& other);
-        ~AVTime();
-        AVFps fps() const;
-        qint64 ticks() const;
+        constexpr AVTime(const AVTime& other, qint64 ticks)
+        : d { ticks, other.d.timescale, other.d.fps }
+        {
+        }
+        constexpr AVTime(const AVTime& other, const AVFps& fps)
+        : d { other.d.ticks, other.d.timescale, fps }
+        {
+        }
+        constexpr AVTime(const AVTime& other) = default;
+        ~AVTime() = default;
+        constexpr AVFps fps() const { return d.fps; }
+        constexpr qint64 ticks() const { return d.ticks; }
         qint64 ticks(qint64 frame) const;
-        qint32 timescale() const;
+        constexpr qint32 timescale() const { return d.timescale; }
         qint64 tpf() const;
         qint64 frame(qint64 ticks) const;
         qint64 frames() const;
         qint64 align(qint64 ticks) const;
         qreal seconds() const;
+        AVTime normalized() const;
         QString to_string(qint64 ticks) const;
         QString to_string() const;
         void invalidate();
-        bool valid() const;
-    
-        void set_ticks(qint64 ticks);
-        void set_timescale(qint32 timescale);
-        void set_fps(const AVFps& fps);
-    
-        AVTime& operator=(const AVTime& other);
+        constexpr bool valid() const { return d.timescale > 0; }
+
+        constexpr void set_ticks(qint64 ticks) { d.ticks = ticks; }
+        constexpr void set_timescale(qint32 timescale) { d.timescale = timescale; }
+        constexpr void set_fps(const AVFps& fps) { d.fps = fps; }
+
+        constexpr AVTime& operator=(const AVTime& other) = default;
         bool operator==(const AVTime& other) const;
         bool operator!=(const AVTime& other) const;
         bool operator<(const AVTime& other) const;
@@ -46,10 +55,18 @@ class AVTime
         bool operator>=(const AVTime& other) const;
         AVTime operator+(const AVTime& other) const;
         AVTime operator-(const AVTime& other) const;
-    
+
         static AVTime convert(const AVTime& time, const AVFps& to);
         static AVTime convert(const AVTime& time, qint32 timescale = 24000);
 
     private:
-        QExplicitlySharedDataPointer<AVTimePrivate> p;
+        struct Data
+        {
+            qint64 ticks = 0;
+            qint32 timescale = 24000; // default timescale
+            AVFps fps = AVFps::fps_24();
+        };
+        Data d;
 };
+
+size_t qHash(const AVTime& time, size_t seed = 0);
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avtimebatch.h"
+#include "avmath.h"
+
+#if defined(Q_PROCESSOR_X86_64) && defined(__GNUC__)
+#  include <immintrin.h>
+#  define AVTIMEBATCH_AVX2
+#elif defined(Q_PROCESSOR_ARM_64)
+#  include <arm_neon.h>
+#  define AVTIMEBATCH_NEON
+#endif
+
+class AVTimeBatchPrivate
+{
+    public:
+        typedef void (*Kernel)(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator);
+        struct Dispatch
+        {
+            Kernel kernel;
+            const char* name;
+        };
+        static void muldiv(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator);
+        static void muldiv_scalar(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator);
+#if defined(AVTIMEBATCH_AVX2)
+        static void muldiv_avx2(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator);
+#endif
+#if defined(AVTIMEBATCH_NEON)
+        static void muldiv_neon(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator);
+#endif
+        static const Dispatch& dispatch();
+        // the vector kernels compute in doubles, exact while |value * numerator| < 2^51, see muldiv_avx2
+        static constexpr qint64 exact = qint64(1) << 51;
+};
+
+void
+AVTimeBatchPrivate::muldiv(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator)
+{
+    Q_ASSERT("numerator and denominator must be positive" && numerator > 0 && denominator > 0);
+
+    qint64 divisor = AVMath::gcd(numerator, denominator);
+    numerator /= divisor;
+    denominator /= divisor;
+    if (denominator == 1) { // whole ticks per frame, plain multiply
+        for (qsizetype i = 0; i < count; i++) {
+            out[i] = in[i] * numerator;
+        }
+    }
+    else if (numerator < exact && denominator < exact) {
+        dispatch().kernel(in, out, count, numerator, denominator);
+    }
+    else {
+        muldiv_scalar(in, out, count, numerator, denominator);
+    }
+}
+
+void
+AVTimeBatchPrivate::muldiv_scalar(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator)
+{
+    for (qsizetype i = 0; i < count; i++) {
+        out[i] = AVMath::muldiv(in[i], numerator, denominator);
+    }
+}
+
+#if defined(AVTIMEBATCH_AVX2)
+// values are moved between int64 and double lanes by adding the 2^52 + 2^51 bit pattern, exact for |x| < 2^51.
+// value * numerator is then an exact double and the division is correctly rounded. A non-tie quotient is at
+// least 1 / (2 * denominator) from a half while the rounding error is below 1 / (4 * denominator), so
+// floor(|v| + 0.5) gives the same result as the 128-bit scalar path, ties included.
+__attribute__((target("avx2"))) void
+AVTimeBatchPrivate::muldiv_avx2(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator)
+{
+    const qint64 limit = exact / numerator;
+    const __m256i magic = _mm256_set1_epi64x(0x4338000000000000);
+    const __m256d magicd = _mm256_castsi256_pd(magic);
+    const __m256d n = _mm256_set1_pd(static_cast<double>(numerator));
+    const __m256d m = _mm256_set1_pd(static_cast<double>(denominator));
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256i upper = _mm256_set1_epi64x(limit);
+    const __m256i lower = _mm256_set1_epi64x(-limit);
+    qsizetype i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(x, upper), _mm256_cmpgt_epi64(lower, x));
+        if (!_mm256_testz_si256(outside, outside)) {
+            muldiv_scalar(in + i, out + i, 4, numerator, denominator);
+            continue;
+        }
+        __m256d value = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(x, magic)), magicd);
+        value = _mm256_div_pd(_mm256_mul_pd(value, n), m);
+        __m256d rounded = _mm256_floor_pd(_mm256_add_pd(_mm256_andnot_pd(sign, value), half));
+        rounded = _mm256_or_pd(rounded, _mm256_and_pd(value, sign));
+        __m256i y = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(rounded, magicd)), magic);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), y);
+    }
+    muldiv_scalar(in + i, out + i, count - i, numerator, denominator);
+}
+#endif
+
+#if defined(AVTIMEBATCH_NEON)
+// same exactness bounds as the avx2 kernel, vrndaq rounds half away from zero natively
+void
+AVTimeBatchPrivate::muldiv_neon(const qint64* in, qint64* out, qsizetype count, qint64 numerator, qint64 denominator)
+{
+    const int64x2_t upper = vdupq_n_s64(exact / numerator);
+    const int64x2_t lower = vdupq_n_s64(-(exact / numerator));
+    const float64x2_t n = vdupq_n_f64(static_cast<double>(numerator));
+    const float64x2_t m = vdupq_n_f64(static_cast<double>(denominator));
+    qsizetype i = 0;
+    for (; i + 2 <= count; i += 2) {
+        int64x2_t x = vld1q_s64(reinterpret_cast<const int64_t*>(in + i));
+        uint64x2_t outside = vorrq_u64(vcgtq_s64(x, upper), vcltq_s64(x, lower));
+        if (vgetq_lane_u64(outside, 0) | vgetq_lane_u64(outside, 1)) {
+            muldiv_scalar(in + i, out + i, 2, numerator, denominator);
+            continue;
+        }
+        float64x2_t value = vdivq_f64(vmulq_f64(vcvtq_f64_s64(x), n), m);
+        vst1q_s64(reinterpret_cast<int64_t*>(out + i), vcvtq_s64_f64(vrndaq_f64(value)));
+    }
+    muldiv_scalar(in + i, out + i, count - i, numerator, denominator);
+}
+#endif
+
+const AVTimeBatchPrivate::Dispatch&
+AVTimeBatchPrivate::dispatch()
+{
+    static const Dispatch dispatch = [] {
+#if defined(AVTIMEBATCH_AVX2)
+        if (__builtin_cpu_supports("avx2")) {
+            return Dispatch { muldiv_avx2, "avx2" };
+        }
+#elif defined(AVTIMEBATCH_NEON)
+        return Dispatch { muldiv_neon, "neon" };
+#endif
+        return Dispatch { muldiv_scalar, "scalar" };
+    }();
+    return dispatch;
+}
+
+void
+AVTimeBatch::ticks(const AVTime& time, QSpan<const qint64> frames, QSpan<qint64> ticks)
+{
+    Q_ASSERT("span sizes does not match" && frames.size() == ticks.size());
+    Q_ASSERT("fps is not valid" && time.fps().valid());
+
+    AVTimeBatchPrivate::muldiv(frames.data(), ticks.data(), frames.size(),
+                               static_cast<qint64>(time.timescale()) * time.fps().denominator(),
+                               time.fps().numerator());
+}
+
+void
+AVTimeBatch::frames(const AVTime& time, QSpan<const qint64> ticks, QSpan<qint64> frames)
+{
+    Q_ASSERT("span sizes does not match" && ticks.size() == frames.size());
+    Q_ASSERT("fps is not valid" && time.fps().valid());
+
+    AVTimeBatchPrivate::muldiv(ticks.data(), frames.data(), ticks.size(),
+                               time.fps().numerator(),
+                               static_cast<qint64>(time.timescale()) * time.fps().denominator());
+}
+
+void
+AVTimeBatch::align(const AVTime& time, QSpan<const qint64> ticks, QSpan<qint64> aligned)
+{
+    frames(time, ticks, aligned);
+    AVTimeBatch::ticks(time, aligned, aligned); // in place, kernels read each lane before writing it
+}
+
+void
+AVTimeBatch::bound(const AVTimeRange& range, QSpan<const qint64> ticks, QSpan<qint64> bounded, bool loop)
+{
+    Q_ASSERT("span sizes does not match" && ticks.size() == bounded.size());
+
+    qint64 tpf = range.start().tpf();
+    qint64 lower = range.start().ticks();
+    qint64 upper = range.end().ticks() - tpf;
+    const qint64* in = ticks.data();
+    qint64* out = bounded.data();
+    if (loop) {
+        qint64 span = upper - lower + tpf;
+        for (qsizetype i = 0; i < ticks.size(); i++) {
+            qint64 offset = in[i] - lower;
+            if (static_cast<quint64>(offset) < static_cast<quint64>(span)) { // already inside, skip modulo
+                out[i] = in[i];
+            }
+            else {
+                out[i] = lower + (offset % span + span) % span;
+            }
+        }
+    }
+    else {
+        for (qsizetype i = 0; i < ticks.size(); i++) {
+            out[i] = in[i] < lower ? lower : (in[i] > upper ? upper : in[i]);
+        }
+    }
+}
+
+QString
+AVTimeBatch::kernel()
+{
+    return QString(AVTimeBatchPrivate::dispatch().name);
+}
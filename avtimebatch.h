@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avtime.h"
+#include "avtimerange.h"
+
+#include <QSpan>
+
+class AVTimeBatch
+{
+    public:
+        static void ticks(const AVTime& time, QSpan<const qint64> frames, QSpan<qint64> ticks);
+        static void frames(const AVTime& time, QSpan<const qint64> ticks, QSpan<qint64> frames);
+        static void align(const AVTime& time, QSpan<const qint64> ticks, QSpan<qint64> aligned);
+        static void bound(const AVTimeRange& range, QSpan<const qint64> ticks, QSpan<qint64> bounded, bool loop = false);
+        static QString kernel();
+};
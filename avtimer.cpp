@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avtimer.h"
+#include "avclock.h"
+#include "avfps.h"
+#include "avhistogram.h"
+#include "avmath.h"
+
+#include <QMutex>
+#include <QtGlobal>
+
+#include <QDebug>
+
+class AVTimerPrivate
+{
+    public:
+        AVTimerPrivate();
+        ~AVTimerPrivate();
+        quint64 elapsed() {
+            quint64 end = d.stop > 0 ? d.stop : now();
+            return end - d.start;
+        }
+        quint64 now() const {
+            return d.clock->now();
+        }
+        qint64 schedule() const;
+        void reset(qint64 units, qint64 numerator, qint64 denominator);
+        void advance(qint64 units, qint64 numerator, qint64 denominator);
+        void track(qint64 period);
+        void wait_until(quint64 nanos);
+        struct Data
+        {
+            AVClock* clock = AVClock::system();
+            quint64 start = 0;
+            quint64 stop = 0;
+            quint64 origin = 0; // nanos when pacing started, deadlines are offsets from here
+            quint64 next = 0;
+            qint64 base = 0; // nanos to the first unit at the current rate
+            qint64 units = 0; // frames or ticks at the current rate
+            qint64 numerator = 0; // seconds per unit, 1001/24000 for 23.976
+            qint64 denominator = 1;
+            std::function<quint64()> reference; // nanos of the clock pacing is locked to
+            quint64 lockstart = 0;
+            quint64 referencestart = 0;
+            qint64 correction = 0; // nanos the reference is ahead of the local clock
+            qint64 phaseerror = 0;
+            qreal frequency = 0.0; // integral term, nanos per deadline
+            qreal slew = 0.0;
+            quint64 margin = 200000; // nanos before the deadline to stop sleeping in hybrid modes
+            qint64 wakeerror = 0;
+            AVHistogram histogram; // wake errors in nanos, never shared so recording never detaches
+            QMutex histogrammutex; // held to record and to copy a snapshot, never to allocate
+            AVTimer::Mode mode = AVTimer::SLEEP;
+            QList<quint64> laps;
+        };
+        Data d;
+};
+
+AVTimerPrivate::AVTimerPrivate()
+{
+    d.histogram.reserve(); // where the timer is created, not on the pacing thread
+}
+
+AVTimerPrivate::~AVTimerPrivate()
+{
+}
+
+qint64
+AVTimerPrivate::schedule() const
+{
+    // exact rational offset, start + units * numerator / denominator seconds never accumulates rounding
+    return d.base + AVMath::muldiv_floor(d.units, 1000000000 * d.numerator, d.denominator);
+}
+
+void
+AVTimerPrivate::reset(qint64 units, qint64 numerator, qint64 denominator)
+{
+    d.origin = now();
+    d.base = 0;
+    d.units = 0;
+    d.numerator = numerator;
+    d.denominator = denominator;
+    if (d.reference) {
+        d.lockstart = d.origin;
+        d.referencestart = d.reference();
+        d.correction = 0;
+        d.frequency = 0.0;
+    }
+    advance(units, numerator, denominator);
+}
+
+void
+AVTimerPrivate::advance(qint64 units, qint64 numerator, qint64 denominator)
+{
+    if (numerator != d.numerator || denominator != d.denominator) { // rate changed, continue from the last deadline
+        d.base = schedule();
+        d.units = 0;
+        d.numerator = numerator;
+        d.denominator = denominator;
+    }
+    qint64 previous = schedule();
+    d.units += units;
+    track(schedule() - previous);
+    d.next = d.origin + static_cast<quint64>(qMax(schedule() - d.correction, qint64(0)));
+}
+
+void
+AVTimerPrivate::track(qint64 period)
+{
+    if (!d.reference) {
+        return;
+    }
+    // phase locked loop, proportional and integral terms with the correction slewed by at most
+    // slew * period per deadline so playback never jumps
+    qint64 local = static_cast<qint64>(now() - d.lockstart);
+    qint64 remote = static_cast<qint64>(d.reference() - d.referencestart);
+    qint64 error = remote - local - d.correction;
+    qreal limit = d.slew * period;
+    d.frequency = qBound(-limit, d.frequency + error * 0.01, limit);
+    d.correction += static_cast<qint64>(qBound(-limit, error * 0.1 + d.frequency, limit));
+    d.phaseerror = error;
+}
+
+void
+AVTimerPrivate::wait_until(quint64 nanos)
+{
+    if (d.mode == AVTimer::SLEEP) {
+        d.clock->sleep_until(nanos);
+    }
+    else {
+        // sleep to just before the deadline, then spin or yield the remainder. scheduler wake latency
+        // lands inside the margin instead of after the deadline
+        if (nanos > d.margin && nanos - d.margin > now()) {
+            d.clock->sleep_until(nanos - d.margin);
+        }
+        d.clock->spin_until(nanos, d.mode == AVTimer::YIELD);
+    }
+    quint64 woken = now();
+    d.wakeerror = woken >= nanos ? static_cast<qint64>(woken - nanos) : -static_cast<qint64>(nanos - woken);
+    QMutexLocker locker(&d.histogrammutex);
+    d.histogram.record(static_cast<quint64>(qMax(d.wakeerror, qint64(0))));
+}
+
+AVTimer::AVTimer()
+: p(new AVTimerPrivate())
+{
+}
+
+AVTimer::~AVTimer()
+{
+}
+
+void
+AVTimer::start()
+{
+    p->d.start = p->now();
+    p->d.stop = 0;
+}
+
+void
+AVTimer::start(const AVFps& fps)
+{
+    Q_ASSERT("fps is zero" && fps.seconds() > 0);
+
+    p->reset(1, fps.denominator(), fps.numerator());
+    p->d.stop = 0;
+}
+
+void
+AVTimer::start(quint64 nanos)
+{
+    p->reset(nanos, 1, 1000000000);
+    p->d.stop = 0;
+}
+
+void
+AVTimer::start(qint64 ticks, qint32 timescale)
+{
+    Q_ASSERT("timescale is zero" && timescale > 0);
+
+    p->reset(ticks, 1, timescale);
+    p->d.stop = 0;
+}
+
+void
+AVTimer::stop()
+{
+    p->d.stop = p->now();
+    p->d.next = p->d.stop;
+}
+
+void
+AVTimer::restart()
+{
+    p->d.laps.clear();
+    start();
+}
+
+void
+AVTimer::lap()
+{
+    if (!p->d.laps.isEmpty()) {
+        p->d.laps.append(elapsed() - p->d.laps.last());
+    }
+    else {
+        p->d.laps.append(elapsed());
+    }
+}
+
+bool
+AVTimer::next(const AVFps& fps)
+{
+    quint64 currenttime = p->now();
+    p->advance(1, fps.denominator(), fps.numerator());
+    return p->d.next > currenttime;
+}
+
+bool
+AVTimer::next(quint64 nanos)
+{
+    quint64 currenttime = p->now();
+    p->advance(nanos, 1, 1000000000);
+    return p->d.next > currenttime;
+}
+
+bool
+AVTimer::next(qint64 ticks, qint32 timescale)
+{
+    quint64 currenttime = p->now();
+    p->advance(ticks, 1, timescale);
+    return p->d.next > currenttime;
+}
+
+void
+AVTimer::wait()
+{
+    Q_ASSERT("start time must be less than nexttime" && p->d.start < p->d.next);
+
+    p->wait_until(p->d.next);
+}
+
+void
+AVTimer::sleep(quint64 msecs)
+{
+    quint64 sleeptime = msecs * 1000000;
+    quint64 currenttime = p->now();
+    quint64 targettime = currenttime + sleeptime;
+
+    Q_ASSERT("sleep time already passed" && currenttime < targettime);
+    p->wait_until(targettime);
+}
+
+quint64
+AVTimer::elapsed() const
+{
+    return p->elapsed();
+}
+
+QList<quint64>
+AVTimer::laps() const
+{
+    return p->d.laps;
+}
+
+AVTimer::Mode
+AVTimer::mode() const
+{
+    return p->d.mode;
+}
+
+quint64
+AVTimer::margin() const
+{
+    return p->d.margin;
+}
+
+qint64
+AVTimer::wake_error() const
+{
+    return p->d.wakeerror;
+}
+
+qint64
+AVTimer::deadline() const
+{
+    return static_cast<qint64>(p->d.next - p->d.origin);
+}
+
+bool
+AVTimer::is_locked() const
+{
+    return static_cast<bool>(p->d.reference);
+}
+
+qint64
+AVTimer::phase_error() const
+{
+    return p->d.phaseerror;
+}
+
+AVHistogram
+AVTimer::histogram() const
+{
+    AVHistogram snapshot; // a deep copy, buckets are allocated here on the calling thread
+    snapshot.reserve();
+    QMutexLocker locker(&p->d.histogrammutex);
+    snapshot.merge(p->d.histogram);
+    return snapshot;
+}
+
+AVClock*
+AVTimer::clock() const
+{
+    return p->d.clock;
+}
+
+void
+AVTimer::set_clock(AVClock* clock)
+{
+    p->d.clock = clock ? clock : AVClock::system();
+}
+
+void
+AVTimer::reset_histogram()
+{
+    QMutexLocker locker(&p->d.histogrammutex);
+    p->d.histogram.reset();
+}
+
+void
+AVTimer::set_mode(Mode mode)
+{
+    p->d.mode = mode;
+}
+
+void
+AVTimer::set_margin(quint64 nanos)
+{
+    p->d.margin = nanos;
+}
+
+void
+AVTimer::lock(const AVTimer& reference, qreal slew)
+{
+    const AVTimer* timer = &reference;
+    lock([timer]() { return timer->elapsed(); }, slew);
+}
+
+void
+AVTimer::lock(std::function<quint64()> reference, qreal slew)
+{
+    p->d.reference = reference;
+    p->d.slew = slew;
+    p->d.lockstart = p->now();
+    p->d.referencestart = reference();
+    p->d.correction = 0;
+    p->d.frequency = 0.0;
+    p->d.phaseerror = 0;
+}
+
+void
+AVTimer::unlock()
+{
+    p->d.reference = nullptr;
+    p->d.correction = 0;
+    p->d.frequency = 0.0;
+    p->d.phaseerror = 0;
+}
+
+qreal
+AVTimer::convert(quint64 nano, Unit unit)
+{
+    switch (unit) {
+    case Unit::SECONDS:
+        return static_cast<qreal>(nano) / 1e9;
+        break;
+    case Unit::MINUTES:
+        return static_cast<qreal>(nano) / (60 * 1e9);
+        break;
+    case Unit::HOURS:
+        return static_cast<qreal>(nano) / (3600 * 1e9);
+        break;
+    default:
+        return static_cast<qreal>(nano);
+    }
+}
+
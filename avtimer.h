@@ -4,29 +4,54 @@
 #pragma once
 
 #include "avfps.h"
+#include "avhistogram.h"
 
 #include <QObject>
 #include <QScopedPointer>
 
+#include <functional>
+
+class AVClock;
 class AVTimerPrivate;
 class AVTimer : public QObject {
     Q_OBJECT
     public:
         enum Unit { NANOS, SECONDS, MINUTES, HOURS };
         Q_ENUM(Unit)
+        enum Mode { SLEEP, SPIN, YIELD }; // sleep to the deadline, or sleep to a margin before it and spin or yield
+        Q_ENUM(Mode)
     public:
         AVTimer();
         virtual ~AVTimer();
         void start();
         void start(const AVFps& fps);
+        void start(quint64 nanos);
+        void start(qint64 ticks, qint32 timescale);
         void stop();
         void restart();
         void lap();
         bool next(const AVFps& fps);
+        bool next(quint64 nanos);
+        bool next(qint64 ticks, qint32 timescale);
         void wait();
         void sleep(quint64 msecs);
         quint64 elapsed() const;
         QList<quint64> laps() const;
+        AVTimer::Mode mode() const;
+        quint64 margin() const;
+        qint64 wake_error() const;
+        qint64 deadline() const;
+        bool is_locked() const;
+        qint64 phase_error() const;
+        AVHistogram histogram() const; // wake errors of every wait and sleep, a snapshot safe from any thread
+        AVClock* clock() const;
+        void set_clock(AVClock* clock); // not owned, nullptr for the system clock
+        void reset_histogram();
+        void set_mode(Mode mode);
+        void set_margin(quint64 nanos);
+        void lock(const AVTimer& reference, qreal slew = 0.0005);
+        void lock(std::function<quint64()> reference, qreal slew = 0.0005);
+        void unlock();
     
         static qreal convert(quint64 nano, Unit unit = Unit::NANOS);
 
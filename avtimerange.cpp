@@ -5,57 +5,22 @@
 
 #include <QtGlobal>
 
-class AVTimeRangePrivate
-{
-    public:
-        struct Data
-        {
-            AVTime start;
-            AVTime duration;
-        };
-        Data d;
-        QAtomicInt ref;
-};
+#include <type_traits>
 
-AVTimeRange::AVTimeRange()
-: p(new AVTimeRangePrivate())
-{
-}
+static_assert(std::is_trivially_copyable_v<AVTimeRange>, "time range must stay a flat value type");
 
 AVTimeRange::AVTimeRange(AVTime start, AVTime duration)
-: p(new AVTimeRangePrivate())
 {
     Q_ASSERT(start.timescale() == duration.timescale());
     
-    p->d.start = start;
-    p->d.duration = duration;
-}
-
-AVTimeRange::AVTimeRange(const AVTimeRange& other)
-: p(other.p)
-{
-}
-
-AVTimeRange::~AVTimeRange()
-{
-}
-
-AVTime
-AVTimeRange::start() const
-{
-    return p->d.start;
-}
-
-AVTime
-AVTimeRange::duration() const
-{
-    return p->d.duration;
+    d.start = start;
+    d.duration = duration;
 }
 
 AVTime
 AVTimeRange::end() const
 {
-    return p->d.start + p->d.duration;
+    return d.start + d.duration;
 }
 
 AVTime
@@ -84,55 +49,25 @@ AVTimeRange::bound(const AVTime& time, bool loop)
 QString
 AVTimeRange::to_string() const
 {
-    return QString("%1 / %2").arg(p->d.start.to_string()).arg(p->d.duration.to_string());
+    return QString("%1 / %2").arg(d.start.to_string()).arg(d.duration.to_string());
 }
 
 void
 AVTimeRange::invalidate()
 {
-    if (p->ref.loadRelaxed() > 1) {
-        p.detach();
-    }
-    p->d.start.invalidate();
-    p->d.duration.invalidate();
+    d.start.invalidate();
+    d.duration.invalidate();
 }
 
 bool
 AVTimeRange::valid() const {
-    return p->d.start.valid() && p->d.duration.valid() && p->d.duration.ticks() > 0;
-}
-
-void
-AVTimeRange::set_start(AVTime start)
-{
-    if (p->ref.loadRelaxed() > 1) {
-        p.detach();
-    }
-    p->d.start = start;
-}
-
-void
-AVTimeRange::set_duration(AVTime duration)
-{
-    if (p->ref.loadRelaxed() > 1) {
-        p.detach();
-    }
-    p->d.duration = duration;
-}
-
-AVTimeRange&
-AVTimeRange::operator=(const AVTimeRange& other)
-{
-    if (this != &other) {
-        p = other.p;
-    }
-    return *this;
+    return d.start.valid() && d.duration.valid() && d.duration.ticks() > 0;
 }
 
 bool
 AVTimeRange::operator==(const AVTimeRange& other) const
 {
-    return p->d.start == other.p->d.start && p->d.duration == other.p->d.duration;
+    return d.start == other.d.start && d.duration == other.d.duration;
 }
 
 bool
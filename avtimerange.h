@@ -5,34 +5,36 @@
 
 #include "avtime.h"
 
-#include <QExplicitlySharedDataPointer>
-
-class AVTimeRangePrivate;
 class AVTimeRange
 {
     public:
-        AVTimeRange();
+        constexpr AVTimeRange() = default;
         AVTimeRange(AVTime start, AVTime duration);
-        AVTimeRange(const AVTimeRange& other);
-        ~AVTimeRange();
-        AVTime start() const;
-        AVTime duration() const;
+        constexpr AVTimeRange(const AVTimeRange& other) = default;
+        ~AVTimeRange() = default;
+        constexpr AVTime start() const { return d.start; }
+        constexpr AVTime duration() const { return d.duration; }
         AVTime end() const;
         AVTime bound(const AVTime& time);
         AVTime bound(const AVTime& time, bool loop = false);
         QString to_string() const;
         void invalidate();
         bool valid() const;
-        void set_start(AVTime start);
-        void set_duration(AVTime duration);
+        constexpr void set_start(AVTime start) { d.start = start; }
+        constexpr void set_duration(AVTime duration) { d.duration = duration; }
 
-        AVTimeRange& operator=(const AVTimeRange& other);
+        constexpr AVTimeRange& operator=(const AVTimeRange& other) = default;
         bool operator==(const AVTimeRange& other) const;
         bool operator!=(const AVTimeRange& other) const;
-    
+
         static AVTimeRange convert(const AVTimeRange& timerange, const AVFps& to);
         static AVTimeRange convert(const AVTimeRange& timerange, qint32 timescale = 24000);
-    
+
     private:
-        QExplicitlySharedDataPointer<AVTimeRangePrivate> p;
+        struct Data
+        {
+            AVTime start;
+            AVTime duration;
+        };
+        Data d;
 };
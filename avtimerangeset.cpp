@@ -0,0 +1,681 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avtimerangeset.h"
+#include "avmath.h"
+
+#include <algorithm>
+
+struct AVTimeSpan
+{
+    qint64 start = 0;
+    qint64 end = 0; // exclusive
+};
+
+class AVTimeRangeSetPrivate
+{
+    public:
+        AVTimeRangeSetPrivate();
+        AVTimeRangeSetPrivate(const AVTimeRangeSetPrivate& other);
+        qsizetype find(qint64 ticks) const;
+        AVTimeSpan span(const AVTimeRange& range) const;
+        AVTimeRange range(const AVTimeSpan& span) const;
+        QList<AVTimeSpan> spans(const AVTimeRangeSetPrivate& other) const;
+        void adopt(const AVTime& time);
+        static qint64 floor(const AVTime& time, qint32 timescale);
+        static qint64 ceil(const AVTime& time, qint32 timescale);
+        static QList<AVTimeSpan> unite(const QList<AVTimeSpan>& a, const QList<AVTimeSpan>& b);
+        static QList<AVTimeSpan> intersect(const QList<AVTimeSpan>& a, const QList<AVTimeSpan>& b);
+        static QList<AVTimeSpan> subtract(const QList<AVTimeSpan>& a, const QList<AVTimeSpan>& b);
+        struct Data
+        {
+            QList<AVTimeSpan> spans; // sorted, disjoint and never adjacent
+            AVTime time = AVTime(0, 0, AVFps()); // timescale and fps of the set, set by the first range
+        };
+        Data d;
+        QAtomicInt ref;
+};
+
+AVTimeRangeSetPrivate::AVTimeRangeSetPrivate()
+{
+}
+
+AVTimeRangeSetPrivate::AVTimeRangeSetPrivate(const AVTimeRangeSetPrivate& other)
+: d(other.d) // detached copies start with a fresh ref count
+{
+}
+
+qsizetype
+AVTimeRangeSetPrivate::find(qint64 ticks) const
+{
+    auto it = std::upper_bound(d.spans.begin(), d.spans.end(), ticks, [](qint64 ticks, const AVTimeSpan& span) {
+        return ticks < span.end;
+    });
+    return it - d.spans.begin(); // first span ending after ticks
+}
+
+AVTimeSpan
+AVTimeRangeSetPrivate::span(const AVTimeRange& range) const
+{
+    qint32 timescale = d.time.timescale();
+    if (range.start().timescale() == timescale) {
+        return AVTimeSpan { range.start().ticks(), range.end().ticks() };
+    }
+    return AVTimeSpan { floor(range.start(), timescale), ceil(range.end(), timescale) }; // covers the range, like queries
+}
+
+AVTimeRange
+AVTimeRangeSetPrivate::range(const AVTimeSpan& span) const
+{
+    return AVTimeRange(AVTime(d.time, span.start), AVTime(d.time, span.end - span.start));
+}
+
+QList<AVTimeSpan>
+AVTimeRangeSetPrivate::spans(const AVTimeRangeSetPrivate& other) const
+{
+    if (other.d.time.timescale() == d.time.timescale()) {
+        return other.d.spans;
+    }
+    QList<AVTimeSpan> spans;
+    for (const AVTimeSpan& span : other.d.spans) {
+        spans.append(this->span(other.range(span)));
+    }
+    return unite(spans, QList<AVTimeSpan>()); // widening may join neighbours
+}
+
+void
+AVTimeRangeSetPrivate::adopt(const AVTime& time)
+{
+    if (!d.time.valid()) {
+        d.time = AVTime(time, qint64(0));
+    }
+}
+
+qint64
+AVTimeRangeSetPrivate::floor(const AVTime& time, qint32 timescale)
+{
+    if (time.timescale() == timescale) {
+        return time.ticks();
+    }
+    return AVMath::muldiv_floor(time.ticks(), timescale, time.timescale());
+}
+
+qint64
+AVTimeRangeSetPrivate::ceil(const AVTime& time, qint32 timescale)
+{
+    if (time.timescale() == timescale) {
+        return time.ticks();
+    }
+    return -AVMath::muldiv_floor(-time.ticks(), timescale, time.timescale());
+}
+
+QList<AVTimeSpan>
+AVTimeRangeSetPrivate::unite(const QList<AVTimeSpan>& a, const QList<AVTimeSpan>& b)
+{
+    QList<AVTimeSpan> spans;
+    spans.reserve(a.size() + b.size());
+    qsizetype i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        const AVTimeSpan& next = (j >= b.size() || (i < a.size() && a[i].start <= b[j].start)) ? a[i++] : b[j++];
+        if (next.end <= next.start) {
+            continue;
+        }
+        if (!spans.isEmpty() && next.start <= spans.last().end) {
+            spans.last().end = qMax(spans.last().end, next.end);
+        }
+        else {
+            spans.append(next);
+        }
+    }
+    return spans;
+}
+
+QList<AVTimeSpan>
+AVTimeRangeSetPrivate::intersect(const QList<AVTimeSpan>& a, const QList<AVTimeSpan>& b)
+{
+    QList<AVTimeSpan> spans;
+    qsizetype i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        qint64 start = qMax(a[i].start, b[j].start);
+        qint64 end = qMin(a[i].end, b[j].end);
+        if (start < end) {
+            spans.append(AVTimeSpan { start, end });
+        }
+        if (a[i].end < b[j].end) {
+            i++;
+        }
+        else {
+            j++;
+        }
+    }
+    return spans;
+}
+
+QList<AVTimeSpan>
+AVTimeRangeSetPrivate::subtract(const QList<AVTimeSpan>& a, const QList<AVTimeSpan>& b)
+{
+    QList<AVTimeSpan> spans;
+    qsizetype j = 0;
+    for (const AVTimeSpan& span : a) {
+        qint64 start = span.start;
+        while (j < b.size() && b[j].end <= start) {
+            j++;
+        }
+        qsizetype k = j;
+        while (k < b.size() && b[k].start < span.end) {
+            if (b[k].start > start) {
+                spans.append(AVTimeSpan { start, b[k].start });
+            }
+            start = qMax(start, b[k].end);
+            k++;
+        }
+        if (start < span.end) {
+            spans.append(AVTimeSpan { start, span.end });
+        }
+    }
+    return spans;
+}
+
+AVTimeRangeSet::AVTimeRangeSet()
+: p(new AVTimeRangeSetPrivate())
+{
+}
+
+AVTimeRangeSet::AVTimeRangeSet(const AVTimeRange& range)
+: p(new AVTimeRangeSetPrivate())
+{
+    insert(range);
+}
+
+AVTimeRangeSet::AVTimeRangeSet(const AVTimeRangeSet& other)
+: p(other.p)
+{
+}
+
+AVTimeRangeSet::~AVTimeRangeSet()
+{
+}
+
+qsizetype
+AVTimeRangeSet::size() const
+{
+    return p->d.spans.size();
+}
+
+AVTimeRange
+AVTimeRangeSet::range(qsizetype index) const
+{
+    Q_ASSERT("index is out of range" && index >= 0 && index < size());
+    return p->range(p->d.spans[index]);
+}
+
+QList<AVTimeRange>
+AVTimeRangeSet::ranges() const
+{
+    QList<AVTimeRange> ranges;
+    ranges.reserve(size());
+    for (const AVTimeSpan& span : p->d.spans) {
+        ranges.append(p->range(span));
+    }
+    return ranges;
+}
+
+AVTimeRange
+AVTimeRangeSet::bounds() const
+{
+    if (is_empty()) {
+        return AVTimeRange();
+    }
+    return p->range(AVTimeSpan { p->d.spans.first().start, p->d.spans.last().end });
+}
+
+AVTime
+AVTimeRangeSet::duration() const
+{
+    qint64 ticks = 0;
+    for (const AVTimeSpan& span : p->d.spans) {
+        ticks += span.end - span.start;
+    }
+    return AVTime(p->d.time, ticks);
+}
+
+AVTime
+AVTimeRangeSet::next_gap(const AVTime& time) const
+{
+    if (is_empty()) {
+        return time;
+    }
+    qsizetype index = p->find(AVTimeRangeSetPrivate::floor(time, p->d.time.timescale()));
+    if (index < size() && p->d.spans[index].start <= AVTimeRangeSetPrivate::floor(time, p->d.time.timescale())) {
+        return AVTime(p->d.time, p->d.spans[index].end); // spans are never adjacent, the end is uncovered
+    }
+    return time;
+}
+
+bool
+AVTimeRangeSet::contains(const AVTime& time) const
+{
+    if (is_empty()) {
+        return false;
+    }
+    qint64 ticks = AVTimeRangeSetPrivate::floor(time, p->d.time.timescale()); // exact, span bounds are whole ticks
+    qsizetype index = p->find(ticks);
+    return index < size() && p->d.spans[index].start <= ticks;
+}
+
+bool
+AVTimeRangeSet::contains(const AVTimeRange& range) const
+{
+    if (is_empty()) {
+        return false;
+    }
+    qint64 start = AVTimeRangeSetPrivate::floor(range.start(), p->d.time.timescale());
+    qint64 end = AVTimeRangeSetPrivate::ceil(range.end(), p->d.time.timescale());
+    qsizetype index = p->find(start);
+    return index < size() && p->d.spans[index].start <= start && end <= p->d.spans[index].end;
+}
+
+bool
+AVTimeRangeSet::intersects(const AVTimeRange& range) const
+{
+    if (is_empty()) {
+        return false;
+    }
+    qint64 start = AVTimeRangeSetPrivate::floor(range.start(), p->d.time.timescale());
+    qint64 end = AVTimeRangeSetPrivate::ceil(range.end(), p->d.time.timescale());
+    qsizetype index = p->find(start);
+    return index < size() && p->d.spans[index].start < end && start < end;
+}
+
+bool
+AVTimeRangeSet::is_empty() const
+{
+    return p->d.spans.isEmpty();
+}
+
+void
+AVTimeRangeSet::insert(const AVTimeRange& range)
+{
+    if (!range.valid()) {
+        return;
+    }
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->adopt(range.start());
+    AVTimeSpan span = p->span(range);
+    QList<AVTimeSpan>& spans = p->d.spans;
+    auto first = std::lower_bound(spans.begin(), spans.end(), span.start, [](const AVTimeSpan& span, qint64 ticks) {
+        return span.end < ticks; // adjacent spans are joined
+    });
+    auto last = first;
+    while (last != spans.end() && last->start <= span.end) {
+        span.start = qMin(span.start, last->start);
+        span.end = qMax(span.end, last->end);
+        ++last;
+    }
+    if (first == last) {
+        spans.insert(first, span);
+    }
+    else {
+        *first = span;
+        spans.erase(first + 1, last);
+    }
+}
+
+void
+AVTimeRangeSet::remove(const AVTimeRange& range)
+{
+    if (!range.valid() || is_empty()) {
+        return;
+    }
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    AVTimeSpan span = p->span(range);
+    QList<AVTimeSpan>& spans = p->d.spans;
+    qsizetype first = p->find(span.start);
+    qsizetype last = first;
+    while (last < spans.size() && spans[last].start < span.end) {
+        last++;
+    }
+    if (first == last) {
+        return;
+    }
+    QList<AVTimeSpan> pieces;
+    if (spans[first].start < span.start) {
+        pieces.append(AVTimeSpan { spans[first].start, span.start });
+    }
+    if (spans[last - 1].end > span.end) {
+        pieces.append(AVTimeSpan { span.end, spans[last - 1].end });
+    }
+    spans.remove(first, last - first);
+    for (qsizetype i = 0; i < pieces.size(); i++) {
+        spans.insert(first + i, pieces[i]);
+    }
+}
+
+void
+AVTimeRangeSet::clear()
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->d.spans.clear();
+}
+
+AVTimeRangeSet
+AVTimeRangeSet::united(const AVTimeRangeSet& other) const
+{
+    if (is_empty()) {
+        return other;
+    }
+    AVTimeRangeSet set(*this);
+    set.p.detach();
+    set.p->d.spans = AVTimeRangeSetPrivate::unite(p->d.spans, p->spans(*other.p));
+    return set;
+}
+
+AVTimeRangeSet
+AVTimeRangeSet::intersected(const AVTimeRangeSet& other) const
+{
+    AVTimeRangeSet set(*this);
+    set.p.detach();
+    set.p->d.spans = AVTimeRangeSetPrivate::intersect(p->d.spans, p->spans(*other.p));
+    return set;
+}
+
+AVTimeRangeSet
+AVTimeRangeSet::subtracted(const AVTimeRangeSet& other) const
+{
+    AVTimeRangeSet set(*this);
+    set.p.detach();
+    set.p->d.spans = AVTimeRangeSetPrivate::subtract(p->d.spans, p->spans(*other.p));
+    return set;
+}
+
+AVTimeRangeSet&
+AVTimeRangeSet::operator=(const AVTimeRangeSet& other)
+{
+    if (this != &other) {
+        p = other.p;
+    }
+    return *this;
+}
+
+bool
+AVTimeRangeSet::operator==(const AVTimeRangeSet& other) const
+{
+    if (size() != other.size()) {
+        return false;
+    }
+    for (qsizetype i = 0; i < size(); i++) {
+        if (range(i).start() != other.range(i).start() || range(i).end() != other.range(i).end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+AVTimeRangeSet::operator!=(const AVTimeRangeSet& other) const
+{
+    return !(*this == other);
+}
+
+AVTimeRangeSet
+AVTimeRangeSet::operator|(const AVTimeRangeSet& other) const
+{
+    return united(other);
+}
+
+AVTimeRangeSet
+AVTimeRangeSet::operator&(const AVTimeRangeSet& other) const
+{
+    return intersected(other);
+}
+
+AVTimeRangeSet
+AVTimeRangeSet::operator-(const AVTimeRangeSet& other) const
+{
+    return subtracted(other);
+}
+
+AVTimeRangeSet&
+AVTimeRangeSet::operator|=(const AVTimeRangeSet& other)
+{
+    return *this = united(other);
+}
+
+AVTimeRangeSet&
+AVTimeRangeSet::operator&=(const AVTimeRangeSet& other)
+{
+    return *this = intersected(other);
+}
+
+AVTimeRangeSet&
+AVTimeRangeSet::operator-=(const AVTimeRangeSet& other)
+{
+    return *this = subtracted(other);
+}
+
+class AVTimeRangeIndexPrivate
+{
+    public:
+        AVTimeRangeIndexPrivate();
+        AVTimeRangeIndexPrivate(const AVTimeRangeIndexPrivate& other);
+        void overlap(qint64 start, qint64 end, QList<qsizetype>& ids) const;
+        struct Interval
+        {
+            qint64 start = 0;
+            qint64 end = 0;
+            qint64 max = 0; // max end in the implicit subtree rooted here
+            qsizetype id = 0;
+        };
+        struct Data
+        {
+            QList<Interval> intervals; // sorted by start once built, an implicit augmented tree as in cgranges
+            QList<AVTimeSpan> spans; // by id
+            AVTime time = AVTime(0, 0, AVFps());
+            int level = -1;
+            bool built = true;
+        };
+        Data d;
+        QAtomicInt ref;
+};
+
+AVTimeRangeIndexPrivate::AVTimeRangeIndexPrivate()
+{
+}
+
+AVTimeRangeIndexPrivate::AVTimeRangeIndexPrivate(const AVTimeRangeIndexPrivate& other)
+: d(other.d) // detached copies start with a fresh ref count
+{
+}
+
+void
+AVTimeRangeIndexPrivate::overlap(qint64 start, qint64 end, QList<qsizetype>& ids) const
+{
+    struct Node
+    {
+        qint64 x;
+        int k;
+        bool left;
+    };
+    const Interval* a = d.intervals.constData();
+    qint64 n = d.intervals.size();
+    if (d.level < 0) {
+        return;
+    }
+    Node stack[64];
+    int top = 0;
+    stack[top++] = Node { (qint64(1) << d.level) - 1, d.level, false }; // root, traversed top-down
+    while (top) {
+        Node z = stack[--top];
+        if (z.k <= 3) { // small subtree, scan it linearly
+            qint64 i0 = z.x >> z.k << z.k;
+            qint64 i1 = qMin(i0 + (qint64(1) << (z.k + 1)) - 1, n);
+            for (qint64 i = i0; i < i1 && a[i].start < end; i++) {
+                if (start < a[i].end) {
+                    ids.append(a[i].id);
+                }
+            }
+        }
+        else if (!z.left) {
+            qint64 y = z.x - (qint64(1) << (z.k - 1)); // left child, may be out of range
+            stack[top++] = Node { z.x, z.k, true };
+            if (y >= n || a[y].max > start) {
+                stack[top++] = Node { y, z.k - 1, false };
+            }
+        }
+        else if (z.x < n && a[z.x].start < end) {
+            if (start < a[z.x].end) {
+                ids.append(a[z.x].id);
+            }
+            stack[top++] = Node { z.x + (qint64(1) << (z.k - 1)), z.k - 1, false }; // right child
+        }
+    }
+}
+
+AVTimeRangeIndex::AVTimeRangeIndex()
+: p(new AVTimeRangeIndexPrivate())
+{
+}
+
+AVTimeRangeIndex::AVTimeRangeIndex(const AVTimeRangeIndex& other)
+: p(other.p)
+{
+}
+
+AVTimeRangeIndex::~AVTimeRangeIndex()
+{
+}
+
+qsizetype
+AVTimeRangeIndex::size() const
+{
+    return p->d.spans.size();
+}
+
+AVTimeRange
+AVTimeRangeIndex::range(qsizetype id) const
+{
+    Q_ASSERT("id is out of range" && id >= 0 && id < size());
+    const AVTimeSpan& span = p->d.spans[id];
+    return AVTimeRange(AVTime(p->d.time, span.start), AVTime(p->d.time, span.end - span.start));
+}
+
+qsizetype
+AVTimeRangeIndex::covering(const AVTime& time, QList<qsizetype>& ids) const
+{
+    Q_ASSERT("index is not built" && p->d.built);
+    ids.clear();
+    if (size()) {
+        qint64 ticks = AVTimeRangeSetPrivate::floor(time, p->d.time.timescale()); // exact, bounds are whole ticks
+        p->overlap(ticks, ticks + 1, ids);
+    }
+    return ids.size();
+}
+
+qsizetype
+AVTimeRangeIndex::overlapping(const AVTimeRange& range, QList<qsizetype>& ids) const
+{
+    Q_ASSERT("index is not built" && p->d.built);
+    ids.clear();
+    if (size()) {
+        qint64 start = AVTimeRangeSetPrivate::floor(range.start(), p->d.time.timescale());
+        qint64 end = AVTimeRangeSetPrivate::ceil(range.end(), p->d.time.timescale());
+        p->overlap(start, end, ids);
+    }
+    return ids.size();
+}
+
+QList<qsizetype>
+AVTimeRangeIndex::covering(const AVTime& time) const
+{
+    QList<qsizetype> ids;
+    covering(time, ids);
+    return ids;
+}
+
+qsizetype
+AVTimeRangeIndex::append(const AVTimeRange& range)
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    if (!p->d.time.valid()) {
+        p->d.time = AVTime(range.start(), qint64(0));
+    }
+    qint32 timescale = p->d.time.timescale();
+    AVTimeSpan span { range.start().ticks(), range.end().ticks() };
+    if (range.start().timescale() != timescale) {
+        span = AVTimeSpan { AVTimeRangeSetPrivate::floor(range.start(), timescale), AVTimeRangeSetPrivate::ceil(range.end(), timescale) };
+    }
+    qsizetype id = p->d.spans.size();
+    p->d.spans.append(span);
+    p->d.intervals.append(AVTimeRangeIndexPrivate::Interval { span.start, span.end, span.end, id });
+    p->d.built = false;
+    return id;
+}
+
+void
+AVTimeRangeIndex::build()
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    QList<AVTimeRangeIndexPrivate::Interval>& intervals = p->d.intervals;
+    std::sort(intervals.begin(), intervals.end(), [](const auto& a, const auto& b) {
+        return a.start < b.start || (a.start == b.start && a.id < b.id);
+    });
+    qint64 n = intervals.size();
+    p->d.level = -1;
+    p->d.built = true;
+    if (n == 0) {
+        return;
+    }
+    qint64 lasti = 0;
+    qint64 last = 0;
+    for (qint64 i = 0; i < n; i += 2) { // leaves
+        lasti = i;
+        last = intervals[i].max = intervals[i].end;
+    }
+    int k = 1;
+    for (; (qint64(1) << k) <= n; k++) { // internal nodes, bottom-up
+        qint64 x = qint64(1) << (k - 1);
+        qint64 i0 = (x << 1) - 1;
+        qint64 step = x << 2;
+        for (qint64 i = i0; i < n; i += step) {
+            qint64 left = intervals[i - x].max;
+            qint64 right = i + x < n ? intervals[i + x].max : last;
+            intervals[i].max = qMax(intervals[i].end, qMax(left, right));
+        }
+        lasti = (lasti >> k & 1) ? lasti - x : lasti + x; // parent of the rightmost node
+        if (lasti < n && intervals[lasti].max > last) {
+            last = intervals[lasti].max;
+        }
+    }
+    p->d.level = k - 1;
+}
+
+void
+AVTimeRangeIndex::clear()
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->d.intervals.clear();
+    p->d.spans.clear();
+    p->d.level = -1;
+    p->d.built = true;
+}
+
+AVTimeRangeIndex&
+AVTimeRangeIndex::operator=(const AVTimeRangeIndex& other)
+{
+    if (this != &other) {
+        p = other.p;
+    }
+    return *this;
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avtime.h"
+#include "avtimerange.h"
+
+#include <QExplicitlySharedDataPointer>
+#include <QList>
+
+class AVTimeRangeSetPrivate;
+class AVTimeRangeSet
+{
+    public:
+        AVTimeRangeSet();
+        AVTimeRangeSet(const AVTimeRange& range);
+        AVTimeRangeSet(const AVTimeRangeSet& other);
+        ~AVTimeRangeSet();
+        qsizetype size() const;
+        AVTimeRange range(qsizetype index) const;
+        QList<AVTimeRange> ranges() const;
+        AVTimeRange bounds() const;
+        AVTime duration() const;
+        AVTime next_gap(const AVTime& time) const;
+        bool contains(const AVTime& time) const;
+        bool contains(const AVTimeRange& range) const;
+        bool intersects(const AVTimeRange& range) const;
+        bool is_empty() const;
+        void insert(const AVTimeRange& range);
+        void remove(const AVTimeRange& range);
+        void clear();
+
+        AVTimeRangeSet united(const AVTimeRangeSet& other) const;
+        AVTimeRangeSet intersected(const AVTimeRangeSet& other) const;
+        AVTimeRangeSet subtracted(const AVTimeRangeSet& other) const;
+
+        AVTimeRangeSet& operator=(const AVTimeRangeSet& other);
+        bool operator==(const AVTimeRangeSet& other) const;
+        bool operator!=(const AVTimeRangeSet& other) const;
+        AVTimeRangeSet operator|(const AVTimeRangeSet& other) const;
+        AVTimeRangeSet operator&(const AVTimeRangeSet& other) const;
+        AVTimeRangeSet operator-(const AVTimeRangeSet& other) const;
+        AVTimeRangeSet& operator|=(const AVTimeRangeSet& other);
+        AVTimeRangeSet& operator&=(const AVTimeRangeSet& other);
+        AVTimeRangeSet& operator-=(const AVTimeRangeSet& other);
+
+    private:
+        QExplicitlySharedDataPointer<AVTimeRangeSetPrivate> p;
+};
+
+class AVTimeRangeIndexPrivate;
+class AVTimeRangeIndex
+{
+    public:
+        AVTimeRangeIndex();
+        AVTimeRangeIndex(const AVTimeRangeIndex& other);
+        ~AVTimeRangeIndex();
+        qsizetype size() const;
+        AVTimeRange range(qsizetype id) const;
+        qsizetype covering(const AVTime& time, QList<qsizetype>& ids) const;
+        qsizetype overlapping(const AVTimeRange& range, QList<qsizetype>& ids) const;
+        QList<qsizetype> covering(const AVTime& time) const;
+        qsizetype append(const AVTimeRange& range);
+        void build();
+        void clear();
+
+        AVTimeRangeIndex& operator=(const AVTimeRangeIndex& other);
+
+    private:
+        QExplicitlySharedDataPointer<AVTimeRangeIndexPrivate> p;
+};
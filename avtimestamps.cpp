@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avtimestamps.h"
+#include "avrealtime.h"
+
+#include <QList>
+
+#include <algorithm>
+#include <limits>
+
+class AVTimestampsPrivate
+{
+    public:
+        AVTimestampsPrivate();
+        AVTimestampsPrivate(const AVTimestampsPrivate& other);
+        qint64 anchor(qint64 frame) const;
+        struct Data
+        {
+            QList<qint64> anchors; // ticks of the first frame in each block
+            QList<quint32> offsets; // ticks from the block anchor, one per frame
+            qint64 end = 0;
+            qint64 step = 0; // first frame duration, used to detect constant rates
+            qint32 timescale = 0;
+            bool constant = true;
+        };
+        Data d;
+        QAtomicInt ref;
+};
+
+AVTimestampsPrivate::AVTimestampsPrivate()
+{
+}
+
+AVTimestampsPrivate::AVTimestampsPrivate(const AVTimestampsPrivate& other)
+: d(other.d) // detached copies start with a fresh ref count
+{
+}
+
+qint64
+AVTimestampsPrivate::anchor(qint64 frame) const
+{
+    return d.anchors[frame / AVTimestamps::block];
+}
+
+AVTimestamps::AVTimestamps()
+: p(new AVTimestampsPrivate())
+{
+}
+
+AVTimestamps::AVTimestamps(qint32 timescale)
+: p(new AVTimestampsPrivate())
+{
+    p->d.timescale = timescale;
+}
+
+AVTimestamps::AVTimestamps(const AVTimestamps& other)
+: p(other.p)
+{
+}
+
+AVTimestamps::~AVTimestamps()
+{
+}
+
+qint64
+AVTimestamps::ticks(qint64 frame) const
+{
+    Q_ASSERT("timestamps are not valid" && valid());
+
+    frame = qBound(qint64(0), frame, count() - 1);
+    return p->anchor(frame) + p->d.offsets[frame];
+}
+
+qint64
+AVTimestamps::frame(qint64 ticks) const
+{
+    Q_ASSERT("timestamps are not valid" && valid());
+
+    const QList<qint64>& anchors = p->d.anchors;
+    if (ticks <= anchors.first()) {
+        return 0;
+    }
+    qsizetype block = std::upper_bound(anchors.begin(), anchors.end(), ticks) - anchors.begin() - 1;
+    qint64 offset = ticks - anchors[block];
+    auto first = p->d.offsets.begin() + block * AVTimestamps::block;
+    auto last = p->d.offsets.begin() + qMin<qint64>((block + 1) * AVTimestamps::block, count());
+    if (offset >= std::numeric_limits<quint32>::max()) {
+        return (last - p->d.offsets.begin()) - 1;
+    }
+    return (std::upper_bound(first, last, static_cast<quint32>(offset)) - p->d.offsets.begin()) - 1;
+}
+
+qint64
+AVTimestamps::duration(qint64 frame) const
+{
+    Q_ASSERT("timestamps are not valid" && valid());
+
+    if (frame + 1 < count()) {
+        return ticks(frame + 1) - ticks(frame);
+    }
+    return qMax(p->d.end - ticks(frame), qint64(0));
+}
+
+qint64
+AVTimestamps::align(qint64 ticks) const
+{
+    return this->ticks(frame(ticks));
+}
+
+qint64
+AVTimestamps::count() const
+{
+    return p->d.offsets.size();
+}
+
+qint64
+AVTimestamps::end() const
+{
+    return p->d.end;
+}
+
+qint32
+AVTimestamps::timescale() const
+{
+    return p->d.timescale;
+}
+
+qsizetype
+AVTimestamps::bytes() const
+{
+    return p->d.anchors.capacity() * sizeof(qint64) + p->d.offsets.capacity() * sizeof(quint32);
+}
+
+bool
+AVTimestamps::constant() const
+{
+    return p->d.constant;
+}
+
+bool
+AVTimestamps::valid() const
+{
+    return p->d.timescale > 0 && !p->d.offsets.isEmpty();
+}
+
+bool
+AVTimestamps::lock() const
+{
+    const QList<qint64>& anchors = p->d.anchors;
+    const QList<quint32>& offsets = p->d.offsets;
+    return AVRealtime::lock(anchors.constData(), anchors.size() * sizeof(qint64)) &&
+           AVRealtime::lock(offsets.constData(), offsets.size() * sizeof(quint32));
+}
+
+void
+AVTimestamps::unlock() const
+{
+    AVRealtime::unlock(p->d.anchors.constData(), p->d.anchors.size() * sizeof(qint64));
+    AVRealtime::unlock(p->d.offsets.constData(), p->d.offsets.size() * sizeof(quint32));
+}
+
+void
+AVTimestamps::append(qint64 ticks)
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    qint64 frame = count();
+    if (frame > 0) {
+        qint64 previous = this->ticks(frame - 1);
+        Q_ASSERT("timestamps must be in presentation order" && ticks > previous);
+        if (frame == 1) {
+            p->d.step = ticks - previous;
+        }
+        else if (ticks - previous != p->d.step) {
+            p->d.constant = false;
+        }
+    }
+    if (frame % block == 0) {
+        p->d.anchors.append(ticks);
+    }
+    qint64 offset = ticks - p->d.anchors.last();
+    Q_ASSERT("offset exceeds 32 bits within a block" && offset < std::numeric_limits<quint32>::max());
+    p->d.offsets.append(static_cast<quint32>(offset));
+    p->d.end = qMax(p->d.end, ticks);
+}
+
+void
+AVTimestamps::reserve(qint64 count)
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->d.anchors.reserve((count + block - 1) / block);
+    p->d.offsets.reserve(count);
+}
+
+void
+AVTimestamps::squeeze()
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->d.anchors.squeeze();
+    p->d.offsets.squeeze();
+}
+
+void
+AVTimestamps::clear()
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->d.anchors.clear();
+    p->d.offsets.clear();
+    p->d.end = 0;
+    p->d.step = 0;
+    p->d.constant = true;
+}
+
+void
+AVTimestamps::set_end(qint64 ticks)
+{
+    if (p->ref.loadRelaxed() > 1) {
+        p.detach();
+    }
+    p->d.end = ticks;
+}
+
+AVTimestamps&
+AVTimestamps::operator=(const AVTimestamps& other)
+{
+    if (this != &other) {
+        p = other.p;
+    }
+    return *this;
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avtime.h"
+
+#include <QExplicitlySharedDataPointer>
+
+class AVTimestampsPrivate;
+class AVTimestamps
+{
+    public:
+        AVTimestamps();
+        AVTimestamps(qint32 timescale);
+        AVTimestamps(const AVTimestamps& other);
+        ~AVTimestamps();
+        qint64 ticks(qint64 frame) const;
+        qint64 frame(qint64 ticks) const;
+        qint64 duration(qint64 frame) const;
+        qint64 align(qint64 ticks) const;
+        qint64 count() const;
+        qint64 end() const;
+        qint32 timescale() const;
+        qsizetype bytes() const;
+        bool constant() const;
+        bool valid() const;
+        bool lock() const; // keeps the tables resident for pacing, see AVRealtime::lock
+        void unlock() const;
+        void append(qint64 ticks);
+        void reserve(qint64 count);
+        void squeeze();
+        void clear();
+        void set_end(qint64 ticks);
+
+        AVTimestamps& operator=(const AVTimestamps& other);
+
+        static constexpr qint64 block = 64; // frames per anchor
+
+    private:
+        QExplicitlySharedDataPointer<AVTimestampsPrivate> p;
+};
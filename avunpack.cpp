@@ -0,0 +1,560 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avunpack.h"
+
+#include <QtEndian>
+
+#include <atomic>
+#include <initializer_list>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define AVUNPACK_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define AVUNPACK_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+    constexpr float scale = 1.0f / 1023.0f; // multiplied, not divided, so every kernel rounds the same
+
+    struct Shifts
+    {
+        int r;
+        int g;
+        int b;
+    };
+
+    inline Shifts shifts(AVUnpack::Packing packing) {
+        return packing == AVUnpack::METHOD_A ? Shifts { 22, 12, 2 } : Shifts { 20, 10, 0 };
+    }
+
+    inline quint16 widen(quint32 value) { // 10 to 16 bits, 1023 maps to 65535
+        return static_cast<quint16>((value << 6) | (value >> 4));
+    }
+
+    std::atomic<int> selected { -1 };
+
+    template<typename T>
+    void yuv_scalar(const T* luma, const T* cb, const T* cr, qsizetype count, const AVUnpack::Yuv& yuv, quint32* argb) {
+        auto clamp = [](int value) { return static_cast<quint32>(qBound(0, value, 255)); };
+        for (qsizetype x = 0; x < count; x++) {
+            int y = (static_cast<int>(luma[x] >> yuv.shift) - yuv.y0) * yuv.cy;
+            if (!cb) {
+                quint32 v = clamp((y + 8192) >> 14);
+                argb[x] = 0xff000000 | (v << 16) | (v << 8) | v;
+                continue;
+            }
+            int u = static_cast<int>(cb[x >> yuv.xshift] >> yuv.shift) - 128;
+            int v = static_cast<int>(cr[x >> yuv.xshift] >> yuv.shift) - 128;
+            quint32 r = clamp((y + yuv.crr * v + 8192) >> 14);
+            quint32 g = clamp((y - yuv.cgb * u - yuv.cgr * v + 8192) >> 14);
+            quint32 b = clamp((y + yuv.cbb * u + 8192) >> 14);
+            argb[x] = 0xff000000 | (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+void
+AVUnpack::unpack10_scalar(const quint32* words, qsizetype count, Packing packing, bool swap, quint16* rgbx)
+{
+    Shifts s = shifts(packing);
+    for (qsizetype i = 0; i < count; i++) {
+        quint32 word = swap ? qbswap(words[i]) : words[i];
+        rgbx[0] = widen((word >> s.r) & 0x3ff);
+        rgbx[1] = widen((word >> s.g) & 0x3ff);
+        rgbx[2] = widen((word >> s.b) & 0x3ff);
+        rgbx[3] = 0xffff;
+        rgbx += 4;
+    }
+}
+
+void
+AVUnpack::unpack10_scalar(const quint32* words, qsizetype count, Packing packing, bool swap, float* rgbx)
+{
+    Shifts s = shifts(packing);
+    for (qsizetype i = 0; i < count; i++) {
+        quint32 word = swap ? qbswap(words[i]) : words[i];
+        rgbx[0] = static_cast<float>((word >> s.r) & 0x3ff) * scale;
+        rgbx[1] = static_cast<float>((word >> s.g) & 0x3ff) * scale;
+        rgbx[2] = static_cast<float>((word >> s.b) & 0x3ff) * scale;
+        rgbx[3] = static_cast<float>(0x3ff) * scale;
+        rgbx += 4;
+    }
+}
+
+void
+AVUnpack::yuv_argb32_scalar(const quint8* y, const quint8* cb, const quint8* cr, qsizetype count, const Yuv& yuv,
+                            quint32* argb)
+{
+    yuv_scalar(y, cb, cr, count, yuv, argb);
+}
+
+void
+AVUnpack::yuv_argb32_scalar(const quint16* y, const quint16* cb, const quint16* cr, qsizetype count, const Yuv& yuv,
+                            quint32* argb)
+{
+    yuv_scalar(y, cb, cr, count, yuv, argb);
+}
+
+#if defined(AVUNPACK_X86)
+namespace {
+    // one word broadcast to four lanes, multiplied so each component lands in the top 10 bits
+    template<int Lane>
+    __attribute__((target("sse4.1"))) inline __m128i sse41_pixel(__m128i words, __m128i multipliers) {
+        __m128i x = _mm_shuffle_epi32(words, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+        x = _mm_srli_epi32(_mm_mullo_epi32(x, multipliers), 22);
+        return _mm_or_si128(x, _mm_setr_epi32(0, 0, 0, 0x3ff));
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i sse41_widen(__m128i x) {
+        return _mm_or_si128(_mm_slli_epi32(x, 6), _mm_srli_epi32(x, 4));
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i sse41_load(const quint32* words, bool swap) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words));
+        if (swap) {
+            x = _mm_shuffle_epi8(x, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+        }
+        return x;
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i sse41_multipliers(AVUnpack::Packing packing) {
+        Shifts s = shifts(packing);
+        return _mm_setr_epi32(1 << (22 - s.r), 1 << (22 - s.g), 1 << (22 - s.b), 0);
+    }
+
+    __attribute__((target("sse4.1")))
+    qsizetype sse41_unpack10(const quint32* words, qsizetype count, AVUnpack::Packing packing, bool swap, quint16* rgbx) {
+        __m128i multipliers = sse41_multipliers(packing);
+        qsizetype i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i x = sse41_load(words + i, swap);
+            __m128i p0 = sse41_widen(sse41_pixel<0>(x, multipliers));
+            __m128i p1 = sse41_widen(sse41_pixel<1>(x, multipliers));
+            __m128i p2 = sse41_widen(sse41_pixel<2>(x, multipliers));
+            __m128i p3 = sse41_widen(sse41_pixel<3>(x, multipliers));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgbx + i * 4), _mm_packus_epi32(p0, p1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(rgbx + i * 4 + 8), _mm_packus_epi32(p2, p3));
+        }
+        return i;
+    }
+
+    __attribute__((target("sse4.1")))
+    qsizetype sse41_unpack10(const quint32* words, qsizetype count, AVUnpack::Packing packing, bool swap, float* rgbx) {
+        __m128i multipliers = sse41_multipliers(packing);
+        __m128 factor = _mm_set1_ps(scale);
+        qsizetype i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i x = sse41_load(words + i, swap);
+            float* out = rgbx + i * 4;
+            _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(sse41_pixel<0>(x, multipliers)), factor));
+            _mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(sse41_pixel<1>(x, multipliers)), factor));
+            _mm_storeu_ps(out + 8, _mm_mul_ps(_mm_cvtepi32_ps(sse41_pixel<2>(x, multipliers)), factor));
+            _mm_storeu_ps(out + 12, _mm_mul_ps(_mm_cvtepi32_ps(sse41_pixel<3>(x, multipliers)), factor));
+        }
+        return i;
+    }
+
+    // two words per vector, each permuted to four lanes and shifted per lane
+    __attribute__((target("avx2"))) inline __m256i avx2_pixels(__m256i words, int pair, __m256i shifts) {
+        __m256i index = _mm256_setr_epi32(2 * pair, 2 * pair, 2 * pair, 2 * pair,
+                                          2 * pair + 1, 2 * pair + 1, 2 * pair + 1, 2 * pair + 1);
+        __m256i x = _mm256_srlv_epi32(_mm256_permutevar8x32_epi32(words, index), shifts);
+        x = _mm256_and_si256(x, _mm256_set1_epi32(0x3ff));
+        return _mm256_or_si256(x, _mm256_setr_epi32(0, 0, 0, 0x3ff, 0, 0, 0, 0x3ff));
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_widen(__m256i x) {
+        return _mm256_or_si256(_mm256_slli_epi32(x, 6), _mm256_srli_epi32(x, 4));
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_load(const quint32* words, bool swap) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+        if (swap) {
+            x = _mm256_shuffle_epi8(x, _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+        }
+        return x;
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_shifts(AVUnpack::Packing packing) {
+        Shifts s = shifts(packing);
+        return _mm256_setr_epi32(s.r, s.g, s.b, 0, s.r, s.g, s.b, 0);
+    }
+
+    __attribute__((target("avx2")))
+    qsizetype avx2_unpack10(const quint32* words, qsizetype count, AVUnpack::Packing packing, bool swap, quint16* rgbx) {
+        __m256i shifts = avx2_shifts(packing);
+        qsizetype i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i x = avx2_load(words + i, swap);
+            __m256i p0 = avx2_widen(avx2_pixels(x, 0, shifts));
+            __m256i p1 = avx2_widen(avx2_pixels(x, 1, shifts));
+            __m256i p2 = avx2_widen(avx2_pixels(x, 2, shifts));
+            __m256i p3 = avx2_widen(avx2_pixels(x, 3, shifts));
+            // packus interleaves 128-bit halves, the permute restores pixel order
+            __m256i a = _mm256_permute4x64_epi64(_mm256_packus_epi32(p0, p1), _MM_SHUFFLE(3, 1, 2, 0));
+            __m256i b = _mm256_permute4x64_epi64(_mm256_packus_epi32(p2, p3), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgbx + i * 4), a);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgbx + i * 4 + 16), b);
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2")))
+    qsizetype avx2_unpack10(const quint32* words, qsizetype count, AVUnpack::Packing packing, bool swap, float* rgbx) {
+        __m256i shifts = avx2_shifts(packing);
+        __m256 factor = _mm256_set1_ps(scale);
+        qsizetype i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i x = avx2_load(words + i, swap);
+            float* out = rgbx + i * 4;
+            _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(avx2_pixels(x, 0, shifts)), factor));
+            _mm256_storeu_ps(out + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(avx2_pixels(x, 1, shifts)), factor));
+            _mm256_storeu_ps(out + 16, _mm256_mul_ps(_mm256_cvtepi32_ps(avx2_pixels(x, 2, shifts)), factor));
+            _mm256_storeu_ps(out + 24, _mm256_mul_ps(_mm256_cvtepi32_ps(avx2_pixels(x, 3, shifts)), factor));
+        }
+        return i;
+    }
+
+    // y'cbcr in 32-bit lanes, one pixel per lane, subsampled chroma repeated to pairs of lanes
+    __attribute__((target("sse4.1"))) inline __m128i sse41_load(const quint8* samples) {
+        return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(qFromUnaligned<qint32>(samples)));
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i sse41_load(const quint16* samples) {
+        return _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples)));
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i sse41_load_pairs(const quint8* samples) {
+        __m128i x = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(qFromUnaligned<quint16>(samples)));
+        return _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 1, 0, 0));
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i sse41_load_pairs(const quint16* samples) {
+        __m128i x = _mm_cvtepu16_epi32(_mm_cvtsi32_si128(qFromUnaligned<qint32>(samples)));
+        return _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 1, 0, 0));
+    }
+
+    __attribute__((target("sse4.1"))) inline __m128i sse41_clamp(__m128i x) {
+        x = _mm_srai_epi32(_mm_add_epi32(x, _mm_set1_epi32(8192)), 14);
+        return _mm_min_epi32(_mm_max_epi32(x, _mm_setzero_si128()), _mm_set1_epi32(255));
+    }
+
+    template<typename T>
+    __attribute__((target("sse4.1")))
+    qsizetype sse41_yuv(const T* luma, const T* cb, const T* cr, qsizetype count, const AVUnpack::Yuv& yuv, quint32* argb) {
+        __m128i shift = _mm_cvtsi32_si128(yuv.shift);
+        __m128i y0 = _mm_set1_epi32(yuv.y0);
+        __m128i cy = _mm_set1_epi32(yuv.cy);
+        __m128i half = _mm_set1_epi32(128);
+        __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+        qsizetype i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i y = _mm_mullo_epi32(_mm_sub_epi32(_mm_srl_epi32(sse41_load(luma + i), shift), y0), cy);
+            __m128i r, g, b;
+            if (!cb) {
+                r = g = b = sse41_clamp(y);
+            }
+            else {
+                __m128i u = yuv.xshift ? sse41_load_pairs(cb + (i >> 1)) : sse41_load(cb + i);
+                __m128i v = yuv.xshift ? sse41_load_pairs(cr + (i >> 1)) : sse41_load(cr + i);
+                u = _mm_sub_epi32(_mm_srl_epi32(u, shift), half);
+                v = _mm_sub_epi32(_mm_srl_epi32(v, shift), half);
+                r = sse41_clamp(_mm_add_epi32(y, _mm_mullo_epi32(_mm_set1_epi32(yuv.crr), v)));
+                g = sse41_clamp(_mm_sub_epi32(_mm_sub_epi32(y, _mm_mullo_epi32(_mm_set1_epi32(yuv.cgb), u)),
+                                              _mm_mullo_epi32(_mm_set1_epi32(yuv.cgr), v)));
+                b = sse41_clamp(_mm_add_epi32(y, _mm_mullo_epi32(_mm_set1_epi32(yuv.cbb), u)));
+            }
+            __m128i x = _mm_or_si128(_mm_or_si128(alpha, _mm_slli_epi32(r, 16)), _mm_or_si128(_mm_slli_epi32(g, 8), b));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(argb + i), x);
+        }
+        return i;
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_load(const quint8* samples) {
+        return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples)));
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_load(const quint16* samples) {
+        return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(samples)));
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_load_pairs(const quint8* samples) {
+        __m256i x = _mm256_cvtepu8_epi32(_mm_cvtsi32_si128(qFromUnaligned<qint32>(samples)));
+        return _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3));
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_load_pairs(const quint16* samples) {
+        __m256i x = _mm256_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(samples)));
+        return _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3));
+    }
+
+    __attribute__((target("avx2"))) inline __m256i avx2_clamp(__m256i x) {
+        x = _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(8192)), 14);
+        return _mm256_min_epi32(_mm256_max_epi32(x, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+    }
+
+    template<typename T>
+    __attribute__((target("avx2")))
+    qsizetype avx2_yuv(const T* luma, const T* cb, const T* cr, qsizetype count, const AVUnpack::Yuv& yuv, quint32* argb) {
+        __m128i shift = _mm_cvtsi32_si128(yuv.shift);
+        __m256i y0 = _mm256_set1_epi32(yuv.y0);
+        __m256i cy = _mm256_set1_epi32(yuv.cy);
+        __m256i half = _mm256_set1_epi32(128);
+        __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+        qsizetype i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i y = _mm256_mullo_epi32(_mm256_sub_epi32(_mm256_srl_epi32(avx2_load(luma + i), shift), y0), cy);
+            __m256i r, g, b;
+            if (!cb) {
+                r = g = b = avx2_clamp(y);
+            }
+            else {
+                __m256i u = yuv.xshift ? avx2_load_pairs(cb + (i >> 1)) : avx2_load(cb + i);
+                __m256i v = yuv.xshift ? avx2_load_pairs(cr + (i >> 1)) : avx2_load(cr + i);
+                u = _mm256_sub_epi32(_mm256_srl_epi32(u, shift), half);
+                v = _mm256_sub_epi32(_mm256_srl_epi32(v, shift), half);
+                r = avx2_clamp(_mm256_add_epi32(y, _mm256_mullo_epi32(_mm256_set1_epi32(yuv.crr), v)));
+                g = avx2_clamp(_mm256_sub_epi32(_mm256_sub_epi32(y, _mm256_mullo_epi32(_mm256_set1_epi32(yuv.cgb), u)),
+                                                _mm256_mullo_epi32(_mm256_set1_epi32(yuv.cgr), v)));
+                b = avx2_clamp(_mm256_add_epi32(y, _mm256_mullo_epi32(_mm256_set1_epi32(yuv.cbb), u)));
+            }
+            __m256i x = _mm256_or_si256(_mm256_or_si256(alpha, _mm256_slli_epi32(r, 16)),
+                                        _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(argb + i), x);
+        }
+        return i;
+    }
+}
+#endif
+
+#if defined(AVUNPACK_NEON)
+namespace {
+    inline uint32x4_t neon_load(const quint32* words, bool swap) {
+        uint32x4_t x = vld1q_u32(words);
+        return swap ? vreinterpretq_u32_u8(vrev32q_u8(vreinterpretq_u8_u32(x))) : x;
+    }
+
+    inline uint32x4_t neon_component(uint32x4_t words, int shift) {
+        return vandq_u32(vshlq_u32(words, vdupq_n_s32(-shift)), vdupq_n_u32(0x3ff));
+    }
+
+    inline uint16x4_t neon_widen(uint32x4_t x) {
+        return vmovn_u32(vorrq_u32(vshlq_n_u32(x, 6), vshrq_n_u32(x, 4)));
+    }
+
+    qsizetype neon_unpack10(const quint32* words, qsizetype count, AVUnpack::Packing packing, bool swap, quint16* rgbx) {
+        Shifts s = shifts(packing);
+        qsizetype i = 0;
+        for (; i + 4 <= count; i += 4) {
+            uint32x4_t x = neon_load(words + i, swap);
+            uint16x4x4_t pixels; // vst4 interleaves the components into rgbx
+            pixels.val[0] = neon_widen(neon_component(x, s.r));
+            pixels.val[1] = neon_widen(neon_component(x, s.g));
+            pixels.val[2] = neon_widen(neon_component(x, s.b));
+            pixels.val[3] = vdup_n_u16(0xffff);
+            vst4_u16(rgbx + i * 4, pixels);
+        }
+        return i;
+    }
+
+    qsizetype neon_unpack10(const quint32* words, qsizetype count, AVUnpack::Packing packing, bool swap, float* rgbx) {
+        Shifts s = shifts(packing);
+        float32x4_t factor = vdupq_n_f32(scale);
+        qsizetype i = 0;
+        for (; i + 4 <= count; i += 4) {
+            uint32x4_t x = neon_load(words + i, swap);
+            float32x4x4_t pixels;
+            pixels.val[0] = vmulq_f32(vcvtq_f32_u32(neon_component(x, s.r)), factor);
+            pixels.val[1] = vmulq_f32(vcvtq_f32_u32(neon_component(x, s.g)), factor);
+            pixels.val[2] = vmulq_f32(vcvtq_f32_u32(neon_component(x, s.b)), factor);
+            pixels.val[3] = vdupq_n_f32(static_cast<float>(0x3ff) * scale);
+            vst4q_f32(rgbx + i * 4, pixels);
+        }
+        return i;
+    }
+
+    inline int32x4_t neon_load(const quint8* samples) {
+        uint8x8_t x = vcreate_u8(qFromUnaligned<quint32>(samples));
+        return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(vmovl_u8(x))));
+    }
+
+    inline int32x4_t neon_load(const quint16* samples) {
+        return vreinterpretq_s32_u32(vmovl_u16(vld1_u16(samples)));
+    }
+
+    template<typename T>
+    inline int32x4_t neon_load_pairs(const T* samples) {
+        const int32_t pairs[4] = { samples[0], samples[0], samples[1], samples[1] };
+        return vld1q_s32(pairs);
+    }
+
+    inline int32x4_t neon_clamp(int32x4_t x) {
+        x = vshrq_n_s32(vaddq_s32(x, vdupq_n_s32(8192)), 14);
+        return vminq_s32(vmaxq_s32(x, vdupq_n_s32(0)), vdupq_n_s32(255));
+    }
+
+    template<typename T>
+    qsizetype neon_yuv(const T* luma, const T* cb, const T* cr, qsizetype count, const AVUnpack::Yuv& yuv, quint32* argb) {
+        int32x4_t shift = vdupq_n_s32(-yuv.shift);
+        int32x4_t y0 = vdupq_n_s32(yuv.y0);
+        int32x4_t half = vdupq_n_s32(128);
+        qsizetype i = 0;
+        for (; i + 4 <= count; i += 4) {
+            int32x4_t y = vmulq_n_s32(vsubq_s32(vshlq_s32(neon_load(luma + i), shift), y0), yuv.cy);
+            int32x4_t r, g, b;
+            if (!cb) {
+                r = g = b = neon_clamp(y);
+            }
+            else {
+                int32x4_t u = yuv.xshift ? neon_load_pairs(cb + (i >> 1)) : neon_load(cb + i);
+                int32x4_t v = yuv.xshift ? neon_load_pairs(cr + (i >> 1)) : neon_load(cr + i);
+                u = vsubq_s32(vshlq_s32(u, shift), half);
+                v = vsubq_s32(vshlq_s32(v, shift), half);
+                r = neon_clamp(vmlaq_n_s32(y, v, yuv.crr));
+                g = neon_clamp(vmlsq_n_s32(vmlsq_n_s32(y, u, yuv.cgb), v, yuv.cgr));
+                b = neon_clamp(vmlaq_n_s32(y, u, yuv.cbb));
+            }
+            uint32x4_t x = vorrq_u32(vdupq_n_u32(0xff000000), vreinterpretq_u32_s32(vshlq_n_s32(r, 16)));
+            x = vorrq_u32(x, vreinterpretq_u32_s32(vorrq_s32(vshlq_n_s32(g, 8), b)));
+            vst1q_u32(argb + i, x);
+        }
+        return i;
+    }
+}
+#endif
+
+namespace {
+    template<typename T>
+    void unpack(const quint32* words, qsizetype count, AVUnpack::Packing packing, bool swap, T* rgbx) {
+        qsizetype done = 0;
+        switch (AVUnpack::kernel()) {
+#if defined(AVUNPACK_X86)
+            case AVUnpack::AVX2:
+                done = avx2_unpack10(words, count, packing, swap, rgbx);
+                break;
+            case AVUnpack::SSE41:
+                done = sse41_unpack10(words, count, packing, swap, rgbx);
+                break;
+#endif
+#if defined(AVUNPACK_NEON)
+            case AVUnpack::NEON:
+                done = neon_unpack10(words, count, packing, swap, rgbx);
+                break;
+#endif
+            default:
+                break;
+        }
+        AVUnpack::unpack10_scalar(words + done, count - done, packing, swap, rgbx + done * 4); // remainder
+    }
+
+    template<typename T>
+    void convert(const T* y, const T* cb, const T* cr, qsizetype count, const AVUnpack::Yuv& yuv, quint32* argb) {
+        qsizetype done = 0; // a multiple of four, subsampled chroma continues at done / 2
+        switch (AVUnpack::kernel()) {
+#if defined(AVUNPACK_X86)
+            case AVUnpack::AVX2:
+                done = avx2_yuv(y, cb, cr, count, yuv, argb);
+                break;
+            case AVUnpack::SSE41:
+                done = sse41_yuv(y, cb, cr, count, yuv, argb);
+                break;
+#endif
+#if defined(AVUNPACK_NEON)
+            case AVUnpack::NEON:
+                done = neon_yuv(y, cb, cr, count, yuv, argb);
+                break;
+#endif
+            default:
+                break;
+        }
+        qsizetype chroma = done >> yuv.xshift;
+        yuv_scalar(y + done, cb ? cb + chroma : cb, cr ? cr + chroma : cr, count - done, yuv, argb + done); // remainder
+    }
+}
+
+void
+AVUnpack::unpack10(const quint32* words, qsizetype count, Packing packing, bool swap, quint16* rgbx)
+{
+    unpack(words, count, packing, swap, rgbx);
+}
+
+void
+AVUnpack::unpack10(const quint32* words, qsizetype count, Packing packing, bool swap, float* rgbx)
+{
+    unpack(words, count, packing, swap, rgbx);
+}
+
+void
+AVUnpack::yuv_argb32(const quint8* y, const quint8* cb, const quint8* cr, qsizetype count, const Yuv& yuv, quint32* argb)
+{
+    convert(y, cb, cr, count, yuv, argb);
+}
+
+void
+AVUnpack::yuv_argb32(const quint16* y, const quint16* cb, const quint16* cr, qsizetype count, const Yuv& yuv,
+                     quint32* argb)
+{
+    convert(y, cb, cr, count, yuv, argb);
+}
+
+AVUnpack::Kernel
+AVUnpack::kernel()
+{
+    int kernel = selected.load(std::memory_order_relaxed);
+    if (kernel < 0) {
+        for (Kernel best : { AVX2, NEON, SSE41, SCALAR }) {
+            if (supported(best)) {
+                kernel = best;
+                break;
+            }
+        }
+        selected.store(kernel, std::memory_order_relaxed);
+    }
+    return static_cast<Kernel>(kernel);
+}
+
+bool
+AVUnpack::supported(Kernel kernel)
+{
+    switch (kernel) {
+        case SCALAR:
+            return true;
+#if defined(AVUNPACK_X86)
+        case SSE41:
+            return __builtin_cpu_supports("sse4.1");
+        case AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(AVUNPACK_NEON)
+        case NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+void
+AVUnpack::set_kernel(Kernel kernel)
+{
+    selected.store(supported(kernel) ? kernel : -1, std::memory_order_relaxed);
+}
+
+const char*
+AVUnpack::name(Kernel kernel)
+{
+    switch (kernel) {
+        case SSE41:
+            return "sse4.1";
+        case AVX2:
+            return "avx2";
+        case NEON:
+            return "neon";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include <QtGlobal>
+
+// unpacks 10-bit rgb, three components per 32-bit word as in dpx, to rgbx with an opaque fourth
+// channel, and rows of planar y'cbcr as in y4m to argb32. kernels are selected at runtime from what
+// the cpu supports, every kernel matches the scalar reference bit for bit
+class AVUnpack
+{
+    public:
+        enum Packing { METHOD_A, METHOD_B }; // components from the msb with 2 padding bits at the lsb, or the reverse
+        enum Kernel { SCALAR, SSE41, AVX2, NEON };
+        struct Yuv // fixed point with 14 fractional bits, range scaling folded into the coefficients
+        {
+            int shift = 0; // samples above 8 bits are reduced to 8
+            int y0 = 16; // black level, 0 for full range
+            int cy = 0;
+            int crr = 0;
+            int cgb = 0;
+            int cgr = 0;
+            int cbb = 0;
+            int xshift = 1; // 1 when chroma is subsampled horizontally
+        };
+
+    public:
+        static void unpack10(const quint32* words, qsizetype count, Packing packing, bool swap, quint16* rgbx); // 0-65535
+        static void unpack10(const quint32* words, qsizetype count, Packing packing, bool swap, float* rgbx); // 0-1
+        static void unpack10_scalar(const quint32* words, qsizetype count, Packing packing, bool swap, quint16* rgbx);
+        static void unpack10_scalar(const quint32* words, qsizetype count, Packing packing, bool swap, float* rgbx);
+        static void yuv_argb32(const quint8* y, const quint8* cb, const quint8* cr, qsizetype count, const Yuv& yuv,
+                               quint32* argb); // one row, cb and cr are null for mono
+        static void yuv_argb32(const quint16* y, const quint16* cb, const quint16* cr, qsizetype count, const Yuv& yuv,
+                               quint32* argb);
+        static void yuv_argb32_scalar(const quint8* y, const quint8* cb, const quint8* cr, qsizetype count,
+                                      const Yuv& yuv, quint32* argb);
+        static void yuv_argb32_scalar(const quint16* y, const quint16* cb, const quint16* cr, qsizetype count,
+                                      const Yuv& yuv, quint32* argb);
+        static Kernel kernel();
+        static bool supported(Kernel kernel);
+        static void set_kernel(Kernel kernel); // falls back to the best supported kernel
+        static const char* name(Kernel kernel);
+};
@@ -0,0 +1,534 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avy4mbackend.h"
+#include "avframepool.h"
+#include "avunpack.h"
+
+#include <QFile>
+#include <QList>
+
+#include <QDebug>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+AVY4mMapping::AVY4mMapping(uchar* data, qsizetype size)
+: data(data)
+, size(size)
+{
+}
+
+AVY4mMapping::~AVY4mMapping()
+{
+    munmap(data, static_cast<size_t>(size));
+}
+
+class AVY4mBackendPrivate
+{
+    public:
+        AVY4mBackendPrivate();
+        ~AVY4mBackendPrivate();
+        bool open();
+        void close();
+        bool header(const QByteArray& line);
+        bool index();
+        qsizetype offset(qint64 frame) const;
+        void advise(qint64 frame, qint64 count);
+        void set_direction(qint64 direction);
+        qint64 readahead() const;
+        AVTime time(qint64 frame) const;
+        bool fail(AVReader::Error error, const QString& message);
+        struct Data
+        {
+            QExplicitlySharedDataPointer<AVY4mMapping> mapping;
+            AVY4mBackend::Frame layout; // planes are bound per frame
+            qsizetype planes[3] = { 0, 0, 0 }; // plane offsets from the frame data
+            AVBackend::Info info;
+            qsizetype framebytes = 0;
+            qsizetype first = 0; // offset of the first frame data
+            qsizetype stride = 0; // from frame to frame when every frame header is FRAME\n
+            QList<qsizetype> offsets; // frame data offsets when frame headers carry parameters
+            qint64 count = 0;
+            qint64 frame = 0; // next frame to read
+            qint64 previous = -1;
+            qint64 direction = 1;
+            qint64 readahead = 0; // frames, derived from frame size when 0
+            qsizetype pagesize = 4096;
+            AVFramePool pool; // converted frames, recycled once released
+            QString filename;
+            QString errormessage;
+            AVReader::Error error = AVReader::NO_ERROR;
+        };
+        Data d;
+};
+
+AVY4mBackendPrivate::AVY4mBackendPrivate()
+{
+    d.pagesize = static_cast<qsizetype>(sysconf(_SC_PAGESIZE));
+}
+
+AVY4mBackendPrivate::~AVY4mBackendPrivate()
+{
+}
+
+bool
+AVY4mBackendPrivate::fail(AVReader::Error error, const QString& message)
+{
+    d.error = error;
+    d.errormessage = message;
+    qWarning() << "warning: " << d.errormessage;
+    return false;
+}
+
+bool
+AVY4mBackendPrivate::header(const QByteArray& line)
+{
+    qint32 numerator = 0;
+    qint32 denominator = 0;
+    QByteArray colorspace = "420jpeg";
+    QByteArray interlacing = "p";
+    QByteArray aspect = "0:0";
+    AVY4mBackend::Frame& layout = d.layout;
+    const QList<QByteArray> tokens = line.split(' ');
+    for (qsizetype i = 1; i < tokens.size(); i++) {
+        const QByteArray& token = tokens[i];
+        if (token.isEmpty()) {
+            continue;
+        }
+        QByteArray value = token.mid(1);
+        switch (token[0]) {
+            case 'W':
+                layout.width = value.toInt();
+                break;
+            case 'H':
+                layout.height = value.toInt();
+                break;
+            case 'F': {
+                QList<QByteArray> rate = value.split(':');
+                if (rate.size() == 2) {
+                    numerator = rate[0].toInt();
+                    denominator = rate[1].toInt();
+                }
+                break;
+            }
+            case 'I':
+                interlacing = value;
+                break;
+            case 'A':
+                aspect = value;
+                break;
+            case 'C':
+                colorspace = value;
+                break;
+            case 'X':
+                if (value == "COLORRANGE=FULL") {
+                    layout.fullrange = true;
+                }
+                break;
+        }
+    }
+    if (layout.width <= 0 || layout.height <= 0 || numerator <= 0 || denominator <= 0) {
+        return fail(AVReader::FILE_ERROR, QString("invalid y4m header: %1").arg(QString::fromLatin1(line)));
+    }
+    layout.depth = 8;
+    QByteArray format = colorspace;
+    qsizetype p = colorspace.indexOf('p', 1);
+    if (colorspace.startsWith("mono")) {
+        layout.chroma = AVY4mBackend::MONO;
+        layout.depth = colorspace.size() > 4 ? colorspace.mid(4).toInt() : 8;
+    }
+    else {
+        if (colorspace.startsWith("420")) {
+            layout.chroma = AVY4mBackend::C420;
+        }
+        else if (colorspace.startsWith("422")) {
+            layout.chroma = AVY4mBackend::C422;
+        }
+        else if (colorspace.startsWith("444") && !colorspace.startsWith("444alpha")) {
+            layout.chroma = AVY4mBackend::C444;
+        }
+        else {
+            return fail(AVReader::FILE_ERROR, QString("unsupported y4m colorspace: %1").arg(QString::fromLatin1(colorspace)));
+        }
+        if (p > 0 && colorspace.mid(p + 1).toInt() > 0) { // 420p10, 422p12, 444p16
+            layout.depth = colorspace.mid(p + 1).toInt();
+        }
+    }
+    if (layout.depth < 8 || layout.depth > 16) {
+        return fail(AVReader::FILE_ERROR, QString("unsupported y4m bit depth: %1").arg(layout.depth));
+    }
+    layout.bt709 = layout.height > 576;
+    qsizetype bytes = layout.depth > 8 ? 2 : 1;
+    qsizetype width = layout.width;
+    qsizetype height = layout.height;
+    qsizetype chromawidth = layout.chroma == AVY4mBackend::C444 ? width : (width + 1) / 2;
+    qsizetype chromaheight = layout.chroma == AVY4mBackend::C420 ? (height + 1) / 2 : height;
+    layout.strides[0] = width * bytes;
+    if (layout.chroma == AVY4mBackend::MONO) {
+        d.framebytes = layout.strides[0] * height;
+    }
+    else {
+        layout.strides[1] = layout.strides[2] = chromawidth * bytes;
+        qsizetype luma = layout.strides[0] * height;
+        qsizetype chroma = layout.strides[1] * chromaheight;
+        d.planes[1] = luma;
+        d.planes[2] = luma + chroma;
+        d.framebytes = luma + 2 * chroma;
+    }
+    AVFps fps = AVFps::guess(static_cast<qreal>(numerator) / denominator);
+    qint32 timescale = fps.frame_quanta() * 1000;
+    if (static_cast<qint64>(fps.numerator()) * denominator != static_cast<qint64>(numerator) * fps.denominator()) {
+        fps = AVFps(numerator, denominator); // not a standard rate, ticks in the rate itself
+        timescale = numerator;
+    }
+    d.info.fps = fps;
+    d.info.start = AVTime(0, timescale, fps);
+    d.info.metadata.add_pair("media type", "y4m");
+    d.info.metadata.add_pair("colorspace", QString::fromLatin1(format));
+    d.info.metadata.add_pair("resolution", QString("%1x%2").arg(layout.width).arg(layout.height));
+    d.info.metadata.add_pair("interlacing", QString::fromLatin1(interlacing));
+    d.info.metadata.add_pair("pixel aspect", QString::fromLatin1(aspect));
+    d.info.metadata.add_pair("color range", layout.fullrange ? "full" : "limited");
+    return true;
+}
+
+bool
+AVY4mBackendPrivate::index()
+{
+    static const char frameheader[] = "FRAME";
+    const uchar* data = d.mapping->data;
+    qsizetype size = d.mapping->size;
+    // constant "FRAME\n" headers are the common case, the index is then arithmetic and open does
+    // not touch a page per frame
+    qsizetype stride = 6 + d.framebytes;
+    qsizetype payload = size - d.first;
+    if (payload > 0 && payload % stride == 0 && std::memcmp(data + d.first, "FRAME\n", 6) == 0 &&
+        std::memcmp(data + size - stride, "FRAME\n", 6) == 0) {
+        d.stride = stride;
+        d.count = payload / stride;
+        d.first += 6;
+        return true;
+    }
+    qsizetype offset = d.first;
+    d.offsets.reserve(payload / stride + 1);
+    while (offset + 5 < size && std::memcmp(data + offset, frameheader, 5) == 0) {
+        const void* newline = std::memchr(data + offset, '\n', static_cast<size_t>(qMin<qsizetype>(size - offset, 1024)));
+        if (!newline) {
+            break;
+        }
+        qsizetype start = static_cast<const uchar*>(newline) - data + 1;
+        if (start + d.framebytes > size) {
+            qWarning() << "warning: " << "truncated y4m frame at offset:" << offset;
+            break;
+        }
+        d.offsets.append(start);
+        offset = start + d.framebytes;
+    }
+    d.offsets.squeeze();
+    d.count = d.offsets.size();
+    return d.count > 0;
+}
+
+bool
+AVY4mBackendPrivate::open()
+{
+    QByteArray path = QFile::encodeName(d.filename);
+    int fd = ::open(path.constData(), O_RDONLY);
+    if (fd < 0) {
+        return fail(AVReader::FILE_ERROR, QString("unable to open file: %1: %2").arg(d.filename).arg(std::strerror(errno)));
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return fail(AVReader::FILE_ERROR, QString("unable to stat file: %1").arg(d.filename));
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file referenced
+    if (data == MAP_FAILED) {
+        return fail(AVReader::API_ERROR, QString("unable to map file: %1: %2").arg(d.filename).arg(std::strerror(errno)));
+    }
+    d.mapping = new AVY4mMapping(static_cast<uchar*>(data), static_cast<qsizetype>(info.st_size));
+    const char* begin = static_cast<const char*>(data);
+    const void* newline = std::memchr(begin, '\n', static_cast<size_t>(qMin<qsizetype>(d.mapping->size, 4096)));
+    if (!newline || std::memcmp(begin, "YUV4MPEG2 ", qMin<qsizetype>(d.mapping->size, 10)) != 0) {
+        return fail(AVReader::FILE_ERROR, QString("missing y4m stream header in file: %1").arg(d.filename));
+    }
+    QByteArray line(begin, static_cast<const char*>(newline) - begin);
+    if (!header(line)) {
+        return false;
+    }
+    d.first = line.size() + 1;
+    if (!index()) {
+        return fail(AVReader::FILE_ERROR, QString("no y4m frames found in file: %1").arg(d.filename));
+    }
+    AVTime start = d.info.start;
+    d.info.range = AVTimeRange(start, AVTime(start, start.ticks(d.count)));
+    d.info.metadata.add_pair("frames", QString::number(d.count));
+    d.frame = 0;
+    d.previous = -1;
+    d.direction = 1;
+    madvise(d.mapping->data, static_cast<size_t>(d.mapping->size), MADV_SEQUENTIAL);
+    advise(0, readahead());
+    return true;
+}
+
+void
+AVY4mBackendPrivate::close()
+{
+    d.mapping.reset();
+    d.layout = AVY4mBackend::Frame();
+    d.planes[1] = d.planes[2] = 0;
+    d.info = AVBackend::Info();
+    d.framebytes = 0;
+    d.first = 0;
+    d.stride = 0;
+    d.offsets.clear();
+    d.count = 0;
+    d.frame = 0;
+    d.previous = -1;
+    d.direction = 1;
+    d.errormessage = QString();
+    d.error = AVReader::NO_ERROR;
+}
+
+qsizetype
+AVY4mBackendPrivate::offset(qint64 frame) const
+{
+    return d.stride ? d.first + frame * d.stride : d.offsets[frame];
+}
+
+void
+AVY4mBackendPrivate::advise(qint64 frame, qint64 count)
+{
+    // pages of the next frames in the playback direction are read into the page cache ahead of use
+    qint64 first = count > 0 ? frame : frame + count + 1;
+    qint64 last = count > 0 ? frame + count - 1 : frame;
+    first = qBound(qint64(0), first, d.count - 1);
+    last = qBound(qint64(0), last, d.count - 1);
+    qsizetype begin = offset(first) & ~(d.pagesize - 1);
+    qsizetype end = offset(last) + d.framebytes;
+    madvise(d.mapping->data + begin, static_cast<size_t>(end - begin), MADV_WILLNEED);
+}
+
+void
+AVY4mBackendPrivate::set_direction(qint64 direction)
+{
+    if (direction != d.direction) {
+        madvise(d.mapping->data, static_cast<size_t>(d.mapping->size), direction > 0 ? MADV_SEQUENTIAL : MADV_RANDOM);
+        d.direction = direction;
+    }
+}
+
+qint64
+AVY4mBackendPrivate::readahead() const
+{
+    if (d.readahead > 0 || d.framebytes == 0) {
+        return d.readahead;
+    }
+    return qBound(qint64(2), qint64(256 << 20) / d.framebytes, qint64(32)); // about 256 mb in flight
+}
+
+AVTime
+AVY4mBackendPrivate::time(qint64 frame) const
+{
+    return AVTime(d.info.start, d.info.start.ticks(frame));
+}
+
+AVY4mBackend::AVY4mBackend()
+: p(new AVY4mBackendPrivate())
+{
+}
+
+AVY4mBackend::~AVY4mBackend()
+{
+}
+
+QString
+AVY4mBackend::name() const
+{
+    return "y4m";
+}
+
+bool
+AVY4mBackend::probe(const QString& filename) const
+{
+    QFile file(filename);
+    return file.open(QIODevice::ReadOnly) && file.read(10) == "YUV4MPEG2 ";
+}
+
+bool
+AVY4mBackend::open(const QString& filename)
+{
+    p->close();
+    p->d.filename = filename;
+    return p->open();
+}
+
+void
+AVY4mBackend::close()
+{
+    p->close();
+}
+
+bool
+AVY4mBackend::seek(const AVTime& time)
+{
+    if (!p->d.mapping) {
+        return p->fail(AVReader::API_ERROR, "unable to seek, no file is open");
+    }
+    qint64 frame = qBound(qint64(0), time.frames(), p->d.count - 1);
+    qint64 direction = frame < p->d.previous ? -1 : 1; // stepping backwards reads ahead backwards
+    p->set_direction(direction);
+    if (frame != p->d.previous + 1) {
+        p->advise(frame, readahead() * direction);
+    }
+    p->d.frame = frame;
+    return true;
+}
+
+bool
+AVY4mBackend::read(QImage& image, AVTime& time)
+{
+    if (p->d.frame >= p->d.count) {
+        return p->fail(AVReader::API_ERROR, "unable to read frame past the end of the file");
+    }
+    AVY4mBackend::Frame view = frame(p->d.frame);
+    QSize size(view.width, view.height);
+    if (image.size() != size || image.format() != QImage::Format_ARGB32 || !image.isDetached()) {
+        image = p->d.pool.image(size, QImage::Format_ARGB32);
+    }
+    convert(view, image);
+    time = view.time;
+    return drop(time);
+}
+
+bool
+AVY4mBackend::drop(AVTime& time)
+{
+    if (p->d.frame >= p->d.count) {
+        return p->fail(AVReader::API_ERROR, "unable to drop frame past the end of the file");
+    }
+    qint64 frame = p->d.frame++;
+    if (frame == p->d.previous + 1 && p->d.direction < 0) { // forward again after a backward seek or loop
+        p->set_direction(1);
+        p->advise(frame, readahead());
+    }
+    qint64 ahead = frame + readahead() * p->d.direction;
+    if (ahead >= 0 && ahead < p->d.count) {
+        p->advise(ahead, p->d.direction);
+    }
+    p->d.previous = frame;
+    time = p->time(frame);
+    return true;
+}
+
+AVBackend::Info
+AVY4mBackend::info() const
+{
+    return p->d.info;
+}
+
+AVReader::Error
+AVY4mBackend::error() const
+{
+    return p->d.error;
+}
+
+QString
+AVY4mBackend::error_message() const
+{
+    return p->d.errormessage;
+}
+
+AVY4mBackend::Frame
+AVY4mBackend::frame(qint64 frame) const
+{
+    Q_ASSERT("frame out of range" && frame >= 0 && frame < p->d.count);
+
+    AVY4mBackend::Frame view = p->d.layout;
+    const uchar* start = p->d.mapping->data + p->offset(frame);
+    view.planes[0] = start;
+    if (view.chroma != MONO) {
+        view.planes[1] = start + p->d.planes[1];
+        view.planes[2] = start + p->d.planes[2];
+    }
+    view.time = p->time(frame);
+    view.mapping = p->d.mapping;
+    return view;
+}
+
+qint64
+AVY4mBackend::count() const
+{
+    return p->d.count;
+}
+
+qsizetype
+AVY4mBackend::frame_bytes() const
+{
+    return p->d.framebytes;
+}
+
+qint64
+AVY4mBackend::readahead() const
+{
+    return p->readahead();
+}
+
+void
+AVY4mBackend::set_readahead(qint64 frames)
+{
+    p->d.readahead = frames;
+}
+
+namespace {
+template<typename T>
+void
+convert_rows(const AVY4mBackend::Frame& frame, QImage& image)
+{
+    // fixed point with 14 fractional bits, limited range scaling folded into the coefficients
+    const qreal yscale = frame.fullrange ? 1.0 : 255.0 / 219.0;
+    const qreal cscale = frame.fullrange ? 1.0 : 255.0 / 224.0;
+    const qreal kr = frame.bt709 ? 1.5748 : 1.402;
+    const qreal kgb = frame.bt709 ? 0.187324 : 0.344136;
+    const qreal kgr = frame.bt709 ? 0.468124 : 0.714136;
+    const qreal kb = frame.bt709 ? 1.8556 : 1.772;
+    AVUnpack::Yuv yuv;
+    yuv.shift = frame.depth - 8;
+    yuv.y0 = frame.fullrange ? 0 : 16;
+    yuv.cy = qRound(yscale * 16384);
+    yuv.crr = qRound(kr * cscale * 16384);
+    yuv.cgb = qRound(kgb * cscale * 16384);
+    yuv.cgr = qRound(kgr * cscale * 16384);
+    yuv.cbb = qRound(kb * cscale * 16384);
+    yuv.xshift = frame.chroma == AVY4mBackend::C444 ? 0 : 1;
+    const bool mono = frame.chroma == AVY4mBackend::MONO;
+    const int yshift = frame.chroma == AVY4mBackend::C420 ? 1 : 0;
+    for (int row = 0; row < frame.height; row++) { // simd kernels from AVUnpack, selected at runtime
+        const T* luma = reinterpret_cast<const T*>(frame.planes[0] + row * frame.strides[0]);
+        const T* cb = mono ? nullptr : reinterpret_cast<const T*>(frame.planes[1] + (row >> yshift) * frame.strides[1]);
+        const T* cr = mono ? nullptr : reinterpret_cast<const T*>(frame.planes[2] + (row >> yshift) * frame.strides[2]);
+        AVUnpack::yuv_argb32(luma, cb, cr, frame.width, yuv, reinterpret_cast<quint32*>(image.scanLine(row)));
+    }
+}
+}
+
+void
+AVY4mBackend::convert(const AVY4mBackend::Frame& frame, QImage& image)
+{
+    if (image.width() != frame.width || image.height() != frame.height || image.format() != QImage::Format_ARGB32 ||
+        !image.isDetached()) {
+        image = QImage(frame.width, frame.height, QImage::Format_ARGB32);
+    }
+    if (frame.depth > 8) { // 16-bit little-endian samples, native on every supported platform
+        convert_rows<quint16>(frame, image);
+    }
+    else {
+        convert_rows<quint8>(frame, image);
+    }
+}
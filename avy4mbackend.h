@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#pragma once
+
+#include "avbackend.h"
+
+#include <QAtomicInt>
+#include <QExplicitlySharedDataPointer>
+#include <QScopedPointer>
+
+class AVY4mMapping
+{
+    public:
+        AVY4mMapping(uchar* data, qsizetype size);
+        ~AVY4mMapping(); // unmapped with the last frame view
+        uchar* data;
+        qsizetype size;
+        QAtomicInt ref;
+};
+
+class AVY4mBackendPrivate;
+class AVY4mBackend : public AVBackend {
+    public:
+        enum Chroma { C420, C422, C444, MONO };
+        struct Frame
+        {
+            const uchar* planes[3] = { nullptr, nullptr, nullptr }; // y, cb, cr, views into the mapping
+            qsizetype strides[3] = { 0, 0, 0 }; // bytes per row
+            int width = 0;
+            int height = 0;
+            int depth = 8; // bits per sample, samples above 8 bits are 16-bit little-endian
+            Chroma chroma = C420;
+            bool fullrange = false; // XCOLORRANGE=FULL, limited range otherwise
+            bool bt709 = false; // hd sizes use BT.709, sd sizes BT.601
+            AVTime time;
+            QExplicitlySharedDataPointer<AVY4mMapping> mapping; // keeps the planes valid after close
+        };
+
+    public:
+        AVY4mBackend();
+        virtual ~AVY4mBackend();
+        QString name() const override;
+        bool probe(const QString& filename) const override;
+        bool open(const QString& filename) override;
+        void close() override;
+        bool seek(const AVTime& time) override;
+        bool read(QImage& image, AVTime& time) override;
+        bool drop(AVTime& time) override;
+        AVBackend::Info info() const override;
+        AVReader::Error error() const override;
+        QString error_message() const override;
+        AVY4mBackend::Frame frame(qint64 frame) const; // zero-copy view of a frame
+        qint64 count() const;
+        qsizetype frame_bytes() const;
+        qint64 readahead() const;
+        void set_readahead(qint64 frames);
+
+        static void convert(const AVY4mBackend::Frame& frame, QImage& image); // to ARGB32, BT.601 or BT.709
+
+    private:
+        QScopedPointer<AVY4mBackendPrivate> p;
+};
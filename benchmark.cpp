@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avfps.h"
+#include "avsmptetime.h"
+#include "avtime.h"
+#include "avtimerange.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+#if defined(Q_OS_MACOS)
+#include <malloc/malloc.h>
+#include <mach/mach.h>
+#endif
+
+// microbenchmarks for the time and timecode core, reports ns/op and heap allocations/op. allocations are
+// counted at the malloc level where it can be hooked, Qt containers allocate with malloc, not operator new
+
+namespace {
+    std::atomic<qint64> allocations { 0 };
+}
+
+#if defined(Q_OS_MACOS)
+namespace {
+    void* (*zone_malloc)(malloc_zone_t* zone, size_t size) = nullptr;
+    void* (*zone_calloc)(malloc_zone_t* zone, size_t count, size_t size) = nullptr;
+    void* (*zone_realloc)(malloc_zone_t* zone, void* pointer, size_t size) = nullptr;
+
+    void* counting_malloc(malloc_zone_t* zone, size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return zone_malloc(zone, size);
+    }
+    void* counting_calloc(malloc_zone_t* zone, size_t count, size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return zone_calloc(zone, count, size);
+    }
+    void* counting_realloc(malloc_zone_t* zone, void* pointer, size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return zone_realloc(zone, pointer, size);
+    }
+}
+
+void
+install_hook()
+{
+    malloc_zone_t* zone = malloc_default_zone();
+    vm_protect(mach_task_self(), reinterpret_cast<vm_address_t>(zone), sizeof(malloc_zone_t), 0, VM_PROT_READ | VM_PROT_WRITE);
+    zone_malloc = zone->malloc;
+    zone_calloc = zone->calloc;
+    zone_realloc = zone->realloc;
+    zone->malloc = counting_malloc;
+    zone->calloc = counting_calloc;
+    zone->realloc = counting_realloc;
+    vm_protect(mach_task_self(), reinterpret_cast<vm_address_t>(zone), sizeof(malloc_zone_t), 0, VM_PROT_READ);
+}
+#elif defined(__GLIBC__)
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* pointer, size_t size);
+
+    void* malloc(size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+    void* calloc(size_t count, size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(count, size);
+    }
+    void* realloc(void* pointer, size_t size) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(pointer, size);
+    }
+}
+
+void
+install_hook()
+{
+}
+#else
+void*
+operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void
+operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void
+install_hook() // operator new only, container allocations are not counted
+{
+}
+#endif
+
+class Benchmark
+{
+    public:
+        Benchmark(const QString& filter)
+        : filter(filter)
+        {
+        }
+        template <typename Function>
+        void run(const char* name, qint64 iterations, Function&& function) {
+            if (!filter.isEmpty() && !QString(name).contains(filter)) {
+                return;
+            }
+            qint64 checksum = 0;
+            for (qint64 i = 0; i < iterations / 10; i++) { // warm caches and lazy statics
+                checksum += function(i);
+            }
+            QElapsedTimer timer;
+            qint64 start = allocations.load(std::memory_order_relaxed);
+            timer.start();
+            for (qint64 i = 0; i < iterations; i++) {
+                checksum += function(i);
+            }
+            qreal elapsed = timer.nsecsElapsed();
+            qint64 count = allocations.load(std::memory_order_relaxed) - start;
+            sink += checksum;
+            std::cout << std::left << std::setw(32) << name << std::right
+                      << std::setw(12) << std::fixed << std::setprecision(2) << elapsed / iterations << " ns/op"
+                      << std::setw(12) << std::setprecision(2) << static_cast<qreal>(count) / iterations << " allocs/op"
+                      << std::endl;
+        }
+        QString filter;
+        volatile qint64 sink = 0;
+};
+
+int
+main(int argc, char* argv[])
+{
+    install_hook();
+    Benchmark benchmark(argc > 1 ? QString(argv[1]) : QString());
+    const qint64 iterations = 1000000;
+
+    AVFps fps = AVFps::fps_29_97();
+    AVTime time(qint64(1000), fps);
+    AVTime time_30000(qint64(90000) * 1001, 30000, fps);
+    AVTimeRange range(AVTime(qint64(0), fps), AVTime(qint64(24 * 60 * 60), fps));
+    QList<AVFps> rates = { AVFps::fps_23_976(), AVFps::fps_25(), AVFps::fps_29_97(), AVFps::fps_59_94() };
+    QList<qreal> guesses = { 23.976, 24.0, 25.0, 29.97, 30.0, 47.952, 50.0, 59.94, 60.0, 12.5 };
+
+    std::cout << "time core benchmark, " << iterations << " iterations" << std::endl;
+    benchmark.run("AVTime(frame, fps)", iterations, [&](qint64 i) {
+        return AVTime(i, fps).ticks();
+    });
+    benchmark.run("AVTime copy", iterations, [&](qint64 i) {
+        AVTime copy(time);
+        copy.set_ticks(copy.ticks() + i);
+        return copy.ticks();
+    });
+    benchmark.run("AVTime::frames", iterations, [&](qint64 i) {
+        return AVTime(time, i * 1001).frames();
+    });
+    benchmark.run("AVTime::convert(fps)", iterations, [&](qint64 i) {
+        return AVTime::convert(AVTime(time, i * 1001), rates[i & 3]).ticks();
+    });
+    benchmark.run("AVTime::convert(timescale)", iterations, [&](qint64 i) {
+        return AVTime::convert(AVTime(time_30000, i * 1001), 90000).ticks();
+    });
+    benchmark.run("AVTimeRange::bound(loop)", iterations, [&](qint64 i) {
+        return range.bound(AVTime(time, i * 7919), true).ticks();
+    });
+    benchmark.run("AVTimeRange::convert", iterations, [&](qint64 i) {
+        return AVTimeRange::convert(range, rates[i & 3]).duration().ticks();
+    });
+    benchmark.run("AVFps::guess", iterations, [&](qint64 i) {
+        return AVFps::guess(guesses[i % guesses.size()]).numerator();
+    });
+    benchmark.run("AVFps::convert", iterations, [&](qint64 i) {
+        return AVFps::convert(i, fps, AVFps::fps_59_94());
+    });
+    benchmark.run("AVSmpteTime(time)", iterations, [&](qint64 i) {
+        return AVSmpteTime(AVTime(i, fps)).frame();
+    });
+    benchmark.run("AVSmpteTime copy", iterations, [&](qint64 i) {
+        static AVSmpteTime smpte(time);
+        AVSmpteTime copy(smpte);
+        return copy.frame() + i;
+    });
+    benchmark.run("AVSmpteTime::set_time", iterations, [&](qint64 i) {
+        static AVSmpteTime smpte(time);
+        smpte.set_time(AVTime(i, fps)); // update() of the label
+        return qint64(smpte.frames());
+    });
+    benchmark.run("AVSmpteTime::operator++", iterations, [&](qint64) {
+        static AVSmpteTime smpte(time);
+        ++smpte;
+        return qint64(smpte.frames());
+    });
+    benchmark.run("AVSmpteTime::to_string", iterations, [&](qint64 i) {
+        static AVSmpteTime smpte(time);
+        smpte.advance(1);
+        return smpte.to_string().size() + i;
+    });
+    benchmark.run("AVSmpteTime::to_chars", iterations, [&](qint64 i) {
+        char buffer[AVSmpteTime::max_chars];
+        return AVSmpteTime::to_chars(AVTime(i, fps), buffer, sizeof(buffer));
+    });
+    benchmark.run("AVSmpteTime::convert", iterations, [&](qint64 i) {
+        return AVSmpteTime::convert(i, fps, true);
+    });
+    benchmark.run("AVSmpteTime::parse", iterations, [&](qint64 i) {
+        qint64 frame = 0;
+        AVSmpteTime::parse("01:02:03;04", fps, frame);
+        return frame + i;
+    });
+    benchmark.run("AVSmpteWord(frame, fps)", iterations, [&](qint64 i) {
+        return qint64(AVSmpteWord(i, fps).bits());
+    });
+    return 0;
+}
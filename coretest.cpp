@@ -0,0 +1,1104 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avclock.h"
+#include "avfps.h"
+#include "avhistogram.h"
+#include "avltc.h"
+#include "avmath.h"
+#include "avrate.h"
+#include "avrealtime.h"
+#include "avsmptetime.h"
+#include "avtime.h"
+#include "avtimebatch.h"
+#include "avtimerange.h"
+#include "avtimerangeset.h"
+#include "avtimestamps.h"
+#include "avtimer.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QtEndian>
+
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+// time, rate, timecode, range and pacing types without a backend, the realtime measurements against
+// the host scheduler stay in test.cpp. built with QT_FORCE_ASSERTS so a failed check aborts in release
+// builds as well
+
+void
+test_time() {
+    qDebug() << "Testing time";
+    
+    AVTime time;
+    time.set_ticks(12000);
+    time.set_timescale(24000);
+    time.set_fps(AVFps::fps_24());
+    Q_ASSERT("ticks per frame" && time.tpf() == 1000);
+    Q_ASSERT("ticks to frame" && time.frames() == 12);
+    Q_ASSERT("frame to ticks" && time.ticks(12) == 12000);
+    
+    qDebug() << "ticks per frame: " << time.tpf();
+    qDebug() << "ticks frames: " << time.frames();
+    qDebug() << "frame to ticks: " << time.ticks(12);
+    
+    time.set_ticks(16016);
+    time.set_timescale(30000);
+    time.set_fps(AVFps::fps_29_97());
+    Q_ASSERT("ticks to frame" && time.frames() == 16);
+    
+    qDebug() << "ticks frames: " << time.frames();
+    
+    time = AVTime::convert(time, 24000);
+    Q_ASSERT("ticks to frame" && time.frames() == 16);
+    Q_ASSERT("ticks to frame" && time.frame(time.ticks()) == 16);
+    Q_ASSERT("ticks align" && time.align(time.ticks()) == time.ticks());
+
+    qDebug() << "ticks: " << time.ticks();
+    qDebug() << "ticks frames: " << time.frames();
+    
+    time = AVTime::convert(time, 30000);
+    qDebug() << "ticks: " << time.ticks();
+    Q_ASSERT("ticks" && time.ticks() == 16016);
+    
+    time = AVTime(time.ticks() + time.ticks(1), time.timescale(), time.fps());
+    Q_ASSERT("ticks align" && time.align(time.ticks()) == time.ticks());
+    
+    time.set_ticks(8677230);
+    time.set_timescale(90000);
+    time.set_fps(AVFps::fps_23_976());
+    
+    qDebug() << "frames: " << time.frames();
+    qDebug() << "ticks: " << time.ticks(time.frames() + 1);
+    
+    time.set_ticks(time.ticks(time.frames() + 1));
+    qDebug() << "frames: " << time.frames();
+
+    AVTime hours(qint64(90000) * 60 * 60 * 12, 90000, AVFps::fps_23_976()); // 12 hours, 90 kHz
+    AVTime converted = AVTime::convert(hours, 1000000000); // nanoseconds, overflows 64-bit intermediates
+    Q_ASSERT("convert 90 kHz to nanoseconds" && converted.ticks() == qint64(1000000000) * 60 * 60 * 12);
+    Q_ASSERT("cross timescale equality" && converted == hours);
+    Q_ASSERT("cross timescale hash" && qHash(converted) == qHash(hours));
+    Q_ASSERT("normalized" && AVTime(2002, 48000, AVFps::fps_23_976()).normalized().timescale() == 24000);
+
+    AVTime before(1001, 24000, AVFps::fps_23_976());
+    AVTime after(3004, 72000, AVFps::fps_23_976());
+    Q_ASSERT("cross timescale less than" && before < after && !(after < before));
+
+    AVFps fps1000(1000, 1);
+    time = AVTime(0, 48000, fps1000);
+    for (qint64 frame = 0; frame < 1000 * 60 * 10; frame++) {
+        Q_ASSERT("1000 fps frame round trip" && time.frame(time.ticks(frame)) == frame);
+    }
+    AVFps fps240(240000, 1001);
+    time = AVTime(0, 90000, fps240);
+    for (qint64 frame = 0; frame < 240 * 60 * 10; frame++) {
+        Q_ASSERT("239.76 fps frame round trip" && time.frame(time.ticks(frame)) == frame);
+    }
+}
+
+void test_timerange() {
+    AVTimeRange timerange;
+    timerange.set_start(AVTime(12000, 24000, AVFps::fps_24()));
+    AVTime duration = AVTime::convert(AVTime(384000, 48000, AVFps::fps_24()), timerange.start().timescale());
+    timerange.set_duration(duration);
+    Q_ASSERT("convert timescale" && duration.ticks() == 192000);
+    Q_ASSERT("end ticks" && timerange.end().ticks() == 204000);
+    
+    qDebug() << "timerange: " << timerange.to_string();
+}
+
+void test_fps() {
+    qDebug() << "Testing fps";
+    
+    Q_ASSERT("24 fps" &&  AVFps::fps_24() == AVFps(24, 1));
+    qDebug() << "fps 24: " << AVFps::fps_24().seconds();
+    qDebug() << "fps 24: " << AVFps(24, 1).seconds();
+    qDebug() << "fps 24: " << 1/24.0;
+    
+    AVTime time;
+    time.set_ticks(24000 * 100); // typical ticks, 100 seconds
+    time.set_timescale(24000);
+    time.set_fps(AVFps::fps_24());
+    qint64 ticks;
+    
+    AVFps guess23_97 = AVFps::guess(23.976);
+    Q_ASSERT("23.976 fps has drop frames" && guess23_97.drop_frame());
+    qDebug() << "fps 23.976: " << guess23_97;
+    
+    AVFps guess24 = AVFps::guess(24);
+    Q_ASSERT("24 fps is standard" && !guess24.drop_frame());
+    qDebug() << "fps 24: " << guess24;
+    
+    AVFps guess10 = AVFps::guess(10);
+    Q_ASSERT("10 fps is standard" && !guess10.drop_frame());
+    qDebug() << "fps 10: " << guess10;
+    
+    AVFps fps23_97 = AVFps::fps_23_976();
+    ticks = AVTime(time, fps23_97).ticks(1);
+    Q_ASSERT("23.97 fps ticks" &&  ticks == 1001);
+    qDebug() << "ticks 23_97: " << ticks;
+    
+    AVFps fps24 = AVFps::fps_24();
+    ticks = AVTime(time, fps24).ticks(1);
+    Q_ASSERT("24 fps ticks" &&  ticks == 1000);
+    qDebug() << "ticks 24: " << ticks;
+    
+    AVFps fps29_97 = AVFps::fps_29_97();
+    ticks = AVTime(time, fps29_97).ticks(2);
+    qDebug() << "ticks 29_97: " << ticks;
+    Q_ASSERT("29.97 fps ticks" &&  ticks == 1602);
+    
+    ticks = AVTime(time, fps29_97).ticks(5);
+    qDebug() << "ticks 29_97: " << ticks;
+    Q_ASSERT("29.97 fps ticks" &&  ticks == 4004);
+    
+    static_assert(AVRate<30000, 1001, true>::frames_10minutes == 17982, "29.97 drop frame has 17982 frames per 10 minutes");
+    static_assert(AVRate<60000, 1001, true>::drop_frames == 4, "59.94 drop frame drops 4 labels");
+    static_assert(AVRate<24000, 1001, false>::ticks<24000>(1) == 1001, "23.976 has 1001 ticks per frame");
+    
+    const qint32 timescales[] = { 600, 1000, 24000, 25000, 30000, 48000, 50000, 60000, 90000 };
+    for (const AVFps& standard : AVRates::standards) {
+        for (const AVFps& fps : { standard, AVFps(standard.numerator(), standard.denominator(), !standard.drop_frame()) }) {
+            Q_ASSERT("frame quanta matches" && fps.frame_quanta() == AVMath::muldiv(1, fps.numerator(), fps.denominator()));
+            for (qint32 timescale : timescales) {
+                AVTime time(qint64(0), timescale, fps);
+                for (int i = 0; i < 10000; i++) {
+                    qint64 value = QRandomGenerator::global()->bounded(2000000000) - 1000000000;
+                    Q_ASSERT("ticks matches generic" &&
+                             time.ticks(value) == AVMath::muldiv(value, static_cast<qint64>(timescale) * fps.denominator(), fps.numerator()));
+                    Q_ASSERT("frame matches generic" &&
+                             time.frame(value) == AVMath::muldiv(value, fps.numerator(), static_cast<qint64>(timescale) * fps.denominator()));
+                }
+            }
+        }
+    }
+    {
+        AVTime time(qint64(0), 24000, AVFps::fps_29_97());
+        AVTime generic(qint64(0), 24000, AVFps(60000, 2002, true)); // same rate, not a standard descriptor
+        const qint64 count = 10000000;
+        qint64 checksum = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (qint64 value = 0; value < count; value++) {
+            checksum += time.frame(value * 7);
+        }
+        qreal specialized = timer.nsecsElapsed();
+        timer.restart();
+        for (qint64 value = 0; value < count; value++) {
+            checksum -= generic.frame(value * 7);
+        }
+        qreal fallback = timer.nsecsElapsed();
+        Q_ASSERT("checksum is valid" && checksum == 0);
+        qDebug() << "fps frame: " << specialized / count << "ns/frame, generic:" << fallback / count << "ns/frame";
+    }
+}
+
+void test_timebatch() {
+    qDebug() << "Testing time batch";
+
+    const qsizetype count = 1000000;
+    QVector<qint64> frames(count);
+    QVector<qint64> ticks(count);
+    QVector<qint64> result(count);
+    for (qsizetype i = 0; i < count; i++) {
+        frames[i] = QRandomGenerator::global()->bounded(24 * 60 * 60 * 24) - 24 * 60 * 60; // -1h to 23h
+    }
+    frames[0] = std::numeric_limits<qint64>::max() / 1000000; // outside the vector kernel range
+    const QList<AVTime> times = {
+        AVTime(0, 24000, AVFps::fps_24()),
+        AVTime(0, 24000, AVFps::fps_23_976()),
+        AVTime(0, 30000, AVFps::fps_29_97()),
+        AVTime(0, 90000, AVFps::fps_59_94()),
+        AVTime(0, 48000, AVFps(1000, 1))
+    };
+    qDebug() << "kernel: " << AVTimeBatch::kernel();
+    for (const AVTime& time : times) {
+        QElapsedTimer timer;
+        timer.start();
+        AVTimeBatch::ticks(time, frames, ticks);
+        qreal batchticks = timer.nsecsElapsed();
+        timer.restart();
+        for (qsizetype i = 0; i < count; i++) {
+            result[i] = time.ticks(frames[i]);
+        }
+        qreal scalarticks = timer.nsecsElapsed();
+        for (qsizetype i = 0; i < count; i++) {
+            Q_ASSERT("batch ticks does not match scalar" && ticks[i] == result[i]);
+        }
+        for (qsizetype i = 0; i < count; i++) {
+            ticks[i] += QRandomGenerator::global()->bounded(2000) - 1000; // unaligned ticks
+        }
+        timer.restart();
+        AVTimeBatch::frames(time, ticks, result);
+        qreal batchframes = timer.nsecsElapsed();
+        timer.restart();
+        for (qsizetype i = 0; i < count; i++) {
+            Q_ASSERT("batch frames does not match scalar" && result[i] == time.frame(ticks[i]));
+        }
+        AVTimeBatch::align(time, ticks, result);
+        for (qsizetype i = 0; i < count; i++) {
+            Q_ASSERT("batch align does not match scalar" && result[i] == time.align(ticks[i]));
+        }
+        AVTimeRange range(AVTime(time.ticks(100), time.timescale(), time.fps()), AVTime(time.ticks(2400), time.timescale(), time.fps()));
+        for (bool loop : { false, true }) {
+            AVTimeBatch::bound(range, ticks, result, loop);
+            for (qsizetype i = 0; i < count; i++) {
+                Q_ASSERT("batch bound does not match scalar" && result[i] == range.bound(AVTime(time, ticks[i]), loop).ticks());
+            }
+        }
+        qDebug() << "fps:" << time.fps().real() << "timescale:" << time.timescale()
+                 << "| ticks:" << count / (batchticks / 1e9) / 1e6 << "M/s"
+                 << "scalar:" << count / (scalarticks / 1e9) / 1e6 << "M/s"
+                 << "| frames:" << count / (batchframes / 1e9) / 1e6 << "M/s";
+    }
+}
+
+qint64 baseline_convert(qint64 frame, const AVFps& fps) {
+    // frame to label as AVSmpteTime::convert was before the formatter, two drops per minute
+    if (!fps.drop_frame()) {
+        return frame;
+    }
+    qint64 framemin = fps.frame_quanta() * 60;
+    qint64 frame10min = framemin * 10 - 9 * 2;
+    qint64 adjust = (frame / frame10min) * (9 * 2);
+    qint64 remaining = frame % frame10min;
+    if (remaining >= framemin) {
+        adjust += (remaining / framemin) * 2;
+    }
+    return frame + adjust;
+}
+
+QString baseline_string(qint64 frame, const AVFps& fps) {
+    // label fields formatted with QString::arg as AVSmpteTime::to_string was before the formatter
+    qint64 framequanta = fps.frame_quanta();
+    qint64 label = baseline_convert(qAbs(frame), fps);
+    qint64 seconds = label / framequanta;
+    return QString(fps.drop_frame() ? "%1%2:%3:%4.%5" : "%1%2:%3:%4:%5")
+        .arg(frame < 0 ? "-" : "")
+        .arg(seconds / 3600 % 24, 2, 10, QChar('0'))
+        .arg(seconds / 60 % 60, 2, 10, QChar('0'))
+        .arg(seconds % 60, 2, 10, QChar('0'))
+        .arg(label % framequanta, 2, 10, QChar('0'));
+}
+
+void test_smpte() {
+    qDebug() << "Testing SMPTE";
+    
+    AVFps fps_24 = AVFps::fps_24();
+    qint64 frame = 86496; // typical timecode, 01:00:04:00, 24 fps
+    AVTime time(frame, fps_24);
+    Q_ASSERT("86496 frames is 3604" && qFuzzyCompare(time.seconds(), 3604));
+    qDebug() << "time: " << time.seconds();
+    
+    qint64 frame_fps = frame;
+    AVSmpteTime smpte(AVTime(frame_fps, AVFps::fps_24()));
+    Q_ASSERT("smpte is 01:00:04:00" && smpte.to_string() == "01:00:04:00");
+    
+    frame_fps = AVSmpteTime::convert(frame_fps, AVFps::fps_24(), AVFps::fps_50());
+    smpte = AVSmpteTime(AVTime(frame_fps, AVFps::fps_50()));
+    Q_ASSERT("smpte is 01:00:04:00" && smpte.to_string() == "01:00:04:00");
+    
+    frame_fps = AVSmpteTime::convert(frame_fps, AVFps::fps_50(), AVFps::fps_25());
+    smpte = AVSmpteTime(AVTime(frame_fps, AVFps::fps_25()));
+    Q_ASSERT("smpte is 01:00:04:00" && smpte.to_string() == "01:00:04:00");
+    
+    frame_fps = AVSmpteTime::convert(frame_fps, AVFps::fps_25(), AVFps::fps_50());
+    smpte = AVSmpteTime(AVTime(frame_fps, AVFps::fps_50()));
+    Q_ASSERT("smpte is 01:00:04:00" && smpte.to_string() == "01:00:04:00");
+    
+    frame_fps = AVSmpteTime::convert(frame_fps, AVFps::fps_50(), AVFps::fps_23_976());
+    smpte = AVSmpteTime(AVTime(frame_fps, AVFps::fps_23_976()));
+    Q_ASSERT("smpte is 01:00:04:00" && smpte.to_string() == "01:00:04.00");
+    
+    frame_fps = AVSmpteTime::convert(frame_fps, AVFps::fps_23_976(), AVFps::fps_50());
+    smpte = AVSmpteTime(AVTime(frame_fps, AVFps::fps_50()));
+    Q_ASSERT("smpte is 01:00:04:00" && smpte.to_string() == "01:00:04:00");
+    
+    frame_fps = AVSmpteTime::convert(frame_fps, AVFps::fps_50(), AVFps::fps_24());
+    smpte = AVSmpteTime(AVTime(frame_fps, AVFps::fps_24()));
+    Q_ASSERT("smpte is 01:00:04:00" && smpte.to_string() == "01:00:04:00");
+
+    qint64 frame_df_23_976 = AVSmpteTime::convert(frame, AVFps::fps_23_976());
+    qint64 frame_24 = AVSmpteTime::convert(frame_df_23_976, AVFps::fps_23_976(), true); // inverse
+    Q_ASSERT("86496 dropframe is 86388" && frame_df_23_976 == 86388);
+    Q_ASSERT("dropframe inverse does not match" && frame == frame_24);
+    
+    smpte = AVSmpteTime(time);
+    Q_ASSERT("smpte is 01:00:04:00" && smpte.to_string() == "01:00:04:00");
+    qDebug() << "smpte 24 fps: " << smpte.to_string();
+    
+    qint64 frame_30 = AVFps::convert(frame, AVFps::fps_24(), AVFps::fps_30());
+    smpte = AVSmpteTime(AVTime(frame_30, AVFps::fps_30()));
+    Q_ASSERT("smpte is 01:00:04:00 for 30 fps" && smpte.to_string() == "01:00:04:00");
+    qDebug() << "smpte 30 fps: " << smpte.to_string();
+    
+    qint64 frame_23_976 = AVSmpteTime::convert(frame_24, AVFps::fps_23_976());
+    smpte = AVSmpteTime(AVTime(frame_23_976, AVFps::fps_23_976()));
+    Q_ASSERT("smpte is 01:00:04.00 for 23.976 fps" && smpte.to_string() == "01:00:04.00");
+    qDebug() << "smpte 23.976 fps: " << smpte.to_string();
+    
+    qint64 frame_29_997 = 440658;
+    smpte = AVSmpteTime(AVTime(frame_29_997, AVFps::fps_29_97()));
+    Q_ASSERT("smpte is 04:05:03.10" && smpte.to_string() == "04:05:03.10");
+    qDebug() << "smpte 29_97 fps: " << smpte.to_string();
+
+    frame_29_997 = 442698;
+    smpte = AVSmpteTime(AVTime(frame_29_997, AVFps::fps_29_97()));
+    Q_ASSERT("smpte is 04:06:11.12" && smpte.to_string() == "04:06:11.12");
+    qDebug() << "smpte 29_97 fps: " << smpte.to_string();
+    
+    // quicktime data:
+    // 01:00:04:00
+    // 2542
+    // 01:46
+    // 01:01:49:22 (uses floor rather than round, 22583)
+    // 23.976 fps
+    time = AVTime(2544542, 24000, AVFps::fps_23_976());
+    Q_ASSERT("time is 01:46" && time.to_string() == "01:46");
+    Q_ASSERT("frames is 2542" && time.frames() == 2542);
+    qDebug() << "time: " << time.to_string();
+    qDebug() << "time frames: " << time.frames();
+    
+    frame = 2541;
+    AVTime duration = AVTime(frame, AVFps::fps_23_976()); // 0-2542, 2541 last frame
+    Q_ASSERT("frames is 2541" && duration.frames() == frame);
+    qDebug()  << "time frames: " << duration.frames();
+    
+    frame = 86496;
+    AVTime offset = AVTime(frame, AVFps::fps_24()); // typical timecode, 01:00:04:00, 24 fps
+    qDebug()  << "offset max: " << offset.frames();
+    qDebug()  << "offset smpte: " << AVSmpteTime(offset).to_string();
+    
+    frame = AVSmpteTime::convert(offset.frames(), AVFps::fps_23_976()); // fix it to 01:00:04:00, match 23.976 timecode, drop frame
+    Q_ASSERT("drop frame is 86388" && frame == 86388);
+    qDebug()  << "offset dropframe: " << frame;
+
+    smpte = AVSmpteTime(AVTime(duration.frames() + frame, AVFps::fps_23_976()));
+    Q_ASSERT("smpte is 01:01:49.23" && smpte.to_string() == "01:01:49.23");
+    qDebug() << "smpte: " << smpte.to_string();
+    
+    // ffmpeg data:
+    // time_base=1/24000
+    // duration_ts=187903716
+    // 7829.344000
+    // 24000/1001
+    // 2:10:29.344000
+    time = AVTime(187903716, 24000, AVFps::fps_24()); // typical duration, 02:10:29.344000, 24 fps
+    Q_ASSERT("seconds 7829.32" && qFuzzyCompare(time.seconds(), 7829.3215));
+    qDebug() << "seconds: " << time.seconds();
+
+    smpte = AVSmpteTime(time);
+    Q_ASSERT("smpte is 02:10:29:08 for 24 fps" && smpte.to_string() == "02:10:29:08"); // *:08 equals 8/24 of a second = .344000
+    qDebug() << "smpte 24 fps: " << smpte.to_string();
+    
+    // resolve data:
+    // frame: 87040, converted to 87148 at fps: 23.967
+    // 01:00:31:04
+    // 01:00:30 (wall clock time)
+    // 24 NDF is used in Resolve for 23.967 for timecode
+    
+    frame = 87040;
+    time = AVTime(frame, AVFps::fps_23_976());
+    Q_ASSERT("time is 01:00:30" && time.to_string() == "01:00:30");
+    qDebug() << "time: " << time.to_string();
+    
+    smpte = AVSmpteTime(time);
+    Q_ASSERT("smpte is 01:00:31.04 for 23.976 fps" && smpte.to_string() == "01:00:31.04");
+    qDebug() << "smpte 23.976: " << smpte.to_string();
+    
+    const QList<AVFps> rates = {
+        AVFps::fps_23_976(),
+        AVFps::fps_24(),
+        AVFps::fps_25(),
+        AVFps::fps_29_97(),
+        AVFps::fps_30(),
+        AVFps::fps_47_952(),
+        AVFps::fps_48(),
+        AVFps::fps_50(),
+        AVFps::fps_59_94(),
+        AVFps::fps_60()
+    };
+    char buffer[AVSmpteTime::max_chars];
+    for (const AVFps& fps : rates) {
+        qint64 frames = fps.frame_quanta() * 60 * 20; // 20 minutes, covers every drop frame boundary kind
+        for (qint64 frame = -fps.frame_quanta(); frame < frames; frame++) {
+            AVTime time(frame, fps);
+            qsizetype length = AVSmpteTime::to_chars(time, buffer, sizeof(buffer));
+            Q_ASSERT("to_chars matches to_string" && QString::fromLatin1(buffer, length) == AVSmpteTime(time).to_string());
+            if (baseline_convert(qAbs(frame), fps) == AVSmpteTime::convert(qAbs(frame), fps, true)) {
+                Q_ASSERT("to_chars matches the baseline formatting" && QString::fromLatin1(buffer, length) == baseline_string(frame, fps));
+            }
+            qint64 parsed = 0;
+            bool valid = AVSmpteTime::parse(QByteArrayView(buffer, length), fps, parsed);
+            Q_ASSERT("parse timecode" && valid);
+            Q_ASSERT("parse matches frame" && parsed == frame);
+            qint64 label = AVSmpteTime::convert(qAbs(frame), fps, true);
+            Q_ASSERT("convert is reversible" && AVSmpteTime::convert(label, fps, false) == qAbs(frame));
+        }
+    }
+    for (const AVFps& fps : { AVFps::fps_23_976(), AVFps::fps_29_97() }) {
+        // same drop count as the baseline, labels only differ where it handed out dropped labels
+        qint64 framequanta = fps.frame_quanta();
+        qint64 differences = 0;
+        for (qint64 frame = 0; frame < framequanta * 60 * 60; frame++) {
+            qint64 label = AVSmpteTime::convert(frame, fps, true);
+            if (label != baseline_convert(frame, fps)) {
+                qint64 minutes = label / framequanta / 60;
+                Q_ASSERT("baseline differs in the first second of minutes 1-9" &&
+                         minutes % 10 != 0 && label / framequanta % 60 == 0 && label % framequanta < 2 * 9);
+                differences++;
+            }
+        }
+        Q_ASSERT("baseline lagged 2 frames more each minute" && differences == 6 * 2 * (1 + 2 + 3 + 4 + 5 + 6 + 7 + 8));
+    }
+    for (const AVFps& fps : rates) {
+        qint64 frames = fps.frame_quanta() * 60 * 60 * 24 + fps.frame_quanta() * 60 * 11; // past the 24 hour wrap
+        AVSmpteTime counter(AVTime(qint64(0), fps));
+        for (qint64 frame = 0; frame < frames; frame++, ++counter) {
+            qsizetype length = AVSmpteTime::to_chars(AVTime(frame, fps), buffer, sizeof(buffer));
+            Q_ASSERT("counter matches frame" && counter.frame() == frame);
+            Q_ASSERT("counter matches convert" && counter.to_string() == QString::fromLatin1(buffer, length));
+        }
+        for (qint64 frame = frames; frame > -fps.frame_quanta() * 61; frame -= 997) { // backwards and across zero
+            AVSmpteTime previous(AVTime(frame, fps));
+            AVSmpteTime next(AVTime(frame - 997, fps));
+            for (qint64 step = 0; step < 997; step++) {
+                --previous;
+            }
+            Q_ASSERT("counter matches convert backwards" && previous == next);
+            previous += 997;
+            previous -= 997;
+            Q_ASSERT("counter matches convert after jumps" && previous == next);
+        }
+        AVSmpteTime mirrored(AVTime(qint64(1), fps));
+        mirrored.set_negatives(false);
+        mirrored -= 2;
+        Q_ASSERT("counter mirrors negative hours" && mirrored.hours() == 23 && mirrored.frames() == 1);
+    }
+    {
+        AVFps fps = AVFps::fps_29_97();
+        qint64 frames = AVSmpteTime::convert(fps.frame_quanta() * 60 * 60 * 24, fps); // 24 hours of labels
+        AVSmpteTime counter(AVTime(qint64(0), fps));
+        QElapsedTimer timer;
+        timer.start();
+        for (qint64 frame = 0; frame < frames; frame++) {
+            ++counter;
+        }
+        qreal incremental = timer.nsecsElapsed();
+        Q_ASSERT("counter wraps at 24 hours" && counter.to_string() == "00:00:00.00");
+        qint64 checksum = 0;
+        timer.restart();
+        for (qint64 frame = 0; frame < frames; frame++) {
+            checksum += AVSmpteTime::to_chars(AVTime(frame, fps), buffer, sizeof(buffer));
+        }
+        qreal converted = timer.nsecsElapsed();
+        Q_ASSERT("checksum is valid" && checksum > 0);
+        qDebug() << "smpte counter: " << incremental / frames << "ns/frame, convert:" << converted / frames << "ns/frame";
+    }
+    
+    qint64 parsed = 0;
+    bool valid = AVSmpteTime::parse("00:01:00;00", AVFps::fps_29_97(), parsed);
+    Q_ASSERT("dropped label is invalid" && !valid);
+    valid = AVSmpteTime::parse("00:10:00;00", AVFps::fps_29_97(), parsed);
+    Q_ASSERT("dropped label is valid at ten minutes" && valid);
+    valid = AVSmpteTime::parse("00:01:00;02", AVFps::fps_29_97(), parsed);
+    Q_ASSERT("first label after drop" && valid && parsed == 1800);
+    valid = AVSmpteTime::parse("00:01:00;04", AVFps::fps_59_94(), parsed);
+    Q_ASSERT("59.94 drops four labels" && valid && parsed == 3600);
+    valid = AVSmpteTime::parse("00:00:00:25", AVFps::fps_25(), parsed);
+    Q_ASSERT("frames out of range" && !valid);
+    valid = AVSmpteTime::parse("00-00-00-00", AVFps::fps_25(), parsed);
+    Q_ASSERT("invalid separator" && !valid);
+    
+    {
+        AVFps fps = AVFps::fps_29_97();
+        const qsizetype count = 50000;
+        QList<QByteArray> strings;
+        QList<QByteArrayView> texts;
+        QList<qint64> expected;
+        for (qsizetype i = 0; i < count; i++) {
+            qint64 frame = QRandomGenerator::global()->bounded(23 * 60 * 60 * 29); // within the 24 hour wrap
+            expected.append(frame);
+            strings.append(AVSmpteTime(AVTime(frame, fps)).to_string().toLatin1());
+        }
+        for (const QByteArray& string : strings) {
+            texts.append(QByteArrayView(string));
+        }
+        QList<qint64> frames(count);
+        QElapsedTimer timer;
+        timer.start();
+        qsizetype parsed = AVSmpteTime::parse(texts, fps, frames);
+        qreal elapsed = timer.nsecsElapsed();
+        Q_ASSERT("batch parsed all timecodes" && parsed == count);
+        Q_ASSERT("batch parse matches frames" && frames == expected);
+        qDebug() << "smpte batch parse: " << count << "timecodes" << elapsed / count << "ns/timecode";
+    }
+}
+
+void test_timestamps() {
+    qDebug() << "Testing timestamps";
+    
+    qint32 timescale = 90000;
+    qint64 hours = 2;
+    AVTimestamps timestamps(timescale);
+    QList<qint64> expected;
+    qint64 ticks = 0;
+    while (ticks < hours * 60 * 60 * timescale) { // variable frame rate between 24 and 60 fps
+        expected.append(ticks);
+        timestamps.append(ticks);
+        ticks += QRandomGenerator::global()->bounded(timescale / 60, timescale / 24);
+    }
+    timestamps.set_end(ticks);
+    timestamps.squeeze();
+    Q_ASSERT("timestamps are valid" && timestamps.valid());
+    Q_ASSERT("timestamps are variable" && !timestamps.constant());
+    Q_ASSERT("frame count matches" && timestamps.count() == expected.size());
+    Q_ASSERT("table stays within a few mb" && timestamps.bytes() < 4 * 1024 * 1024);
+    qDebug() << "timestamps: " << timestamps.count() << "frames" << timestamps.bytes() << "bytes";
+    
+    for (qint64 frame = 0; frame < expected.size(); frame++) {
+        Q_ASSERT("ticks matches frame" && timestamps.ticks(frame) == expected[frame]);
+        Q_ASSERT("frame matches ticks" && timestamps.frame(expected[frame]) == frame);
+        Q_ASSERT("frame holds until next" && timestamps.frame(timestamps.ticks(frame) + timestamps.duration(frame) - 1) == frame);
+    }
+    Q_ASSERT("frame before start is first" && timestamps.frame(-1) == 0);
+    Q_ASSERT("frame after end is last" && timestamps.frame(ticks * 2) == expected.size() - 1);
+    Q_ASSERT("align to frame" && timestamps.align(expected[10] + 1) == expected[10]);
+    
+    AVTimestamps constant(24000);
+    for (qint64 frame = 0; frame < 1000; frame++) {
+        constant.append(frame * 1001);
+    }
+    Q_ASSERT("timestamps are constant" && constant.constant());
+    AVTimestamps shared = constant;
+    shared.append(1000 * 1001 + 1);
+    Q_ASSERT("copies detach on write" && constant.count() == 1000 && shared.count() == 1001 && !shared.constant());
+    
+    {
+        const qint64 count = 1000000;
+        qint64 checksum = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (qint64 i = 0; i < count; i++) {
+            checksum += timestamps.frame(QRandomGenerator::global()->bounded(ticks));
+        }
+        qreal search = timer.nsecsElapsed();
+        timer.restart();
+        for (qint64 i = 0; i < count; i++) {
+            checksum += timestamps.ticks(i % timestamps.count());
+        }
+        qreal lookup = timer.nsecsElapsed();
+        Q_ASSERT("checksum is valid" && checksum > 0);
+        qDebug() << "timestamps frame: " << search / count << "ns/lookup, ticks:" << lookup / count << "ns/lookup";
+    }
+}
+
+void test_timerangeset() {
+    qDebug() << "Testing time range set";
+    
+    AVTime time(qint64(0), 24000, AVFps::fps_24());
+    auto range = [&](qint64 start, qint64 end) {
+        return AVTimeRange(AVTime(time, start), AVTime(time, end - start));
+    };
+    const qint64 domain = 2000;
+    for (int iteration = 0; iteration < 200; iteration++) { // compare against a tick bitmap
+        AVTimeRangeSet a, b;
+        QList<bool> ma(domain, false), mb(domain, false);
+        for (int i = 0; i < 20; i++) {
+            qint64 start = QRandomGenerator::global()->bounded(int(domain - 1));
+            qint64 end = start + 1 + QRandomGenerator::global()->bounded(int(qMin<qint64>(100, domain - start - 1)) + 1);
+            bool remove = QRandomGenerator::global()->bounded(4) == 0;
+            AVTimeRangeSet& set = i % 2 ? a : b;
+            QList<bool>& map = i % 2 ? ma : mb;
+            if (remove) {
+                set.remove(range(start, end));
+            }
+            else {
+                set.insert(range(start, end));
+            }
+            for (qint64 t = start; t < end; t++) {
+                map[t] = !remove;
+            }
+        }
+        AVTimeRangeSet united = a | b;
+        AVTimeRangeSet intersected = a & b;
+        AVTimeRangeSet subtracted = a - b;
+        for (qint64 t = 0; t < domain; t++) {
+            AVTime at(time, t);
+            Q_ASSERT("set contains" && a.contains(at) == ma[t]);
+            Q_ASSERT("union contains" && united.contains(at) == (ma[t] || mb[t]));
+            Q_ASSERT("intersection contains" && intersected.contains(at) == (ma[t] && mb[t]));
+            Q_ASSERT("difference contains" && subtracted.contains(at) == (ma[t] && !mb[t]));
+            qint64 gap = t;
+            while (gap < domain && ma[gap]) {
+                gap++;
+            }
+            Q_ASSERT("next gap" && a.next_gap(at).ticks() == gap);
+        }
+        for (const AVTimeRangeSet& set : { a, united, intersected, subtracted }) {
+            for (qsizetype i = 1; i < set.size(); i++) {
+                Q_ASSERT("set is normalized" && set.range(i - 1).end() < set.range(i).start());
+            }
+        }
+    }
+    AVTimeRangeSet set(range(1000, 2000));
+    Q_ASSERT("contains across timescales" && set.contains(AVTime(qint64(83334), 2000000, AVFps::fps_24()))); // 1000.008 ticks
+    Q_ASSERT("exact lower bound" && !set.contains(AVTime(qint64(1999999), 48000000, AVFps::fps_24()))); // 999.9995 ticks
+    Q_ASSERT("exact upper bound" && !set.contains(AVTime(qint64(4000), 48000, AVFps::fps_24())));
+    Q_ASSERT("contains range" && set.contains(range(1200, 2000)) && !set.contains(range(1200, 2001)));
+    Q_ASSERT("intersects range" && set.intersects(range(1999, 3000)) && !set.intersects(range(2000, 3000)));
+    set.insert(range(2000, 2500));
+    Q_ASSERT("adjacent ranges join" && set.size() == 1 && set.duration().ticks() == 1500);
+    AVTimeRange foreign(AVTime(qint64(6000001), 48000000, AVFps::fps_24()), AVTime(qint64(2), 48000000, AVFps::fps_24())); // 3000.0005 to 3000.0015 ticks
+    set.insert(foreign);
+    Q_ASSERT("foreign range covered" && set.size() == 2 && set.contains(foreign) && set.intersects(foreign));
+    
+    const qsizetype count = 100000;
+    AVTimeRangeIndex index;
+    QList<AVTimeRange> ranges;
+    for (qsizetype i = 0; i < count; i++) {
+        qint64 start = QRandomGenerator::global()->bounded(qint64(1) << 32);
+        qint64 end = start + 1 + QRandomGenerator::global()->bounded(qint64(1) << 24);
+        ranges.append(range(start, end));
+        qsizetype id = index.append(ranges.last());
+        Q_ASSERT("index id" && id == i);
+    }
+    index.build();
+    QList<AVTime> queries;
+    for (int i = 0; i < 1000; i++) {
+        queries.append(AVTime(time, QRandomGenerator::global()->bounded(qint64(1) << 32)));
+    }
+    QList<qsizetype> ids;
+    qsizetype found = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (const AVTime& query : queries) {
+        found += index.covering(query, ids);
+    }
+    qreal indexed = timer.nsecsElapsed();
+    qsizetype scanned = 0;
+    timer.restart();
+    for (const AVTime& query : queries) {
+        for (const AVTimeRange& range : ranges) {
+            if (range.start() <= query && query < range.end()) {
+                scanned++;
+            }
+        }
+    }
+    qreal naive = timer.nsecsElapsed();
+    Q_ASSERT("index matches scan" && found == scanned);
+    for (int i = 0; i < 50; i++) {
+        index.covering(queries[i], ids);
+        QList<qsizetype> expected;
+        for (qsizetype id = 0; id < ranges.size(); id++) {
+            if (ranges[id].start() <= queries[i] && queries[i] < ranges[id].end()) {
+                expected.append(id);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        Q_ASSERT("index ids match scan" && ids == expected);
+    }
+    qDebug() << "time range index: " << count << "ranges" << indexed / queries.size() << "ns/query, scan:" << naive / queries.size() << "ns/query";
+}
+
+void test_ltc() {
+    qDebug() << "Testing LTC";
+
+    static_assert(sizeof(AVSmpteWord) == sizeof(quint64), "word is packed");
+    static_assert(AVSmpteWord(0x0209000000000000ULL).hours() == 29, "bcd hours");
+    AVSmpteWord word(1, 2, 3, 4);
+    Q_ASSERT("word fields" && word.hours() == 1 && word.minutes() == 2 && word.seconds() == 3 && word.frames() == 4);
+    Q_ASSERT("word string" && word.to_string() == "01:02:03:04");
+    word.set_userbits(0x89abcdef);
+    word.set_color_frame(true);
+    Q_ASSERT("user bits" && word.userbits() == 0x89abcdef);
+    Q_ASSERT("flags" && word.color_frame() && !word.drop_frame());
+    Q_ASSERT("key ignores user bits and flags" && word.key() == AVSmpteWord(1, 2, 3, 4).key());
+    Q_ASSERT("hash of equal words" && qHash(word) == qHash(AVSmpteWord(word.bits())));
+    Q_ASSERT("invalid bcd" && !AVSmpteWord(0x000000000000000aULL).valid());
+
+    const QList<AVFps> rates = {
+        AVFps::fps_23_976(),
+        AVFps::fps_24(),
+        AVFps::fps_25(),
+        AVFps::fps_29_97(),
+        AVFps::fps_30(),
+        AVFps::fps_48(),
+        AVFps::fps_50(),
+        AVFps::fps_59_94(),
+        AVFps::fps_60()
+    };
+    for (const AVFps& fps : rates) {
+        qint64 day = AVSmpteTime::convert(fps.frame_quanta() * 60 * 60 * 24, fps);
+        for (int i = 0; i < 1000; i++) {
+            qint64 frame = QRandomGenerator::global()->bounded(day * 3) - day;
+            qint64 other = QRandomGenerator::global()->bounded(day);
+            qint64 wrapped = ((frame % day) + day) % day;
+            AVSmpteWord a(frame, fps);
+            AVSmpteWord b(other, fps);
+            Q_ASSERT("word is valid" && a.valid() && a.drop_frame() == fps.drop_frame());
+            if (fps.frame_quanta() <= 30) {
+                Q_ASSERT("word is reversible" && a.frame(fps) == wrapped);
+                Q_ASSERT("word matches smpte time" && AVSmpteTime(AVTime(wrapped, fps)).word() == a);
+                Q_ASSERT("word string matches smpte time" && a.to_string() == AVSmpteTime(AVTime(wrapped, fps)).to_string());
+                Q_ASSERT("word order follows frames" && (a < b) == (wrapped < other));
+                Q_ASSERT("smpte time from word" && AVSmpteTime(a, fps).frame() == wrapped);
+            }
+            else if (!fps.drop_frame()) {
+                Q_ASSERT("word counts frame pairs" && a.frame(fps) == (wrapped & ~qint64(1)));
+            }
+        }
+        Q_ASSERT("negative time wraps into 24 hours" && AVSmpteTime(AVTime(qint64(-1), fps)).word() == AVSmpteWord(day - 1, fps));
+    }
+
+    qsizetype count = 200;
+    for (const AVFps& fps : rates) {
+        if (fps.frame_quanta() > 30) {
+            continue;
+        }
+        qint32 samplerate = 48000;
+        qint64 start = AVSmpteTime::convert(fps.frame_quanta() * 60, fps) - count / 2; // crosses a minute, drops labels
+        auto encode = [&](qint32 samplerate, qreal amplitude, auto& audio, QList<qint64>& positions) {
+            AVLtcEncoder encoder(fps, samplerate);
+            encoder.set_amplitude(amplitude);
+            std::decay_t<decltype(audio)> buffer(AVLtcEncoder::max_samples(fps, samplerate));
+            for (qsizetype i = 0; i <= count; i++) { // one more word closes the last bit
+                AVSmpteWord word(start + i, fps);
+                word.set_userbits(static_cast<quint32>(i) * 0x01010101);
+                positions.append(encoder.position());
+                qsizetype samples = encoder.encode(word, buffer);
+                Q_ASSERT("samples within max" && samples > 0 && samples <= buffer.size());
+                audio.append(buffer.mid(0, samples));
+            }
+            Q_ASSERT("encoder is sample exact" && encoder.position() == AVMath::muldiv_floor(count + 1, qint64(samplerate) * fps.denominator(), fps.numerator()));
+        };
+        auto verify = [&](const QList<AVLtcFrame>& frames, qsizetype first, qsizetype last, bool reverse) {
+            Q_ASSERT("decoded every word" && frames.size() == qAbs(last - first) + 1);
+            for (qsizetype i = 0; i < frames.size(); i++) {
+                qsizetype index = reverse ? first - i : first + i;
+                AVSmpteWord expected(start + index, fps);
+                Q_ASSERT("decoded word" && frames[i].word.key() == expected.key());
+                Q_ASSERT("decoded user bits" && frames[i].word.userbits() == static_cast<quint32>(index) * 0x01010101);
+                Q_ASSERT("decoded flags" && frames[i].word.drop_frame() == fps.drop_frame() && frames[i].reverse == reverse);
+            }
+        };
+        QList<float> audio;
+        QList<qint64> positions;
+        encode(samplerate, 0.5, audio, positions);
+        {
+            AVLtcDecoder decoder(fps, samplerate);
+            QList<AVLtcFrame> frames;
+            for (qsizetype offset = 0; offset < audio.size(); offset += 997) {
+                decoder.decode(QSpan<const float>(audio.constData() + offset, qMin<qsizetype>(997, audio.size() - offset)), frames);
+            }
+            verify(frames, 0, count - 1, false);
+            for (qsizetype i = 0; i < frames.size(); i++) {
+                Q_ASSERT("frame starts at word" && qAbs(frames[i].start - positions[i]) <= 1);
+            }
+        }
+        {
+            QList<float> reversed(audio.rbegin(), audio.rend());
+            AVLtcDecoder decoder(fps, samplerate);
+            QList<AVLtcFrame> frames;
+            decoder.decode(QSpan<const float>(reversed.constData(), reversed.size()), frames);
+            verify(frames, count - 1, 1, true); // the first word has no closing edge when played backwards
+        }
+        {
+            QList<float> varispeed;
+            QList<qint64> unused;
+            encode(44100, 0.5, varispeed, unused);
+            AVLtcDecoder decoder(fps, samplerate); // plays 8% slow
+            QList<AVLtcFrame> frames;
+            decoder.decode(QSpan<const float>(varispeed.constData(), varispeed.size()), frames);
+            verify(frames, 0, count - 1, false);
+        }
+        QList<qint16> pcm;
+        QList<qint64> unused;
+        encode(samplerate, 0.1, pcm, unused);
+        for (qint16& sample : pcm) {
+            sample += 2000 + QRandomGenerator::global()->bounded(600) - 300; // dc offset and noise
+        }
+        {
+            AVLtcDecoder decoder(fps, samplerate);
+            QList<AVLtcFrame> frames;
+            decoder.decode(QSpan<const qint16>(pcm.constData(), pcm.size()), frames);
+            verify(frames, 0, count - 1, false);
+        }
+        {
+            QString filename = QDir::tempPath() + "/flipman_ltc.wav";
+            char header[44] = {};
+            char* data = header;
+            memcpy(data, "RIFF", 4);
+            qToLittleEndian<quint32>(36 + pcm.size() * 2, data + 4);
+            memcpy(data + 8, "WAVEfmt ", 8);
+            qToLittleEndian<quint32>(16, data + 16);
+            qToLittleEndian<quint16>(1, data + 20); // pcm
+            qToLittleEndian<quint16>(1, data + 22); // mono
+            qToLittleEndian<quint32>(samplerate, data + 24);
+            qToLittleEndian<quint32>(samplerate * 2, data + 28);
+            qToLittleEndian<quint16>(2, data + 32);
+            qToLittleEndian<quint16>(16, data + 34);
+            memcpy(data + 36, "data", 4);
+            qToLittleEndian<quint32>(pcm.size() * 2, data + 40);
+            QFile file(filename);
+            bool opened = file.open(QIODevice::WriteOnly);
+            Q_ASSERT("open wav file" && opened);
+            file.write(header, sizeof(header));
+            file.write(reinterpret_cast<const char*>(pcm.constData()), pcm.size() * 2); // little endian hosts
+            file.close();
+            AVLtcDecoder decoder(fps, 0);
+            QList<AVLtcFrame> frames;
+            qsizetype decoded = decoder.decode(filename, frames);
+            Q_ASSERT("decode wav file" && decoded == count);
+            Q_ASSERT("wav samplerate" && decoder.samplerate() == samplerate && decoder.error() == AVLtcDecoder::NO_ERROR);
+            verify(frames, 0, count - 1, false);
+            file.remove();
+            decoded = decoder.decode(filename, frames);
+            Q_ASSERT("missing wav file" && decoded == 0 && decoder.error() == AVLtcDecoder::FILE_ERROR);
+        }
+    }
+    {
+        AVFps fps = AVFps::fps_25();
+        qint32 samplerate = 48000;
+        qint64 frames = 25 * 60; // one minute of audio
+        AVLtcEncoder encoder(fps, samplerate);
+        QList<float> audio(AVLtcEncoder::max_samples(fps, samplerate) * frames);
+        QElapsedTimer timer;
+        timer.start();
+        qsizetype samples = 0;
+        for (qint64 frame = 0; frame < frames; frame++) {
+            samples += encoder.encode(AVSmpteWord(frame, fps), QSpan<float>(audio.data() + samples, audio.size() - samples));
+        }
+        qreal encoded = timer.nsecsElapsed();
+        AVLtcDecoder decoder(fps, samplerate);
+        QList<AVLtcFrame> decoded;
+        timer.restart();
+        decoder.decode(QSpan<const float>(audio.constData(), samples), decoded);
+        qreal elapsed = timer.nsecsElapsed();
+        Q_ASSERT("decoded one minute" && decoded.size() == frames - 1);
+        qDebug() << "ltc encode:" << encoded / samples << "ns/sample, decode:" << elapsed / samples << "ns/sample,"
+                 << (1e9 * samples / samplerate) / elapsed << "x realtime";
+    }
+}
+
+void test_timer_drift() {
+    qDebug() << "Testing timer drift";
+    {
+        AVFps fps = AVFps::fps_23_976();
+        AVTimer timer;
+        timer.start(fps);
+        for (qint64 frame = 1; frame < 1000000; frame++) {
+            timer.next(fps);
+        }
+        qDebug() << "deadline after 1000000 frames:" << timer.deadline();
+        Q_ASSERT("deadline is exact" && timer.deadline() == AVMath::muldiv_floor(1000000, qint64(1000000000) * 1001, 24000));
+    }
+    {
+        AVTimer timer;
+        timer.start(1001, 90000);
+        for (qint64 frame = 1; frame < 90000; frame++) {
+            timer.next(1001, 90000);
+        }
+        Q_ASSERT("timescale deadline is exact" && timer.deadline() == qint64(1001) * 1000000000);
+    }
+    {
+        // reference runs 180 ppm fast, then jumps 10 ms ahead
+        AVFps fps = AVFps::fps_60();
+        qint64 period = 1000000000 / 60;
+        qint64 offset = 0;
+        QElapsedTimer clock;
+        clock.start();
+        AVTimer timer;
+        timer.lock([&]() { return static_cast<quint64>(clock.nsecsElapsed() + offset); }, 0.0005);
+        timer.start(fps);
+        qint64 previous = timer.deadline();
+        for (qint64 frame = 1; frame < 2000; frame++) {
+            offset += 3000;
+            if (frame == 1000) {
+                Q_ASSERT("phase converged" && qAbs(timer.phase_error()) < 20000);
+                offset += 10000000;
+            }
+            timer.next(fps);
+            qint64 step = timer.deadline() - previous;
+            Q_ASSERT("slew bounded" && qAbs(step - period) <= period * 0.0005 + 1);
+            previous = timer.deadline();
+        }
+        qDebug() << "phase error after jump:" << timer.phase_error();
+        Q_ASSERT("locked" && timer.is_locked());
+        // slewed out at the bound less the 3000 ns drift per frame, never stepped
+        Q_ASSERT("phase error after jump slews" && timer.phase_error() > 0 && timer.phase_error() < 10000000 - 999 * 5000);
+    }
+}
+
+void test_timer_virtual() {
+    qDebug() << "Testing timer virtual";
+    {
+        // 60 fps with decode delays in msecs, 40 drops frame 2 and 70 drops frames 5, 6 and 7
+        AVVirtualClock clock;
+        AVFps fps = AVFps::fps_60();
+        AVTimer timer;
+        timer.set_clock(&clock);
+        timer.start(fps);
+        const QList<quint64> delays = { 40, 5, 70, 5 };
+        QList<qint64> drops;
+        qint64 frame = 0;
+        for (quint64 delay : delays) {
+            clock.advance(delay * 1000000);
+            timer.wait();
+            Q_ASSERT("never wakes early" && timer.wake_error() >= 0);
+            while (!timer.next(fps)) {
+                frame++;
+                drops.append(frame + 1);
+            }
+            frame++;
+        }
+        Q_ASSERT("dropped frames" && drops == QList<qint64>({ 2, 5, 6, 7 }));
+        Q_ASSERT("woke on the deadline" && static_cast<qint64>(clock.now()) == AVMath::muldiv_floor(8, 1000000000, 60));
+    }
+    {
+        // the 400 second test_timer run in simulated time, drops checked against exact deadlines
+        AVVirtualClock clock;
+        AVFps fps = AVFps::fps_23_976();
+        qint64 duration = 24 * 400;
+        QRandomGenerator random(2024);
+        QElapsedTimer elapsed;
+        elapsed.start();
+        AVTimer timer;
+        timer.set_clock(&clock);
+        timer.set_mode(AVTimer::SPIN);
+        timer.start(fps);
+        qint64 dropped = 0;
+        qint64 expected = 0;
+        for (qint64 frame = 1; frame < duration; frame++) {
+            quint64 delay = random.bounded(1, 80) + (frame % 500 == 0 ? 100 : 0); // stall every 500 frames
+            clock.advance(delay * 1000000);
+            timer.wait();
+            quint64 woken = clock.now();
+            for (qint64 next = frame + 1; AVMath::muldiv_floor(next, qint64(1000000000) * 1001, 24000) <= static_cast<qint64>(woken); next++) {
+                expected++;
+            }
+            while (!timer.next(fps)) {
+                frame++;
+                dropped++;
+            }
+            Q_ASSERT("deadline is exact" && timer.deadline() == AVMath::muldiv_floor(frame + 1, qint64(1000000000) * 1001, 24000));
+        }
+        qDebug() << "simulated:" << AVTimer::convert(clock.now(), AVTimer::Unit::SECONDS) << "seconds in"
+                 << elapsed.nsecsElapsed() / 1e6 << "msecs, dropped:" << dropped;
+        Q_ASSERT("dropped frames" && dropped == expected && dropped > 0);
+        Q_ASSERT("simulated faster than realtime" && elapsed.nsecsElapsed() < static_cast<qint64>(clock.now()));
+    }
+}
+
+void test_histogram() {
+    qDebug() << "Testing histogram";
+    {
+        for (quint64 value : { quint64(0), quint64(1), quint64(63), quint64(64), quint64(1000), quint64(123456789),
+                               std::numeric_limits<quint64>::max() }) {
+            qsizetype index = AVHistogram::index(value);
+            Q_ASSERT("index in range" && index >= 0 && index < AVHistogram::buckets);
+            Q_ASSERT("value within bucket" && AVHistogram::lowest(index) <= value && value <= AVHistogram::highest(index));
+            Q_ASSERT("relative error" && AVHistogram::highest(index) - AVHistogram::lowest(index) <= value / 32);
+        }
+        for (qsizetype index = 1; index < AVHistogram::buckets; index++) {
+            Q_ASSERT("buckets are contiguous" && AVHistogram::lowest(index) == AVHistogram::highest(index - 1) + 1);
+        }
+    }
+    {
+        AVHistogram histogram;
+        Q_ASSERT("empty" && histogram.is_empty() && histogram.percentile(99.0) == 0);
+        for (quint64 value = 1; value <= 10000; value++) {
+            histogram.record(value * 1000); // 1 us to 10 ms
+        }
+        Q_ASSERT("count" && histogram.count() == 10000);
+        Q_ASSERT("min max" && histogram.min() == 1000 && histogram.max() == 10000000);
+        Q_ASSERT("mean" && qAbs(histogram.mean() - 5000500.0) < 1.0);
+        const QList<qreal> percentiles = { 50.0, 99.0, 99.9 };
+        for (qreal percentile : percentiles) {
+            qreal expected = percentile * 100000.0;
+            qreal actual = histogram.percentile(percentile);
+            Q_ASSERT("percentile within precision" && actual >= expected && actual <= expected * (1.0 + 1.0 / 32));
+        }
+        Q_ASSERT("percentile 100 is max" && histogram.percentile(100.0) == histogram.max());
+        Q_ASSERT("count above" && histogram.count(9000000) <= 1000 && histogram.count(9000000) >= 1000 - 9000000 / 32 / 1000);
+
+        AVHistogram copy(histogram);
+        copy.record(20000000, 10);
+        Q_ASSERT("copy detached" && histogram.count() == 10000 && copy.count() == 10010);
+        AVHistogram merged;
+        merged.merge(histogram);
+        merged.merge(copy);
+        Q_ASSERT("merged" && merged.count() == 20010 && merged.max() == 20000000 && merged.min() == 1000);
+        merged.reset();
+        Q_ASSERT("reset" && merged.is_empty() && merged.max() == 0);
+        qDebug() << "histogram:" << histogram.to_string();
+    }
+}
+
+void test_realtime() {
+    qDebug() << "Testing realtime";
+    {
+        AVRealtime realtime;
+        realtime.set_policy(AVRealtime::DEFAULT);
+        bool applied = realtime.apply();
+        Q_ASSERT("nothing requested applies" && applied);
+        Q_ASSERT("each step applied" && realtime.is_applied(AVRealtime::SCHEDULING) &&
+                 realtime.is_applied(AVRealtime::AFFINITY) && realtime.is_applied(AVRealtime::MEMORY));
+        Q_ASSERT("report per step" && realtime.report().size() == 3);
+        realtime.restore();
+        Q_ASSERT("restored" && !realtime.is_applied(AVRealtime::SCHEDULING));
+    }
+    {
+        // runs on a thread of its own, scheduling may fall back without privileges but is always reported
+        QThread* thread = QThread::create([] {
+            AVRealtime realtime;
+            realtime.set_policy(AVRealtime::FIFO);
+            realtime.set_period(static_cast<quint64>(1e9 * AVFps::fps_24().seconds()));
+            realtime.set_cpus({ 0 });
+            realtime.set_lock_memory(true);
+            bool applied = realtime.apply();
+            for (const QString& message : realtime.report()) {
+                qDebug() << "realtime:" << message;
+            }
+            Q_ASSERT("messages set" && !realtime.message(AVRealtime::SCHEDULING).isEmpty() &&
+                     !realtime.message(AVRealtime::AFFINITY).isEmpty() && !realtime.message(AVRealtime::MEMORY).isEmpty());
+            Q_ASSERT("applied matches steps" && applied == (realtime.is_applied(AVRealtime::SCHEDULING) &&
+                     realtime.is_applied(AVRealtime::AFFINITY) && realtime.is_applied(AVRealtime::MEMORY)));
+            QList<char> buffer(1 << 16, 0);
+            if (AVRealtime::lock(buffer.constData(), buffer.size())) {
+                bool unlocked = AVRealtime::unlock(buffer.constData(), buffer.size());
+                Q_ASSERT("unlock" && unlocked);
+            }
+        });
+        thread->start();
+        thread->wait();
+        delete thread;
+    }
+}
+
+int
+main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    test_time();
+    test_timerange();
+    test_fps();
+    test_timebatch();
+    test_smpte();
+    test_timestamps();
+    test_timerangeset();
+    test_ltc();
+    test_timer_drift();
+    test_timer_virtual();
+    test_histogram();
+    test_realtime();
+    return 0;
+}
@@ -0,0 +1,801 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avbackend.h"
+#include "avcache.h"
+#include "avclock.h"
+#include "avdpxbackend.h"
+#include "avfps.h"
+#include "avframepool.h"
+#include "avpatternbackend.h"
+#include "avpipeline.h"
+#include "avreader.h"
+#include "avsequencebackend.h"
+#include "avtime.h"
+#include "avtimerange.h"
+#include "avunpack.h"
+#include "avy4mbackend.h"
+#if defined(Q_OS_MACOS)
+#include "avfoundationbackend.h"
+#endif
+
+#include <QColor>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtEndian>
+
+#include <QDebug>
+#include <cstring>
+
+// backends, pipeline, cache and frame pool against files written to a temporary dir and generated
+// patterns, built with QT_FORCE_ASSERTS so a failed check aborts in release builds as well
+
+class TestBackend : public AVBackend {
+    public:
+        TestBackend(bool accept) : accept(accept) {}
+        QString name() const override { return accept ? "test" : "reject"; }
+        bool probe(const QString& filename) const override { Q_UNUSED(filename); return accept; }
+        bool open(const QString& filename) override { Q_UNUSED(filename); return true; }
+        void close() override {}
+        bool seek(const AVTime& time) override { Q_UNUSED(time); return true; }
+        bool read(QImage& image, AVTime& time) override { Q_UNUSED(image); Q_UNUSED(time); return true; }
+        bool drop(AVTime& time) override { Q_UNUSED(time); return true; }
+        AVBackend::Info info() const override { return AVBackend::Info(); }
+        AVReader::Error error() const override { return AVReader::NO_ERROR; }
+        QString error_message() const override { return QString(); }
+        bool accept;
+};
+
+void test_backend() {
+    qDebug() << "Testing backend";
+    {
+        AVBackend::add("reject", { "tst" }, [] { return new TestBackend(false); });
+        AVBackend::add("test", { "TST", "tst2" }, [] { return new TestBackend(true); });
+        Q_ASSERT("registered" && AVBackend::names().contains("test") && AVBackend::extensions().contains("tst2"));
+        Q_ASSERT("extensions are unique" && AVBackend::extensions().count("tst") == 1);
+        QScopedPointer<AVBackend> backend(AVBackend::create("/tmp/clip.0001.TST"));
+        Q_ASSERT("probe falls through to the next backend" && backend && backend->name() == "test");
+        QScopedPointer<AVBackend> unknown(AVBackend::create("/tmp/clip.unknown"));
+        Q_ASSERT("unsupported extension" && !unknown);
+        AVReader reader;
+        Q_ASSERT("reader supports registered extensions" && reader.is_supported("tst2"));
+        reader.open("/tmp/clip.unknown");
+        Q_ASSERT("no backend is a file error" && reader.error() == AVReader::FILE_ERROR && reader.is_closed());
+    }
+}
+
+void test_y4m() {
+    qDebug() << "Testing y4m";
+    QTemporaryDir dir;
+    Q_ASSERT("temporary dir" && dir.isValid());
+    {
+        // 4x2 420 frames, uniform headers and the arithmetic index
+        QString filename = dir.filePath("uniform.y4m");
+        QFile file(filename);
+        file.open(QIODevice::WriteOnly);
+        file.write("YUV4MPEG2 W4 H2 F24000:1001 Ip A1:1 C420jpeg\n");
+        for (int frame = 0; frame < 3; frame++) {
+            file.write("FRAME\n");
+            file.write(QByteArray(8, char(16 + frame * 100))); // luma
+            file.write(QByteArray(2, char(128)));
+            file.write(QByteArray(2, char(128)));
+        }
+        file.close();
+
+        AVY4mBackend backend;
+        bool probed = backend.probe(filename);
+        Q_ASSERT("probe" && probed);
+        bool opened = backend.open(filename);
+        Q_ASSERT("open" && opened);
+        Q_ASSERT("count" && backend.count() == 3 && backend.frame_bytes() == 12);
+        Q_ASSERT("fps" && backend.info().fps == AVFps::fps_23_976());
+        Q_ASSERT("range" && backend.info().range.duration().frames() == 3);
+        AVY4mBackend::Frame view = backend.frame(1);
+        Q_ASSERT("view into the mapping" && view.planes[0][0] == 116 && view.planes[1][0] == 128 && view.time.frames() == 1);
+        QImage image;
+        AVTime time;
+        bool seeked = backend.seek(AVTime(backend.info().start, backend.info().start.ticks(2)));
+        Q_ASSERT("seek" && seeked);
+        bool read = backend.read(image, time);
+        Q_ASSERT("read" && read && time.frames() == 2);
+        Q_ASSERT("converted" && image.width() == 4 && image.height() == 2 && qGray(image.pixel(0, 0)) == 233);
+        read = backend.read(image, time);
+        Q_ASSERT("read past end" && !read);
+        backend.close();
+        Q_ASSERT("view outlives close" && view.planes[0][0] == 116);
+    }
+    {
+        // frame headers with parameters, scanned index and 10-bit mono
+        QString filename = dir.filePath("scanned.y4m");
+        QFile file(filename);
+        file.open(QIODevice::WriteOnly);
+        file.write("YUV4MPEG2 W2 H2 F25:1 Cmono10 XCOLORRANGE=FULL\n");
+        for (int frame = 0; frame < 2; frame++) {
+            file.write(frame ? "FRAME Ixyz\n" : "FRAME\n");
+            for (int sample = 0; sample < 4; sample++) {
+                quint16 value = qToLittleEndian(quint16(frame ? 1023 : 0));
+                file.write(reinterpret_cast<const char*>(&value), 2);
+            }
+        }
+        file.close();
+
+        AVReader reader;
+        reader.open(filename);
+        Q_ASSERT("opened by the registry" && reader.error() == AVReader::NO_ERROR && reader.backend() == "y4m");
+        Q_ASSERT("fps" && reader.fps() == AVFps::fps_25() && reader.range().duration().frames() == 2);
+        QImage last;
+        QObject::connect(&reader, &AVReader::video_changed, [&](const QImage& image) { last = image; });
+        reader.seek(AVTime(reader.range().start(), reader.range().start().ticks(1)));
+        reader.read();
+        Q_ASSERT("full range white" && last.pixel(1, 1) == qRgb(255, 255, 255));
+    }
+    {
+        // y'cbcr rows, every kernel against the scalar reference
+        QList<quint16> samples;
+        quint32 seed = 1;
+        for (int i = 0; i < 3 * 67; i++) {
+            seed = seed * 1664525 + 1013904223;
+            samples.append(static_cast<quint16>(seed >> 16));
+        }
+        QList<quint8> samples8;
+        for (quint16 sample : samples) {
+            samples8.append(static_cast<quint8>(sample));
+        }
+        AVUnpack::Yuv yuv;
+        yuv.cy = qRound(255.0 / 219.0 * 16384);
+        yuv.crr = qRound(1.5748 * 255.0 / 224.0 * 16384);
+        yuv.cgb = qRound(0.187324 * 255.0 / 224.0 * 16384);
+        yuv.cgr = qRound(0.468124 * 255.0 / 224.0 * 16384);
+        yuv.cbb = qRound(1.8556 * 255.0 / 224.0 * 16384);
+        AVUnpack::Kernel selected = AVUnpack::kernel();
+        for (int depth : { 8, 10, 16 }) {
+            QList<quint16> wide = samples;
+            for (quint16& sample : wide) {
+                sample = depth == 16 ? sample : sample & ((1 << depth) - 1);
+            }
+            yuv.shift = depth - 8;
+            for (int xshift : { 0, 1 }) {
+                yuv.xshift = xshift;
+                for (bool mono : { false, true }) {
+                    for (qsizetype count : { qsizetype(0), qsizetype(1), qsizetype(7), qsizetype(67) }) {
+                        QList<quint32> expected(68, 0);
+                        const quint16* y = wide.constData();
+                        const quint16* cb = mono ? nullptr : y + 67;
+                        const quint16* cr = mono ? nullptr : y + 134;
+                        const quint8* y8 = samples8.constData();
+                        const quint8* cb8 = mono ? nullptr : y8 + 67;
+                        const quint8* cr8 = mono ? nullptr : y8 + 134;
+                        if (depth == 8) {
+                            AVUnpack::yuv_argb32_scalar(y8, cb8, cr8, count, yuv, expected.data());
+                        }
+                        else {
+                            AVUnpack::yuv_argb32_scalar(y, cb, cr, count, yuv, expected.data());
+                        }
+                        for (AVUnpack::Kernel kernel : { AVUnpack::SCALAR, AVUnpack::SSE41, AVUnpack::AVX2, AVUnpack::NEON }) {
+                            if (!AVUnpack::supported(kernel)) {
+                                continue;
+                            }
+                            AVUnpack::set_kernel(kernel);
+                            QList<quint32> argb(68, 0);
+                            if (depth == 8) {
+                                AVUnpack::yuv_argb32(y8, cb8, cr8, count, yuv, argb.data());
+                            }
+                            else {
+                                AVUnpack::yuv_argb32(y, cb, cr, count, yuv, argb.data());
+                            }
+                            Q_ASSERT("yuv kernel matches scalar" && argb == expected);
+                        }
+                    }
+                }
+            }
+        }
+        AVUnpack::set_kernel(selected);
+    }
+}
+
+class RecordingSequenceBackend : public AVSequenceBackend {
+    public:
+        ~RecordingSequenceBackend() override { close(); }
+        QList<QString> decoded() const { QMutexLocker locker(&mutex); return paths; }
+
+    protected:
+        QImage decode(const QString& path) const override {
+            {
+                QMutexLocker locker(&mutex);
+                paths.append(path);
+            }
+            return AVSequenceBackend::decode(path);
+        }
+        mutable QMutex mutex;
+        mutable QList<QString> paths;
+};
+
+void test_sequence() {
+    qDebug() << "Testing sequence";
+    QTemporaryDir dir;
+    Q_ASSERT("temporary dir" && dir.isValid());
+    {
+        for (int frame : { 1001, 1003, 1004 }) { // 1002 is missing
+            QImage image(8, 4, QImage::Format_RGB32);
+            image.fill(qRgb(frame - 1000, 0, 0));
+            image.save(dir.filePath(QString("shot.%1.png").arg(frame, 4, 10, QChar('0'))));
+        }
+        QImage(8, 4, QImage::Format_RGB32).save(dir.filePath("shot.1.png")); // unpadded, not part of the sequence
+
+        AVSequenceBackend backend;
+        backend.set_threads(2);
+        bool probed = backend.probe(dir.filePath("shot.1003.png"));
+        Q_ASSERT("probe" && probed);
+        bool opened = backend.open(dir.filePath("shot.1003.png"));
+        Q_ASSERT("open" && opened);
+        Q_ASSERT("pattern" && backend.pattern() == "shot.####.png");
+        Q_ASSERT("frames" && backend.first() == 1001 && backend.count() == 4 && backend.missing() == 1);
+        Q_ASSERT("missing holds previous" && backend.path(1) == backend.path(0));
+        Q_ASSERT("range starts at the first frame number" && backend.info().range.start().frames() == 1001);
+        QImage image;
+        AVTime time;
+        QList<int> reds;
+        for (qint64 frame = 0; frame < backend.count(); frame++) {
+            bool read = backend.read(image, time);
+            Q_ASSERT("read" && read);
+            Q_ASSERT("ordered delivery" && time.frames() == 1001 + frame);
+            reds.append(qRed(image.pixel(0, 0)));
+        }
+        Q_ASSERT("decoded in order" && reds == QList<int>({ 1, 1, 3, 4 }));
+        bool read = backend.read(image, time);
+        Q_ASSERT("read past end" && !read);
+        AVTime start = backend.info().range.start();
+        bool seeked = backend.seek(AVTime(start, start.ticks(1003)));
+        Q_ASSERT("seek back" && seeked);
+        read = backend.read(image, time);
+        Q_ASSERT("read after seek" && read && time.frames() == 1003 && qRed(image.pixel(0, 0)) == 3);
+    }
+    {
+        // forward playback after a backward seek decodes ahead again
+        for (int frame = 1; frame <= 8; frame++) {
+            QImage image(8, 4, QImage::Format_RGB32);
+            image.fill(qRgb(frame, 0, 0));
+            image.save(dir.filePath(QString("take.%1.png").arg(frame, 4, 10, QChar('0'))));
+        }
+        RecordingSequenceBackend backend;
+        backend.set_threads(2);
+        backend.set_readahead(2);
+        bool opened = backend.open(dir.filePath("take.0001.png"));
+        Q_ASSERT("open" && opened && backend.count() == 8);
+        QImage image;
+        AVTime time;
+        for (int frame = 0; frame < 4; frame++) {
+            bool read = backend.read(image, time);
+            Q_ASSERT("read" && read);
+        }
+        qsizetype mark = backend.decoded().size(); // frames 0-3 are decoded, 4 and 5 may still be in flight
+        AVTime start = backend.info().range.start();
+        bool seeked = backend.seek(AVTime(start, start.ticks(1)));
+        Q_ASSERT("seek back" && seeked);
+        for (int frame = 0; frame < 2; frame++) {
+            bool read = backend.read(image, time);
+            Q_ASSERT("read after seek" && read && time.frames() == 1 + frame && qRed(image.pixel(0, 0)) == 1 + frame);
+        }
+        QElapsedTimer timer;
+        timer.start();
+        bool ahead = false;
+        while (!ahead && timer.elapsed() < 1000) {
+            QList<QString> decoded = backend.decoded().mid(mark);
+            ahead = decoded.contains(backend.path(2)) && decoded.contains(backend.path(3));
+            if (!ahead) {
+                QThread::msleep(1);
+            }
+        }
+        Q_ASSERT("decodes ahead after stepping forward" && ahead);
+        for (int frame = 2; frame < 8; frame++) {
+            bool read = backend.read(image, time);
+            Q_ASSERT("forward playback" && read && qRed(image.pixel(0, 0)) == 1 + frame);
+        }
+    }
+    {
+        AVReader reader;
+        reader.open(dir.filePath("shot.1004.png"));
+        Q_ASSERT("opened by the registry" && reader.error() == AVReader::NO_ERROR && reader.backend() == "sequence");
+        Q_ASSERT("timecode from frame numbers" && reader.range().start().frames() == 1001);
+    }
+}
+
+void test_dpx() {
+    qDebug() << "Testing dpx";
+    {
+        QList<quint32> words;
+        quint32 seed = 1;
+        for (int i = 0; i < 67; i++) { // odd count, every kernel runs its tail
+            seed = seed * 1664525 + 1013904223;
+            words.append(seed);
+        }
+        AVUnpack::Kernel selected = AVUnpack::kernel();
+        for (AVUnpack::Packing packing : { AVUnpack::METHOD_A, AVUnpack::METHOD_B }) {
+            for (bool swap : { false, true }) {
+                QList<quint16> expected(words.size() * 4);
+                QList<float> expectedf(words.size() * 4);
+                AVUnpack::unpack10_scalar(words.constData(), words.size(), packing, swap, expected.data());
+                AVUnpack::unpack10_scalar(words.constData(), words.size(), packing, swap, expectedf.data());
+                for (AVUnpack::Kernel kernel : { AVUnpack::SCALAR, AVUnpack::SSE41, AVUnpack::AVX2, AVUnpack::NEON }) {
+                    if (!AVUnpack::supported(kernel)) {
+                        continue;
+                    }
+                    AVUnpack::set_kernel(kernel);
+                    for (qsizetype count : { qsizetype(0), qsizetype(1), qsizetype(7), words.size() }) {
+                        QList<quint16> rgbx(words.size() * 4, 0);
+                        QList<float> rgbxf(words.size() * 4, 0.0f);
+                        AVUnpack::unpack10(words.constData(), count, packing, swap, rgbx.data());
+                        AVUnpack::unpack10(words.constData(), count, packing, swap, rgbxf.data());
+                        Q_ASSERT("kernel matches scalar" && rgbx.mid(0, count * 4) == expected.mid(0, count * 4));
+                        Q_ASSERT("float kernel matches scalar" && rgbxf.mid(0, count * 4) == expectedf.mid(0, count * 4));
+                        Q_ASSERT("no write past count" && (count == words.size() || rgbx[count * 4] == 0));
+                    }
+                }
+                quint32 word = swap ? qbswap(words[0]) : words[0];
+                quint32 red = packing == AVUnpack::METHOD_A ? word >> 22 : (word >> 20) & 0x3ff;
+                Q_ASSERT("red component" && expected[0] >> 6 == red && expected[3] == 0xffff);
+                Q_ASSERT("float range" && expectedf[0] == red / 1023.0f && expectedf[3] == 1.0f);
+            }
+        }
+        AVUnpack::set_kernel(selected);
+    }
+    QTemporaryDir dir;
+    Q_ASSERT("temporary dir" && dir.isValid());
+    auto write = [&](const QString& name, bool bigendian, qint32 frame, quint16 packing) {
+        const int width = 5;
+        const int height = 2;
+        const quint32 offset = 2048;
+        QByteArray data(offset + width * height * 4, 0);
+        auto u32 = [&](int position, quint32 value) {
+            if (bigendian) {
+                qToBigEndian(value, data.data() + position);
+            }
+            else {
+                qToLittleEndian(value, data.data() + position);
+            }
+        };
+        auto u16 = [&](int position, quint16 value) {
+            if (bigendian) {
+                qToBigEndian(value, data.data() + position);
+            }
+            else {
+                qToLittleEndian(value, data.data() + position);
+            }
+        };
+        auto f32 = [&](int position, float value) {
+            quint32 bits;
+            std::memcpy(&bits, &value, 4);
+            u32(position, bits);
+        };
+        data.replace(0, 4, bigendian ? "SDPX" : "XPDS");
+        u32(4, offset);
+        data.replace(160, 7, "flipman");
+        u32(772, width);
+        u32(776, height);
+        data[800] = char(50); // rgb
+        data[803] = char(10);
+        u16(804, packing); // 1 for method a
+        u32(808, offset);
+        u32(812, 0);
+        u32(1920, 0x01000000 | quint32(frame)); // 01:00:00:ff, bcd
+        f32(1724, 25.0f);
+        for (int i = 0; i < width * height; i++) {
+            quint32 value = 1023u << 22 | quint32(i) << 12 | 0u << 2; // red white, green the pixel index
+            u32(offset + i * 4, value);
+        }
+        QFile file(dir.filePath(name));
+        file.open(QIODevice::WriteOnly);
+        file.write(data);
+    };
+    write("plate.0001.dpx", true, 0x00, 1);
+    write("plate.0002.dpx", false, 0x01, 1);
+    {
+        AVDpxBackend backend;
+        bool probed = backend.probe(dir.filePath("plate.0001.dpx"));
+        Q_ASSERT("probe" && probed);
+        bool opened = backend.open(dir.filePath("plate.0001.dpx"));
+        Q_ASSERT("open" && opened);
+        Q_ASSERT("frames" && backend.count() == 2);
+        AVBackend::Info info = backend.info();
+        Q_ASSERT("film frame rate" && info.fps == AVFps::fps_25());
+        Q_ASSERT("timecode" && AVTime::convert(info.start, info.fps).frames() + info.range.start().frames() == 25 * 3600);
+        QImage image;
+        AVTime time;
+        for (int frame = 0; frame < 2; frame++) { // big then little endian
+            bool read = backend.read(image, time);
+            Q_ASSERT("read" && read);
+            Q_ASSERT("format" && image.format() == QImage::Format_RGBX64 && image.size() == QSize(5, 2));
+            const quint16* rgbx = reinterpret_cast<const quint16*>(image.constScanLine(1));
+            Q_ASSERT("unpacked" && rgbx[4 * 2 + 0] == 0xffff && rgbx[4 * 2 + 1] >> 6 == 7 && rgbx[4 * 2 + 2] == 0);
+        }
+    }
+    {
+        // packing is checked per file, inspect() only sees the first
+        write("mixed.0001.dpx", true, 0x00, 1);
+        write("mixed.0002.dpx", true, 0x01, 0);
+        AVDpxBackend backend;
+        bool opened = backend.open(dir.filePath("mixed.0001.dpx"));
+        Q_ASSERT("open" && opened && backend.count() == 2);
+        QImage image;
+        AVTime time;
+        bool read = backend.read(image, time);
+        Q_ASSERT("supported packing" && read);
+        read = backend.read(image, time);
+        Q_ASSERT("unsupported packing" && !read && backend.error() == AVReader::API_ERROR);
+    }
+    {
+        AVReader reader;
+        reader.open(dir.filePath("plate.0002.dpx"));
+        Q_ASSERT("opened by the registry" && reader.error() == AVReader::NO_ERROR && reader.backend() == "dpx");
+        Q_ASSERT("fps from header" && reader.fps() == AVFps::fps_25());
+    }
+}
+
+void test_pattern() {
+    qDebug() << "Testing pattern";
+    QTemporaryDir dir;
+    Q_ASSERT("temporary dir" && dir.isValid());
+    {
+        AVPatternBackend backend;
+        bool opened = backend.open(dir.filePath("bench_256x64_25fps_2s_rgba16.pattern"));
+        Q_ASSERT("open without a file" && opened);
+        Q_ASSERT("size" && backend.size() == QSize(256, 64) && backend.format() == QImage::Format_RGBA64);
+        Q_ASSERT("duration" && backend.count() == 50 && backend.info().fps == AVFps::fps_25());
+        QImage image;
+        AVTime time;
+        QList<const uchar*> buffers;
+        QList<QImage> strips;
+        for (qint64 frame = 0; frame < 10; frame++) {
+            bool read = backend.read(image, time);
+            Q_ASSERT("read" && read);
+            Q_ASSERT("time" && time.frames() == frame);
+            Q_ASSERT("barcode" && AVPatternBackend::barcode(image) == frame);
+            if (!buffers.contains(image.constBits())) {
+                buffers.append(image.constBits());
+            }
+            strips.append(image.copy(0, 32, 256, 8));
+        }
+        Q_ASSERT("frames recycled" && buffers.size() == 2);
+        Q_ASSERT("bars move" && strips[0] != strips[1]);
+        bool seeked = backend.seek(AVTime(42, AVFps::fps_25()));
+        bool read = backend.read(image, time);
+        Q_ASSERT("seek" && seeked && read);
+        Q_ASSERT("barcode after seek" && time.frames() == 42 && AVPatternBackend::barcode(image) == 42);
+        QImage first = image.copy();
+        backend.seek(AVTime(42, AVFps::fps_25()));
+        backend.read(image, time);
+        Q_ASSERT("deterministic" && image == first);
+        backend.seek(AVTime(49, AVFps::fps_25()));
+        bool last = backend.read(image, time);
+        bool past = backend.read(image, time);
+        Q_ASSERT("last" && last && !past);
+    }
+    {
+        AVPatternBackend backend;
+        bool opened = backend.open(dir.filePath("float_512x128_8f_rgba32f.pattern"));
+        Q_ASSERT("float format" && opened);
+        QImage image;
+        AVTime time;
+        backend.seek(AVTime(7, AVFps::fps_24()));
+        bool read = backend.read(image, time);
+        Q_ASSERT("float barcode" && read && AVPatternBackend::barcode(image) == 7);
+        opened = backend.open(dir.filePath("huge_16384x8192.pattern"));
+        Q_ASSERT("too large" && !opened);
+    }
+    {
+        AVReader reader;
+        reader.open(dir.filePath("bench_3840x2160_23.976fps_10s.pattern"));
+        Q_ASSERT("opened by the registry" && reader.error() == AVReader::NO_ERROR && reader.backend() == "pattern");
+        Q_ASSERT("fps" && reader.fps() == AVFps::fps_23_976());
+    }
+}
+
+void test_pipeline() {
+    qDebug() << "Testing pipeline";
+    QTemporaryDir dir;
+    Q_ASSERT("temporary dir" && dir.isValid());
+    AVPatternBackend backend;
+    bool opened = backend.open(dir.filePath("pipeline_256x64_40f_rgba16.pattern"));
+    Q_ASSERT("open" && opened);
+    AVPipeline pipeline;
+    pipeline.set_depth(4);
+    pipeline.set_format(QImage::Format_RGBA8888);
+    Q_ASSERT("convert workers" && pipeline.threads() == 2);
+    {
+        pipeline.start(&backend, 0, 40);
+        AVPipeline::Frame ready;
+        bool taken = pipeline.take(0, ready);
+        Q_ASSERT("take" && taken);
+        QThread::msleep(50); // decode runs ahead, bounded by the depth
+        Q_ASSERT("backpressure" && pipeline.buffered() <= 4);
+        for (qint64 frame = 1; frame < 10; frame++) {
+            taken = pipeline.take(frame, ready);
+            Q_ASSERT("in order" && taken && ready.frame == frame);
+            Q_ASSERT("time" && ready.time.frames() == frame);
+            Q_ASSERT("converted" && ready.image.format() == QImage::Format_RGBA8888);
+            Q_ASSERT("barcode" && AVPatternBackend::barcode(ready.image) == frame);
+        }
+        qint64 dropped = pipeline.dropped();
+        pipeline.skip(30);
+        taken = pipeline.take(30, ready);
+        Q_ASSERT("skip ahead" && taken && AVPatternBackend::barcode(ready.image) == 30);
+        Q_ASSERT("skipped frames dropped" && pipeline.dropped() >= dropped + 20);
+        for (qint64 frame = 31; frame < 40; frame++) {
+            taken = pipeline.take(frame, ready);
+            Q_ASSERT("to the end" && taken);
+        }
+        taken = pipeline.take(40, ready);
+        Q_ASSERT("past the end" && !taken && pipeline.error() == AVReader::NO_ERROR);
+        pipeline.stop();
+    }
+    {
+        AVTime start = backend.info().range.start();
+        backend.seek(AVTime(start, start.ticks(20)));
+        pipeline.set_format(QImage::Format_Invalid);
+        pipeline.start(&backend, 20, 40);
+        AVPipeline::Frame ready;
+        bool taken = pipeline.take(20, ready);
+        Q_ASSERT("restart after seek" && taken && AVPatternBackend::barcode(ready.image) == 20);
+        Q_ASSERT("decoded format" && ready.image.format() == QImage::Format_RGBA64);
+        pipeline.stop();
+        taken = pipeline.take(21, ready);
+        Q_ASSERT("stopped" && !pipeline.is_running() && !taken);
+    }
+    {
+        AVTime start = backend.info().range.start();
+        backend.seek(AVTime(start, start.ticks(10)));
+        pipeline.set_format(QImage::Format_RGBA8888);
+        pipeline.set_formats({ QImage::Format_RGBA64 });
+        qint64 copied = pipeline.copied();
+        pipeline.start(&backend, 10, 12);
+        AVPipeline::Frame ready;
+        bool taken = pipeline.take(10, ready);
+        Q_ASSERT("presentable format kept" && taken && ready.image.format() == QImage::Format_RGBA64);
+        Q_ASSERT("not copied" && pipeline.copied() == copied);
+        pipeline.stop();
+        pipeline.set_formats({});
+        pipeline.set_format(QImage::Format_Invalid);
+    }
+    {
+        AVTime start = backend.info().range.start();
+        backend.seek(AVTime(start, start.ticks(38)));
+        pipeline.start(&backend, 38, 45); // range past the last frame, the backend fails
+        AVPipeline::Frame ready;
+        bool taken = pipeline.take(38, ready);
+        Q_ASSERT("last frames" && taken);
+        taken = pipeline.take(39, ready);
+        Q_ASSERT("last frames" && taken);
+        taken = pipeline.take(40, ready);
+        Q_ASSERT("decode error" && !taken && pipeline.error() == AVReader::API_ERROR);
+        pipeline.stop();
+    }
+}
+
+void test_cache() {
+    qDebug() << "Testing cache";
+    {
+        AVFps fps = AVFps::fps_24();
+        QImage image(16, 16, QImage::Format_RGBA8888); // 1024 bytes
+        image.fill(Qt::red);
+        AVCache cache;
+        cache.set_budget(4 * image.sizeInBytes());
+        for (qint64 frame = 0; frame < 4; frame++) {
+            bool inserted = cache.insert(AVTime(frame, fps), image);
+            Q_ASSERT("insert" && inserted);
+        }
+        Q_ASSERT("resident" && cache.count() == 4 && cache.bytes() == 4 * image.sizeInBytes());
+        QImage found;
+        bool hit = cache.find(AVTime(0, fps), found);
+        Q_ASSERT("hit" && hit && found.constBits() == image.constBits());
+        hit = cache.find(AVTime(9, fps), found);
+        Q_ASSERT("miss" && !hit);
+        Q_ASSERT("hit rate" && cache.hits() == 1 && cache.misses() == 1 && cache.hit_rate() == 0.5);
+        cache.insert(AVTime(4, fps), image); // frame 0 was referenced, gets a second chance
+        Q_ASSERT("evicted" && cache.count() == 4 && cache.contains(AVTime(0, fps)) && !cache.contains(AVTime(1, fps)));
+        cache.set_pinned(AVTimeRange(AVTime(2, fps), AVTime(2, fps))); // frames 2 and 3
+        cache.insert(AVTime(5, fps), image);
+        cache.insert(AVTime(6, fps), image);
+        Q_ASSERT("pinned kept" && cache.contains(AVTime(2, fps)) && cache.contains(AVTime(3, fps)));
+        Q_ASSERT("budget" && cache.bytes() <= cache.budget());
+        cache.set_budget(2 * image.sizeInBytes());
+        Q_ASSERT("only pinned" && cache.count() == 2 && cache.contains(AVTime(2, fps)) && cache.contains(AVTime(3, fps)));
+        bool inserted = cache.insert(AVTime(7, fps), image);
+        Q_ASSERT("pinned fill the budget" && !inserted);
+        cache.clear();
+        Q_ASSERT("cleared" && cache.count() == 0 && cache.bytes() == 0);
+    }
+    {
+        QTemporaryDir dir;
+        Q_ASSERT("temporary dir" && dir.isValid());
+        AVReader reader;
+        reader.open(dir.filePath("cache_256x64_24fps_48f.pattern"));
+        Q_ASSERT("open" && reader.error() == AVReader::NO_ERROR);
+        QImage presented;
+        QObject::connect(&reader, &AVReader::video_changed, [&](const QImage& image) { presented = image; });
+        AVTime start = reader.range().start();
+        for (qint64 frame : { 5, 6, 5, 6, 5 }) {
+            reader.seek(AVTime(start, start.ticks(frame)));
+            reader.read();
+            Q_ASSERT("presented" && reader.error() == AVReader::NO_ERROR && AVPatternBackend::barcode(presented) == frame);
+        }
+        Q_ASSERT("revisits hit" && reader.cache_hit_rate() == 3.0 / 5.0);
+        Q_ASSERT("resident" && reader.cache_bytes() == 2 * presented.sizeInBytes());
+        reader.seek(AVTime(start, start.ticks(20))); // the backend is positioned again after the hits
+        reader.read();
+        Q_ASSERT("decoded after hits" && AVPatternBackend::barcode(presented) == 20);
+    }
+    {
+        // streaming looks up the cache before the pipeline, a replay decodes nothing
+        QTemporaryDir dir;
+        Q_ASSERT("temporary dir" && dir.isValid());
+        AVVirtualClock clock;
+        AVReader reader;
+        reader.set_clock(&clock);
+        reader.set_everyframe(true);
+        reader.open(dir.filePath("replay_256x64_24fps_12f.pattern"));
+        Q_ASSERT("open" && reader.error() == AVReader::NO_ERROR);
+        QList<qint64> barcodes;
+        QObject::connect(&reader, &AVReader::video_changed, [&](const QImage& image) {
+            barcodes.append(AVPatternBackend::barcode(image));
+        });
+        reader.stream();
+        Q_ASSERT("first pass decoded" && barcodes.size() == 12 && reader.cache_hit_rate() == 0.0);
+        barcodes.clear();
+        reader.seek(reader.range().start());
+        reader.stream();
+        QList<qint64> expected;
+        for (qint64 frame = 0; frame < 12; frame++) {
+            expected.append(frame);
+        }
+        Q_ASSERT("replay in order" && barcodes == expected && reader.error() == AVReader::NO_ERROR);
+        Q_ASSERT("replay from the cache" && reader.cache_hit_rate() == 0.5);
+    }
+    {
+        // cached frames hold their pooled buffers, the pool recycles once the budget evicts
+        QTemporaryDir dir;
+        Q_ASSERT("temporary dir" && dir.isValid());
+        AVPatternBackend backend;
+        bool opened = backend.open(dir.filePath("pool_256x64_24fps_40f_rgba16.pattern"));
+        Q_ASSERT("open" && opened);
+        AVFramePool pool = backend.pool();
+        AVCache cache;
+        QImage image;
+        AVTime time;
+        for (qint64 frame = 0; frame < 4; frame++) {
+            backend.read(image, time);
+            cache.set_budget(4 * image.sizeInBytes());
+            cache.insert(time, image);
+        }
+        Q_ASSERT("a buffer per cached frame" && pool.allocations() == 4 && pool.reuses() == 0);
+        for (qint64 frame = 4; frame < 40; frame++) {
+            backend.read(image, time);
+            Q_ASSERT("pooled frame" && AVPatternBackend::barcode(image) == frame);
+            cache.insert(time, image);
+        }
+        Q_ASSERT("recycled after eviction" && pool.allocations() <= 6 && pool.reuses() == 40 - pool.allocations());
+    }
+}
+
+void test_framepool() {
+    qDebug() << "Testing frame pool";
+    {
+        Q_ASSERT("stride" && AVFramePool::stride(1, QImage::Format_ARGB32) == 64);
+        Q_ASSERT("stride" && AVFramePool::stride(1920, QImage::Format_ARGB32) == 7680);
+        Q_ASSERT("stride" && AVFramePool::stride(2, QImage::Format_RGBX64) == 64);
+        Q_ASSERT("stride" && AVFramePool::stride(100, QImage::Format_RGBX64) == 832);
+    }
+    {
+        AVFramePool pool;
+        QSize size(250, 32); // rows padded to 1024 bytes
+        {
+            QImage image = pool.image(size, QImage::Format_ARGB32);
+            Q_ASSERT("image" && !image.isNull() && image.size() == size && image.format() == QImage::Format_ARGB32);
+            Q_ASSERT("aligned" && reinterpret_cast<quintptr>(image.constBits()) % 64 == 0 && image.bytesPerLine() % 64 == 0);
+            Q_ASSERT("aligned rows" && reinterpret_cast<quintptr>(image.constScanLine(1)) % 64 == 0);
+            image.fill(Qt::red);
+            Q_ASSERT("in use" && pool.available() == 0);
+        }
+        Q_ASSERT("returned" && pool.available() == 1 && pool.allocations() == 1);
+        QList<QImage> inflight;
+        for (int i = 0; i < 100; i++) { // a stream three frames deep
+            inflight.append(pool.image(size, QImage::Format_ARGB32));
+            if (inflight.size() > 3) {
+                inflight.removeFirst();
+            }
+        }
+        Q_ASSERT("flat after warm-up" && pool.allocations() == 4 && pool.reuses() == 97);
+        {
+            QImage shared = inflight.first();
+            inflight.clear();
+            Q_ASSERT("shared copy holds the buffer" && pool.available() == 3);
+        }
+        Q_ASSERT("all returned" && pool.available() == 4);
+        pool.set_limit(2);
+        Q_ASSERT("limit" && pool.available() == 2 && pool.bytes() == 2 * 1024 * 32);
+        pool.clear();
+        Q_ASSERT("cleared" && pool.available() == 0 && pool.bytes() == 0);
+    }
+    {
+        QImage image;
+        {
+            AVFramePool pool;
+            image = pool.image(QSize(128, 32), QImage::Format_RGBX64);
+            image.fill(Qt::green);
+        }
+        Q_ASSERT("outlives the pool" && image.pixelColor(127, 31) == QColor(Qt::green));
+    }
+}
+
+#if defined(Q_OS_MACOS)
+void test_avfoundation() {
+    qDebug() << "Testing avfoundation";
+    QString filename = qEnvironmentVariable("FLIPMAN_TEST_MOVIE"); // a movie with inter frames, none ships with the tree
+    if (filename.isEmpty()) {
+        qDebug() << "skipped, FLIPMAN_TEST_MOVIE is not set";
+        return;
+    }
+    AVFoundationBackend backend;
+    bool opened = backend.open(filename);
+    Q_ASSERT("open" && opened);
+    QList<QImage> frames;
+    QList<AVTime> times;
+    for (qint64 frame = 0; frame < 48; frame++) {
+        QImage image;
+        AVTime time;
+        if (!backend.read(image, time)) {
+            break;
+        }
+        frames.append(image.copy());
+        times.append(time);
+    }
+    Q_ASSERT("sequential read" && frames.size() > 12);
+    bool seeked = backend.seek(times[0]);
+    Q_ASSERT("seek to start" && seeked);
+    qint64 position = 0;
+    for (qint64 step : { 1, 2, 3, 1, 5, 2 }) { // short forward seeks, the running reader decodes on
+        qint64 target = position + step;
+        if (target >= frames.size()) {
+            break;
+        }
+        seeked = backend.seek(times[target]);
+        QImage image;
+        AVTime time;
+        bool read = backend.read(image, time);
+        Q_ASSERT("forward seek" && seeked && read);
+        Q_ASSERT("same frame as sequential" && time == times[target] && image == frames[target]);
+        position = target + 1;
+    }
+    if (backend.samples() > 0) {
+        Q_ASSERT("reader reused" && backend.seek_reuses().count() > 0);
+    }
+    seeked = backend.seek(times[2]); // backward, restarts the reader
+    QImage image;
+    AVTime time;
+    bool read = backend.read(image, time);
+    Q_ASSERT("backward seek" && seeked && read && time == times[2] && image == frames[2]);
+    Q_ASSERT("reader rebuilt" && backend.seek_rebuilds().count() > 0);
+}
+#endif
+
+int
+main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    test_backend();
+    test_y4m();
+    test_sequence();
+    test_dpx();
+    test_pattern();
+    test_pipeline();
+    test_cache();
+    test_framepool();
+#if defined(Q_OS_MACOS)
+    test_avfoundation();
+#endif
+    return 0;
+}
@@ -50,7 +50,7 @@ class FlipbookPrivate : public QObject
         void set_video(const QImage& image);
         void set_audio(const QByteArray& buffer);
         void set_time(const AVTime& time);
-        void set_timecode(const AVSmpteTime& timecode);
+        void set_timecode(const AVTime& timecode);
         void set_actual_fps(float fps);
         void fullscreen(bool checked);
         void loop(bool checked);
@@ -84,7 +84,7 @@ class FlipbookPrivate : public QObject
         }
         void run_stream() {
             if (!future.isRunning()) {
-                future = QtConcurrent::run([&] {
+                future = QtConcurrent::run(&streampool, [&] {
                     reader->stream();
                 });
             }
@@ -110,6 +110,7 @@ class FlipbookPrivate : public QObject
         };
         State state;
         QFuture<void> future;
+        QThreadPool streampool; // dedicated streaming thread, realtime settings never leak into the global pool
         QFutureWatcher<void> watcher;
         QScopedPointer<AVReader> reader;
         QPointer<Flipbook> window;
@@ -125,6 +126,8 @@ void
 FlipbookPrivate::init()
 {
     platform.reset(new Platform());
+    streampool.setMaxThreadCount(1);
+    streampool.setExpiryTimeout(-1);
     // ui
     ui.reset(new Ui_Flipbook());
     ui->setupUi(window.data());
@@ -132,6 +135,8 @@ FlipbookPrivate::init()
     window->installEventFilter(this);
     // reader
     reader.reset(new AVReader());
+    reader->set_format(QImage::Format_RGBA8888); // texture format, converted before it reaches the ui thread
+    reader->set_formats(RhiWidget::formats()); // uploaded as decoded
     // connect
     connect(ui->menu_open, &QAction::triggered, this, &FlipbookPrivate::open);
     connect(ui->menu_start, &QAction::triggered, this, &FlipbookPrivate::seek_start);
@@ -398,9 +403,10 @@ FlipbookPrivate::set_time(const AVTime& time)
 }
 
 void
-FlipbookPrivate::set_timecode(const AVSmpteTime& timecode)
+FlipbookPrivate::set_timecode(const AVTime& timecode)
 {
-    ui->timecode->setText(timecode.to_string());
+    char buffer[AVSmpteTime::max_chars];
+    ui->timecode->setText(QString::fromLatin1(buffer, AVSmpteTime::to_chars(timecode, buffer, sizeof(buffer))));
 }
 
 void
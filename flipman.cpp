@@ -54,7 +54,7 @@ class FlipmanPrivate : public QObject
         void set_video(const QImage& image);
         void set_audio(const QByteArray& buffer);
         void set_time(const AVTime& time);
-        void set_timecode(const AVTime& time);
+        void set_timecode(const AVTime& timecode);
         void set_actual_fps(float fps);
         void fullscreen(bool checked);
         void loop(bool checked);
@@ -92,7 +92,7 @@ class FlipmanPrivate : public QObject
         }
         void run_stream() {
             if (!future.isRunning()) {
-                future = QtConcurrent::run([&] {
+                future = QtConcurrent::run(&streampool, [&] {
                     reader->stream();
                 });
             }
@@ -121,6 +121,7 @@ class FlipmanPrivate : public QObject
         State state;
         QStringList arguments;
         QFuture<void> future;
+        QThreadPool streampool; // dedicated streaming thread, realtime settings never leak into the global pool
         QFutureWatcher<void> watcher;
         QScopedPointer<AVReader> reader;
         QPointer<Flipman> window;
@@ -136,6 +137,8 @@ void
 FlipmanPrivate::init()
 {
     platform.reset(new Platform());
+    streampool.setMaxThreadCount(1);
+    streampool.setExpiryTimeout(-1);
     // ui
     ui.reset(new Ui_Flipman());
     ui->setupUi(window.data());
@@ -143,6 +146,8 @@ FlipmanPrivate::init()
     window->installEventFilter(this);
     // reader
     reader.reset(new AVReader());
+    reader->set_format(QImage::Format_RGBA8888); // texture format, converted before it reaches the ui thread
+    reader->set_formats(RhiWidget::formats()); // uploaded as decoded
     // connect
     connect(ui->menu_open, &QAction::triggered, this, &FlipmanPrivate::open);
     connect(ui->menu_start, &QAction::triggered, this, &FlipmanPrivate::seek_start);
@@ -197,6 +202,7 @@ FlipmanPrivate::init()
     connect(reader.data(), &AVReader::loop_changed, ui->menu_loop, &QAction::setChecked);
     connect(reader.data(), &AVReader::loop_changed, ui->tool_loop, &QPushButton::setChecked);
     connect(reader.data(), &AVReader::time_changed, ui->timeline, &Timeline::set_time);
+    connect(reader.data(), &AVReader::timestamps_changed, ui->timeline, &Timeline::set_timestamps);
     // platform
     connect(platform.data(), &Platform::power_changed, this, &FlipmanPrivate::power);
 }
@@ -366,7 +372,13 @@ FlipmanPrivate::seek_frame(qint64 frame)
 {
     stop();
     AVTime time = reader->time();
-    run_seek(AVTime(time.ticks(time.frames() + frame), time.timescale(), time.fps()));
+    AVTimestamps timestamps = ui->timeline->timestamps(); // delivered by the reader, never loaded here
+    if (timestamps.valid()) {
+        run_seek(AVTime(time, timestamps.ticks(timestamps.frame(time.ticks()) + frame)));
+    }
+    else {
+        run_seek(AVTime(time.ticks(time.frames() + frame), time.timescale(), time.fps()));
+    }
 }
 
 void
@@ -528,6 +540,7 @@ FlipmanPrivate::set_opened(const QString& filename)
         ui->timeline_duration->set_time(range.end());
         ui->timeline->set_time(reader->time());
         ui->timeline->set_range(reader->range());
+        ui->timeline->set_timestamps(AVTimestamps()); // variable frame rates follow from the reader thread
         ui->timeline->setEnabled(true);
     }
     else {
@@ -586,14 +599,16 @@ FlipmanPrivate::set_time(const AVTime& time)
     ui->timecode->set_time(time);
     ui->timeline_start->set_time(time);
     ui->timeline_duration->set_time(reader->range().duration());
-    ui->time_timecode->setText(AVSmpteTime(time).to_string());
+    char buffer[AVSmpteTime::max_chars];
+    ui->time_timecode->setText(QString::fromLatin1(buffer, AVSmpteTime::to_chars(time, buffer, sizeof(buffer))));
 }
 
 void
-FlipmanPrivate::set_timecode(const AVTime& time)
+FlipmanPrivate::set_timecode(const AVTime& timecode)
 {
-    ui->timeline_timecode->setText(AVSmpteTime(time).to_string());
-    ui->timeline_frame->setText(QString::number(time.frames()));
+    char buffer[AVSmpteTime::max_chars];
+    ui->timeline_timecode->setText(QString::fromLatin1(buffer, AVSmpteTime::to_chars(timecode, buffer, sizeof(buffer))));
+    ui->timeline_frame->setText(QString::number(timecode.frames()));
 }
 
 void
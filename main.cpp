@@ -10,14 +10,9 @@
 int
 main(int argc, char* argv[])
 {
-    if (0) {
-        test_time();
-        test_timerange();
-        test_fps();
-        test_smpte();
-    }
-    if (0) {
+    if (0) { // wall clock measurements, the other tests run under ctest
         test_timer();
+        test_timer_wake();
     }
     QApplication app(argc, argv);
     Flipman* flipman = new Flipman();
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avclock.h"
+#include "avfps.h"
+#include "avhistogram.h"
+#include "avrealtime.h"
+#include "avtimer.h"
+
+#include <QAtomicInt>
+#include <QList>
+#include <QRandomGenerator>
+#include <QString>
+#include <QThread>
+
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+
+// paces frames at a rate under an injected load and reports the wake error distribution, late and
+// dropped frames and cpu time of the pacing thread
+//
+// usage: pacing [--fps 23.976] [--duration 60] [--load none|decode|burst|contention] [--mode sleep|spin|yield]
+//               [--margin usecs] [--late usecs] [--realtime none|fifo|rr] [--cpu n]
+
+struct Options
+{
+    AVFps fps = AVFps::fps_23_976();
+    qreal duration = 60.0;
+    QString load = "none";
+    AVTimer::Mode mode = AVTimer::SPIN;
+    quint64 margin = 200000;
+    quint64 late = 1000000;
+    AVRealtime::Policy policy = AVRealtime::DEFAULT;
+    int cpu = -1;
+};
+
+bool
+parse(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        QString key(argv[i]);
+        QString value(argv[i + 1]);
+        if (key == "--fps") {
+            options.fps = AVFps::guess(value.toDouble());
+        }
+        else if (key == "--duration") {
+            options.duration = value.toDouble();
+        }
+        else if (key == "--load") {
+            options.load = value;
+        }
+        else if (key == "--mode") {
+            if (value == "sleep") {
+                options.mode = AVTimer::SLEEP;
+            }
+            else if (value == "spin") {
+                options.mode = AVTimer::SPIN;
+            }
+            else if (value == "yield") {
+                options.mode = AVTimer::YIELD;
+            }
+            else {
+                return false;
+            }
+        }
+        else if (key == "--margin") {
+            options.margin = value.toULongLong() * 1000;
+        }
+        else if (key == "--late") {
+            options.late = value.toULongLong() * 1000;
+        }
+        else if (key == "--realtime") {
+            if (value == "none") {
+                options.policy = AVRealtime::DEFAULT;
+            }
+            else if (value == "fifo") {
+                options.policy = AVRealtime::FIFO;
+            }
+            else if (value == "rr") {
+                options.policy = AVRealtime::RR;
+            }
+            else {
+                return false;
+            }
+        }
+        else if (key == "--cpu") {
+            options.cpu = value.toInt();
+        }
+        else {
+            return false;
+        }
+    }
+    return (argc % 2) == 1 && options.fps.valid() && options.duration > 0 &&
+           QList<QString>({ "none", "decode", "burst", "contention" }).contains(options.load);
+}
+
+qreal
+cputime()
+{
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+void
+work(AVClock* clock, quint64 nanos)
+{
+    quint64 end = clock->now() + nanos;
+    while (clock->now() < end) { // busy like a decode, not a sleep
+    }
+}
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parse(argc, argv, options)) {
+        std::cerr << "usage: pacing [--fps 23.976] [--duration 60] [--load none|decode|burst|contention] "
+                  << "[--mode sleep|spin|yield] [--margin usecs] [--late usecs] [--realtime none|fifo|rr] [--cpu n]"
+                  << std::endl;
+        return 1;
+    }
+    AVClock* clock = AVClock::system();
+    quint64 period = static_cast<quint64>(1e9 * options.fps.seconds());
+    QAtomicInt running(1);
+    QList<QThread*> threads;
+    if (options.load == "contention") { // every core busy, the pacing thread competes with them
+        // started before the realtime profile is applied, threads inherit the policy and affinity of their creator
+        for (int i = 0; i < QThread::idealThreadCount(); i++) {
+            QThread* thread = QThread::create([&running]() {
+                while (running.loadRelaxed()) {
+                    qYieldCpu();
+                }
+            });
+            thread->start();
+            threads.append(thread);
+        }
+    }
+
+    AVRealtime realtime;
+    if (options.policy != AVRealtime::DEFAULT || options.cpu >= 0) {
+        realtime.set_policy(options.policy);
+        realtime.set_period(period);
+        if (options.cpu >= 0) {
+            realtime.set_cpus({ options.cpu });
+        }
+        realtime.set_lock_memory(true);
+        realtime.apply();
+    }
+    else {
+        QThread::currentThread()->setPriority(QThread::TimeCriticalPriority);
+    }
+    qint64 frames = static_cast<qint64>(options.duration / options.fps.seconds());
+
+    QRandomGenerator random(1);
+    AVTimer timer;
+    timer.set_mode(options.mode);
+    timer.set_margin(options.margin);
+    qint64 dropped = 0;
+    qint64 late = 0;
+    qreal cpu = cputime();
+    quint64 start = clock->now();
+    timer.start(options.fps);
+    for (qint64 frame = 0; frame < frames; frame++) {
+        if (options.load == "decode" || options.load == "burst") {
+            quint64 decode = period * random.bounded(10, 90) / 100;
+            if (options.load == "burst" && frame % 100 == 99) {
+                decode += period * 2; // a slow frame every 100, forces drops
+            }
+            work(clock, decode);
+        }
+        timer.wait();
+        if (static_cast<quint64>(qMax(timer.wake_error(), qint64(0))) > options.late) {
+            late++;
+        }
+        while (!timer.next(options.fps)) {
+            frame++;
+            dropped++;
+        }
+    }
+    qreal elapsed = (clock->now() - start) / 1e9;
+    cpu = cputime() - cpu;
+    running.storeRelaxed(0);
+    for (QThread* thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    AVHistogram histogram = timer.histogram();
+    auto usecs = [](quint64 nanos) { return nanos / 1000.0; };
+    std::cout << std::fixed << std::setprecision(3)
+              << "fps: " << options.fps.real() << ", duration: " << elapsed << " s, load: " << options.load.toStdString()
+              << ", mode: " << (options.mode == AVTimer::SLEEP ? "sleep" : options.mode == AVTimer::SPIN ? "spin" : "yield")
+              << ", margin: " << usecs(options.margin) << " us" << std::endl
+              << "frames: " << histogram.count() << ", late (> " << usecs(options.late) << " us): " << late
+              << ", dropped: " << dropped << std::endl
+              << "wake error us, p50: " << usecs(histogram.percentile(50.0))
+              << ", p99: " << usecs(histogram.percentile(99.0))
+              << ", p99.9: " << usecs(histogram.percentile(99.9))
+              << ", max: " << usecs(histogram.max())
+              << ", mean: " << histogram.mean() / 1000.0 << std::endl
+              << "cpu: " << cpu << " s, " << (cpu / elapsed) * 100 << "% of a core" << std::endl;
+    if (options.policy != AVRealtime::DEFAULT || options.cpu >= 0) {
+        for (const QString& message : realtime.report()) {
+            std::cout << "realtime " << message.toStdString() << std::endl;
+        }
+    }
+    return 0;
+}
@@ -28,6 +28,8 @@ class RhiWidgetPrivate : public QObject
         std::unique_ptr<QRhiSampler> texturesampler;
         std::unique_ptr<QRhiShaderResourceBindings> shaderresourcebindings;
         QImage texturedata;
+        QRhiTexture::Format textureformat = QRhiTexture::RGBA8;
+        bool upload = false; // new frame, same texture
         QVector<float> vertexdata;
         QMatrix4x4 mvpdata;
         QPointer<RhiWidget> widget;
@@ -70,10 +72,45 @@ RhiWidgetPrivate::shader(const QString& name)
 void
 RhiWidgetPrivate::set_image(const QImage& image)
 {
-    rhi = nullptr;
-    texturedata = image;
-    if (texturedata.format() != QImage::Format_RGBA8888) {
-        texturedata = texturedata.convertToFormat(QImage::Format_RGBA8888);
+    QRhiTexture::Format format = QRhiTexture::RGBA8;
+    bool uploadable = true;
+    switch (image.format()) {
+        case QImage::Format_RGBA8888:
+        case QImage::Format_RGBX8888:
+            break;
+        case QImage::Format_ARGB32:
+        case QImage::Format_RGB32:
+            format = QRhiTexture::BGRA8; // bgra in memory, uploaded as decoded
+            break;
+        case QImage::Format_RGBA16FPx4:
+        case QImage::Format_RGBX16FPx4:
+            format = QRhiTexture::RGBA16F;
+            break;
+        case QImage::Format_RGBA32FPx4:
+        case QImage::Format_RGBX32FPx4:
+            format = QRhiTexture::RGBA32F;
+            break;
+        default:
+            uploadable = false;
+            break;
+    }
+    QRhi* current = widget->rhi(); // null before the first initialize
+    if (uploadable && current && !current->isTextureFormatSupported(format)) {
+        uploadable = false;
+    }
+    if (uploadable) {
+        texturedata = image;
+    }
+    else {
+        texturedata = image.convertToFormat(QImage::Format_RGBA8888); // readers convert these off the ui thread, see formats()
+        format = QRhiTexture::RGBA8;
+    }
+    if (!texturebuffer || texturebuffer->pixelSize() != texturedata.size() || textureformat != format) {
+        rhi = nullptr; // resources are recreated on the next render
+        textureformat = format;
+    }
+    else {
+        upload = true;
     }
     float aspect = static_cast<float>(image.width()) / static_cast<float>(image.height());
     vertexdata = {
@@ -122,6 +159,15 @@ RhiWidget::set_image(const QImage& image)
     p->set_image(image);
 }
 
+QList<QImage::Format>
+RhiWidget::formats()
+{
+    return {
+        QImage::Format_RGBA8888, QImage::Format_RGBX8888, QImage::Format_ARGB32, QImage::Format_RGB32,
+        QImage::Format_RGBA16FPx4, QImage::Format_RGBX16FPx4, QImage::Format_RGBA32FPx4, QImage::Format_RGBX32FPx4
+    };
+}
+
 void
 RhiWidget::initialize(QRhiCommandBuffer* cb)
 {
@@ -177,7 +223,7 @@ RhiWidget::initialize(QRhiCommandBuffer* cb)
     }
     
     p->texturebuffer.reset(p->rhi->newTexture(
-        QRhiTexture::RGBA8,
+        p->textureformat,
         p->texturedata.size(),
         1) // no multi-sampling
     );
@@ -245,6 +291,7 @@ RhiWidget::initialize(QRhiCommandBuffer* cb)
     resourceUpdates->uploadStaticBuffer(p->vertexbuffer.get(), p->vertexdata.data());
     resourceUpdates->uploadTexture(p->texturebuffer.get(), p->texturedata);
     cb->resourceUpdate(resourceUpdates);
+    p->upload = false;
 
     const QSize size = renderTarget()->pixelSize();
     p->mvpdata = p->rhi->clipSpaceCorrMatrix();
@@ -268,6 +315,10 @@ RhiWidget::render(QRhiCommandBuffer* cb)
         sizeof(float) * 4 * 4, // size of 4x4 matrix
         p->mvpdata.constData()
     );
+    if (p->upload) {
+        resourceUpdates->uploadTexture(p->texturebuffer.get(), p->texturedata);
+        p->upload = false;
+    }
     
     cb->beginPass(
         renderTarget(),
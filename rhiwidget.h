@@ -15,6 +15,7 @@ class RhiWidget : public QRhiWidget
         RhiWidget(QWidget* parent = nullptr);
         virtual ~RhiWidget();
         void set_image(const QImage& image);
+        static QList<QImage::Format> formats(); // uploaded without a conversion on the ui thread
     
     protected:
         void initialize(QRhiCommandBuffer* cb) override;
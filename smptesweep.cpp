@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avfps.h"
+#include "avrate.h"
+#include "avsmptetime.h"
+#include "avtime.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QThread>
+#include <QtConcurrent>
+
+#include <QDebug>
+
+#include <cmath>
+
+// sweeps every frame of a 24 hour day for each standard rate, drop and non drop, and checks conversions,
+// the incremental counter, formatting and parsing against a corrected version of calculate_timecode in test.py
+
+struct Timecode
+{
+    qint64 hours = 0;
+    qint64 minutes = 0;
+    qint64 seconds = 0;
+    qint64 frames = 0;
+};
+
+struct Sweep
+{
+    AVFps fps;
+    qint64 start = 0;
+    qint64 end = 0;
+    qint64 mismatches = 0;
+    QList<QString> messages;
+};
+
+constexpr qsizetype max_messages = 8;
+
+qint64
+frames_per_day(const AVFps& fps)
+{
+    qint64 framequanta = std::lround(static_cast<double>(fps.numerator()) / fps.denominator());
+    qint64 dropframes = fps.drop_frame() ? std::lround(framequanta * 0.066666) : 0;
+    return (framequanta * 60 * 10 - 9 * dropframes) * 6 * 24;
+}
+
+Timecode
+calculate_timecode(qint64 frame, const AVFps& fps)
+{
+    // corrected from test.py, which as written is wrong for every drop frame rate and cannot serve as the
+    // reference: it counts a minute as round(rate * 60) - drops, 1796 frames at 29.97 and 3592 at 59.94
+    // where the drop frame layout has 1798 and 3596, and adds drops * d instead of drops * 9 * d in the
+    // first frames of a ten minute block. here every count comes from the nominal rate, frame quanta
+    // labels a second and drops labels are skipped each minute except every tenth, following smpte 12m
+    // and not the converter under test. test.py also drops labels at integral rates, the non drop path
+    // here does not
+    qint64 framequanta = std::lround(static_cast<double>(fps.numerator()) / fps.denominator());
+    qint64 dropframes = fps.drop_frame() ? std::lround(framequanta * 0.066666) : 0;
+    qint64 framesday = frames_per_day(fps);
+    qint64 frames10minutes = framequanta * 60 * 10 - 9 * dropframes;
+    qint64 framesminute = framequanta * 60 - dropframes;
+
+    frame = ((frame % framesday) + framesday) % framesday;
+    qint64 d = frame / frames10minutes;
+    qint64 m = frame % frames10minutes;
+    if (m > dropframes) {
+        frame += dropframes * 9 * d + dropframes * ((m - dropframes) / framesminute);
+    }
+    else {
+        frame += dropframes * 9 * d;
+    }
+    Timecode timecode;
+    timecode.frames = frame % framequanta;
+    timecode.seconds = (frame / framequanta) % 60;
+    timecode.minutes = (frame / framequanta / 60) % 60;
+    timecode.hours = frame / framequanta / 60 / 60;
+    return timecode;
+}
+
+QString
+to_string(const Timecode& timecode, bool dropframe)
+{
+    return QString("%1:%2:%3%4%5")
+        .arg(timecode.hours, 2, 10, QChar('0'))
+        .arg(timecode.minutes, 2, 10, QChar('0'))
+        .arg(timecode.seconds, 2, 10, QChar('0'))
+        .arg(dropframe ? "." : ":")
+        .arg(timecode.frames, 2, 10, QChar('0'));
+}
+
+void
+sweep(Sweep& sweep)
+{
+    const AVFps& fps = sweep.fps;
+    qint64 framequanta = fps.frame_quanta();
+    auto mismatch = [&](qint64 frame, const char* check, const QString& expected, const QString& actual) {
+        if (sweep.messages.size() < max_messages) {
+            sweep.messages.append(QString("%1 frame %2 %3: expected %4, got %5")
+                .arg(fps.real(), 0, 'f', 3).arg(frame).arg(check).arg(expected).arg(actual));
+        }
+        sweep.mismatches++;
+    };
+    char buffer[AVSmpteTime::max_chars];
+    AVSmpteTime counter(AVTime(sweep.start, fps));
+    for (qint64 frame = sweep.start; frame < sweep.end; frame++, ++counter) {
+        Timecode timecode = calculate_timecode(frame, fps);
+        qint64 expected = ((timecode.hours * 60 + timecode.minutes) * 60 + timecode.seconds) * framequanta + timecode.frames;
+        qint64 label = AVSmpteTime::convert(frame, fps, true);
+        if (label != expected) {
+            mismatch(frame, "frame to label", QString::number(expected), QString::number(label));
+        }
+        qint64 reverse = AVSmpteTime::convert(label, fps, false);
+        if (reverse != frame) {
+            mismatch(frame, "label to frame", QString::number(frame), QString::number(reverse));
+        }
+        QByteArray text = to_string(timecode, fps.drop_frame()).toLatin1();
+        QByteArrayView chars(buffer, AVSmpteTime::to_chars(AVTime(frame, fps), buffer, sizeof(buffer)));
+        if (chars.compare(text) != 0) {
+            mismatch(frame, "to_chars", QString::fromLatin1(text), QString::fromLatin1(chars.data(), chars.size()));
+        }
+        chars = QByteArrayView(buffer, counter.to_chars(buffer, sizeof(buffer)));
+        if (chars.compare(text) != 0) {
+            mismatch(frame, "counter", QString::fromLatin1(text), QString::fromLatin1(chars.data(), chars.size()));
+        }
+        qint64 parsed = -1;
+        if (!AVSmpteTime::parse(text, fps, parsed) || parsed != frame) {
+            mismatch(frame, "parse", QString::number(frame), QString::number(parsed));
+        }
+        if (framequanta <= 30) {
+            AVSmpteWord word(frame, fps);
+            if (word.hours() != timecode.hours || word.minutes() != timecode.minutes ||
+                word.seconds() != timecode.seconds || word.frames() != timecode.frames) {
+                mismatch(frame, "word", QString::fromLatin1(text), word.to_string());
+            }
+        }
+    }
+}
+
+int
+main(int argc, char* argv[])
+{
+    Q_UNUSED(argc);
+    Q_UNUSED(argv);
+
+    QList<AVFps> rates;
+    for (const AVFps& fps : AVRates::standards) {
+        rates.append(fps);
+        if (fps.numerator() % fps.denominator()) { // fractional rates in both drop and non drop frame
+            rates.append(AVFps(fps.numerator(), fps.denominator(), !fps.drop_frame()));
+        }
+    }
+    QList<Sweep> sweeps;
+    for (const AVFps& fps : rates) {
+        qint64 framesday = frames_per_day(fps);
+        qint64 framesminute = fps.frame_quanta() * 60;
+        for (qint64 start = 0; start < framesday; start += framesminute * 10) { // ten minute blocks across cores
+            Sweep block;
+            block.fps = fps;
+            block.start = start;
+            block.end = qMin(start + framesminute * 10, framesday);
+            sweeps.append(block);
+        }
+    }
+    qDebug() << "smpte sweep:" << rates.size() << "rates," << sweeps.size() << "blocks," << QThread::idealThreadCount() << "threads";
+
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::blockingMap(sweeps, [](Sweep& block) { sweep(block); });
+    qreal elapsed = timer.nsecsElapsed() / 1e9;
+
+    qint64 total = 0;
+    qint64 mismatches = 0;
+    for (const AVFps& fps : rates) {
+        qint64 frames = 0;
+        qint64 failed = 0;
+        for (const Sweep& block : sweeps) {
+            if (block.fps == fps) {
+                frames += block.end - block.start;
+                failed += block.mismatches;
+                for (const QString& message : block.messages) {
+                    qWarning() << "mismatch:" << message;
+                }
+            }
+        }
+        qDebug() << "rate:" << QString::number(fps.real(), 'f', 3) << (fps.drop_frame() ? "df" : "ndf") << frames << "frames," << failed << "mismatches";
+        total += frames;
+        mismatches += failed;
+    }
+    qDebug() << "total:" << total << "frames," << mismatches << "mismatches," << elapsed << "seconds,"
+             << qint64(total / elapsed) << "frames/sec";
+    return mismatches ? 1 : 0;
+}
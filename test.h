@@ -3,8 +3,5 @@
 
 #pragma once
 
-void test_time();
-void test_timerange();
-void test_fps();
-void test_smpte();
 void test_timer();
+void test_timer_wake();
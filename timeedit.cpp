@@ -126,7 +126,8 @@ Timeedit::paintEvent(QPaintEvent* event)
         painter.drawText(textRect, Qt::AlignCenter, p->d.time.to_string());
     }
     else if (p->d.timecode == Timeedit::Timecode::SMPTE) {
-        painter.drawText(textRect, Qt::AlignCenter, AVSmpteTime(p->d.time).to_string());
+        char buffer[AVSmpteTime::max_chars];
+        painter.drawText(textRect, Qt::AlignCenter, QString::fromLatin1(buffer, AVSmpteTime::to_chars(p->d.time, buffer, sizeof(buffer))));
     }
     if (p->d.focused) {
         painter.setPen(QPen(highlightColor, 4));
@@ -22,6 +22,8 @@ class TimelinePrivate
         QString labeltick(qint64 ticks) const;
         QSize labelsize(const QFont& font, qint64 ticks) const;
         qint64 ticks(qreal value) const;
+        qint64 align(qint64 ticks) const;
+        qint64 next(qint64 ticks) const;
         qint64 steps(qint64 value);
         qint64 substeps(qint64 steps) const;
         qint64 substeps(qint64 value, qint64 max, qint64 steps, int width) const;
@@ -43,6 +45,7 @@ class TimelinePrivate
         {
             AVTime time;
             AVTimeRange range;
+            AVTimestamps timestamps; // variable frame rates, empty otherwise
             Timeline::Timecode timecode = Timeline::Timecode::TIME;
             qint64 lasttick = -1;
             qreal margintick = 0.5;
@@ -107,13 +110,14 @@ QString
 TimelinePrivate::labeltick(qint64 value) const
 {
     if (d.timecode == Timeline::Timecode::FRAMES)  {
-        return QString::number(d.time.frame(value));
+        return QString::number(d.timestamps.valid() ? d.timestamps.frame(value) : d.time.frame(value));
     }
     else if (d.timecode == Timeline::Timecode::TIME) {
         return d.range.duration().to_string(value);
     }
     else if (d.timecode == Timeline::Timecode::SMPTE) {
-        return AVSmpteTime(AVTime(d.range.duration(), value)).to_string();
+        char buffer[AVSmpteTime::max_chars];
+        return QString::fromLatin1(buffer, AVSmpteTime::to_chars(AVTime(d.range.duration(), value), buffer, sizeof(buffer)));
     }
 }
 
@@ -127,7 +131,7 @@ TimelinePrivate::labelsize(const QFont& font, qint64 value) const
         return mapToSize(font, d.range.duration().to_string(value));
     }
     else if (d.timecode == Timeline::Timecode::SMPTE) {
-        return mapToSize(font, AVSmpteTime(AVTime(d.range.duration(), value)).to_string());
+        return mapToSize(font, labeltick(value));
     }
 }
 
@@ -142,6 +146,24 @@ TimelinePrivate::ticks(qreal value) const
     }
 }
 
+qint64
+TimelinePrivate::align(qint64 ticks) const
+{
+    if (d.timestamps.valid()) {
+        return d.timestamps.align(ticks);
+    }
+    return d.time.align(ticks);
+}
+
+qint64
+TimelinePrivate::next(qint64 ticks) const
+{
+    if (d.timestamps.valid()) {
+        return d.timestamps.ticks(d.timestamps.frame(ticks) + 1);
+    }
+    return ticks + d.time.tpf();
+}
+
 qint64
 TimelinePrivate::steps(qint64 value) {
     return pow(10, qint64(log10(value)));
@@ -393,7 +415,7 @@ TimelinePrivate::paint()
             }
             else {
                 int pos = 0;
-                AVTime next = AVTime(d.time, ticks + d.time.tpf());
+                AVTime next = AVTime(d.time, this->next(ticks));
                 if (next.ticks() < duration) {
                     pos = mapToX(next.ticks());
                     p.setPen(QPen(Qt::darkRed, 2));
@@ -448,6 +470,12 @@ Timeline::time() const
     return p->d.time;
 }
 
+AVTimestamps
+Timeline::timestamps() const
+{
+    return p->d.timestamps;
+}
+
 bool
 Timeline::tracking() const
 {
@@ -479,6 +507,13 @@ Timeline::set_time(const AVTime& time)
     }
 }
 
+void
+Timeline::set_timestamps(const AVTimestamps& timestamps)
+{
+    p->d.timestamps = timestamps;
+    update();
+}
+
 void
 Timeline::set_tracking(bool tracking)
 {
@@ -523,7 +558,7 @@ void
 Timeline::mouseMoveEvent(QMouseEvent* event)
 {
     if (p->d.pressed) {
-        qint64 tick = p->d.time.align(p->mapToTicks(event->pos().x()));
+        qint64 tick = p->align(p->mapToTicks(event->pos().x()));
         if (p->d.lasttick != tick) {
             p->d.time.set_ticks(tick);
             slider_moved(p->d.time);
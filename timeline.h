@@ -6,6 +6,7 @@
 #include "avsmptetime.h"
 #include "avtime.h"
 #include "avtimerange.h"
+#include "avtimestamps.h"
 
 #include <QWidget>
 #include <QScopedPointer>
@@ -24,12 +25,14 @@ class Timeline : public QWidget
         QSize sizeHint() const override;
         AVTimeRange range() const;
         AVTime time() const;
+        AVTimestamps timestamps() const;
         bool tracking() const;
         Timecode timecode() const;
     
     public Q_SLOTS:
         void set_range(const AVTimeRange& range);
         void set_time(const AVTime& time);
+        void set_timestamps(const AVTimestamps& timestamps);
         void set_tracking(bool tracking);
         void set_timecode(Timeline::Timecode timecode);
     
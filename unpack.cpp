@@ -0,0 +1,177 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2022 - present Mikael Sundell.
+
+#include "avunpack.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QRandomGenerator>
+#include <QString>
+
+#include <iomanip>
+#include <iostream>
+
+// throughput of the 10-bit unpack kernels on one core, reported in GB/s of packed input, and of the
+// 10-bit 4:2:0 y'cbcr to argb32 kernels in milliseconds per frame, checked bit for bit against the
+// scalar reference
+//
+// usage: unpack [--width 4096] [--height 2160] [--frames 50] [--swap 0|1] [--packing a|b]
+
+struct Options
+{
+    qsizetype width = 4096;
+    qsizetype height = 2160;
+    int frames = 50;
+    bool swap = true; // dpx is usually big endian
+    AVUnpack::Packing packing = AVUnpack::METHOD_A;
+};
+
+bool
+parse(int argc, char* argv[], Options& options)
+{
+    for (int i = 1; i + 1 < argc; i += 2) {
+        QString key(argv[i]);
+        QString value(argv[i + 1]);
+        if (key == "--width") {
+            options.width = value.toLongLong();
+        }
+        else if (key == "--height") {
+            options.height = value.toLongLong();
+        }
+        else if (key == "--frames") {
+            options.frames = value.toInt();
+        }
+        else if (key == "--swap") {
+            options.swap = value.toInt() != 0;
+        }
+        else if (key == "--packing") {
+            if (value == "a") {
+                options.packing = AVUnpack::METHOD_A;
+            }
+            else if (value == "b") {
+                options.packing = AVUnpack::METHOD_B;
+            }
+            else {
+                return false;
+            }
+        }
+        else {
+            return false;
+        }
+    }
+    return (argc % 2) == 1 && options.width > 0 && options.height > 0 && options.frames > 0;
+}
+
+template<typename T>
+qreal
+run(const Options& options, const QList<quint32>& words, QList<T>& rgbx)
+{
+    QElapsedTimer timer;
+    timer.start();
+    for (int frame = 0; frame < options.frames; frame++) {
+        for (qsizetype row = 0; row < options.height; row++) { // per line as a reader with line padding would
+            AVUnpack::unpack10(words.constData() + row * options.width, options.width, options.packing, options.swap,
+                               rgbx.data() + row * options.width * 4);
+        }
+    }
+    qreal seconds = timer.nsecsElapsed() / 1e9;
+    return (words.size() * sizeof(quint32) * static_cast<qreal>(options.frames)) / seconds / 1e9;
+}
+
+qreal
+run(const Options& options, const QList<quint16>& planes, const AVUnpack::Yuv& yuv, QList<quint32>& argb)
+{
+    const quint16* luma = planes.constData();
+    const quint16* cb = luma + options.width * options.height;
+    const quint16* cr = cb + options.width / 2 * options.height / 2;
+    QElapsedTimer timer;
+    timer.start();
+    for (int frame = 0; frame < options.frames; frame++) {
+        for (qsizetype row = 0; row < options.height; row++) {
+            qsizetype chroma = row / 2 * options.width / 2;
+            AVUnpack::yuv_argb32(luma + row * options.width, cb + chroma, cr + chroma, options.width, yuv,
+                                 argb.data() + row * options.width);
+        }
+    }
+    return timer.nsecsElapsed() / 1e6 / options.frames;
+}
+
+int
+main(int argc, char* argv[])
+{
+    Options options;
+    if (!parse(argc, argv, options)) {
+        std::cerr << "usage: unpack [--width 4096] [--height 2160] [--frames 50] [--swap 0|1] [--packing a|b]" << std::endl;
+        return 1;
+    }
+    QList<quint32> words(options.width * options.height);
+    QRandomGenerator random(1);
+    for (quint32& word : words) {
+        word = random.generate();
+    }
+    QList<quint16> expected(words.size() * 4);
+    QList<float> expectedf(words.size() * 4);
+    AVUnpack::unpack10_scalar(words.constData(), words.size(), options.packing, options.swap, expected.data());
+    AVUnpack::unpack10_scalar(words.constData(), words.size(), options.packing, options.swap, expectedf.data());
+
+    std::cout << "resolution: " << options.width << "x" << options.height << ", frames: " << options.frames
+              << ", packing: " << (options.packing == AVUnpack::METHOD_A ? "a" : "b") << ", swap: " << options.swap
+              << std::endl;
+    std::cout << std::left << std::setw(10) << "kernel" << std::right << std::setw(14) << "uint16 GB/s" << std::setw(14)
+              << "float GB/s" << std::setw(10) << "speedup" << std::setw(8) << "exact" << std::endl;
+    qreal scalar = 0.0;
+    bool exact = true;
+    for (AVUnpack::Kernel kernel : { AVUnpack::SCALAR, AVUnpack::SSE41, AVUnpack::AVX2, AVUnpack::NEON }) {
+        if (!AVUnpack::supported(kernel)) {
+            continue;
+        }
+        AVUnpack::set_kernel(kernel);
+        QList<quint16> rgbx(words.size() * 4);
+        QList<float> rgbxf(words.size() * 4);
+        qreal bandwidth = run(options, words, rgbx);
+        qreal bandwidthf = run(options, words, rgbxf);
+        if (kernel == AVUnpack::SCALAR) {
+            scalar = bandwidth;
+        }
+        bool match = rgbx == expected && rgbxf == expectedf;
+        exact = exact && match;
+        std::cout << std::fixed << std::setprecision(2) << std::left << std::setw(10) << AVUnpack::name(kernel)
+                  << std::right << std::setw(14) << bandwidth << std::setw(14) << bandwidthf << std::setw(9)
+                  << bandwidth / scalar << "x" << std::setw(8) << (match ? "yes" : "no") << std::endl;
+    }
+
+    QList<quint16> planes(options.width * options.height * 3 / 2 + options.width); // 10-bit 4:2:0 as in y4m, odd sizes padded
+    for (quint16& sample : planes) {
+        sample = static_cast<quint16>(random.bounded(1024));
+    }
+    AVUnpack::Yuv yuv; // bt.709 limited range
+    yuv.shift = 2;
+    yuv.cy = qRound(255.0 / 219.0 * 16384);
+    yuv.crr = qRound(1.5748 * 255.0 / 224.0 * 16384);
+    yuv.cgb = qRound(0.187324 * 255.0 / 224.0 * 16384);
+    yuv.cgr = qRound(0.468124 * 255.0 / 224.0 * 16384);
+    yuv.cbb = qRound(1.8556 * 255.0 / 224.0 * 16384);
+    QList<quint32> expectedargb(options.width * options.height);
+    AVUnpack::set_kernel(AVUnpack::SCALAR);
+    run(Options { options.width, options.height, 1, options.swap, options.packing }, planes, yuv, expectedargb);
+    std::cout << std::left << std::setw(10) << "kernel" << std::right << std::setw(14) << "yuv ms/frame"
+              << std::setw(10) << "speedup" << std::setw(8) << "exact" << std::endl;
+    qreal scalarms = 0.0;
+    for (AVUnpack::Kernel kernel : { AVUnpack::SCALAR, AVUnpack::SSE41, AVUnpack::AVX2, AVUnpack::NEON }) {
+        if (!AVUnpack::supported(kernel)) {
+            continue;
+        }
+        AVUnpack::set_kernel(kernel);
+        QList<quint32> argb(options.width * options.height);
+        qreal ms = run(options, planes, yuv, argb);
+        if (kernel == AVUnpack::SCALAR) {
+            scalarms = ms;
+        }
+        bool match = argb == expectedargb;
+        exact = exact && match;
+        std::cout << std::fixed << std::setprecision(2) << std::left << std::setw(10) << AVUnpack::name(kernel)
+                  << std::right << std::setw(14) << ms << std::setw(9) << scalarms / ms << "x" << std::setw(8)
+                  << (match ? "yes" : "no") << std::endl;
+    }
+    return exact ? 0 : 1;
+}